@@ -38,9 +38,9 @@ if defined VS80COMNTOOLS (call "%VS80COMNTOOLS%\vsvars32.bat") else ^
 goto noCompiler
 )
 
-set SRC=fmusim_cs\main.c ..\shared\xmlVersionParser.c ..\shared\xml_parser.c ..\shared\stack.c ..\shared\sim_support.c
+set SRC=fmusim_cs\main.c ..\shared\xmlVersionParser.c ..\shared\xml_parser.c ..\shared\stack.c ..\shared\sim_support.c ..\shared\zip_reader.c ..\shared\unpack_cache.c
 set INC=/Iinclude /I../shared /Ifmusim_cs
-set OPTIONS=/DSTANDALONE_XML_PARSER /nologo /DFMI_COSIMULATION /DLIBXML_STATIC
+set OPTIONS=/DSTANDALONE_XML_PARSER /nologo /DFMI_COSIMULATION
 
 rem create fmusim_cs.exe in the fmusim_cs dir
 pushd co_simulation
@@ -38,9 +38,9 @@ if defined VS80COMNTOOLS (call "%VS80COMNTOOLS%\vsvars32.bat") else ^
 goto noCompiler
 )
 
-set SRC=fmusim_me\main.c ..\shared\xmlVersionParser.c ..\shared\xml_parser.c ..\shared\stack.c ..\shared\sim_support.c
+set SRC=fmusim_me\main.c ..\shared\xmlVersionParser.c ..\shared\xml_parser.c ..\shared\stack.c ..\shared\sim_support.c ..\shared\zip_reader.c ..\shared\unpack_cache.c
 set INC=/Iinclude /I../shared /Ifmusim_me
-set OPTIONS=/nologo /DSTANDALONE_XML_PARSER /DLIBXML_STATIC
+set OPTIONS=/nologo /DSTANDALONE_XML_PARSER
 
 rem create fmusim_me.exe in the fmusim_me dir
 pushd model_exchange
@@ -19,6 +19,8 @@
 #endif
 
 #include "xmlVersionParser.h"
+#include "zip_reader.h"
+#include "unpack_cache.h"
 #include "sim_support.h"
 
 #if !WINDOWS
@@ -27,10 +29,45 @@
 #include <dlfcn.h> //dlsym()
 #endif /* WINDOWS */
 
+#ifdef __linux__
+#include <errno.h>
+#include <sys/syscall.h>  // SYS_memfd_create
+#endif /* __linux__ */
+// true if the FMU binary can be loaded from an anonymous memory file
+#if defined(__linux__) && defined(SYS_memfd_create)
+#define MEMORY_FILES_SUPPORTED 1
+#else
+#define MEMORY_FILES_SUPPORTED 0
+#endif
+
 extern FMU fmu;
 
+// directory the FMU is unpacked to, with a trailing separator
+static char *unpackedPath = NULL;
+// true if unpackedPath is an entry of the unpack cache
+static int unpackedToCache = 0;
+
+// How loadFMU() unpacks the FMU, set by environment variable FMUSIM_UNPACK:
+// "full" (default) unzips the whole archive, "lazy" reads the model description
+// straight from the archive and extracts only the binary for this platform,
+// and the resources when the simulation asks for the FMU location.
+#define UNPACK_MODE_ENV "FMUSIM_UNPACK"
+#define UNPACK_FULL 0
+#define UNPACK_LAZY 1
+// "memory", on Linux only, is like "lazy" but loads the binary from a memfd
+// through /proc/self/fd, so that nothing is written to disk except the resources
+#define UNPACK_MEMORY 2
+
+// the FMU archive, kept open while unpacking lazily, NULL otherwise
+static ZipArchive *fmuArchive = NULL;
+static int resourcesExtracted = 0;
+// true if the FMU binary is loaded from memory
+static int unpackedToMemory = 0;
+// memfd holding the FMU binary, -1 unless unpacking to memory
+static int memoryFileFd = -1;
+
 #if WINDOWS
-int unzip(const char *zipPath, const char *outPath) {
+int unzipWithTool(const char *zipPath, const char *outPath) {
     int code;
     char binPath[BUFSIZE];
     int n = BUFSIZE + strlen(UNZIP_CMD) + strlen(outPath) + 3 +  strlen(zipPath) + 9;
@@ -70,7 +107,7 @@ int unzip(const char *zipPath, const char *outPath) {
 
 #else /* WINDOWS */
 
-int unzip(const char *zipPath, const char *outPath) {
+int unzipWithTool(const char *zipPath, const char *outPath) {
     int code;
     int n;
     char* cmd;
@@ -101,6 +138,22 @@ int unzip(const char *zipPath, const char *outPath) {
 }
 #endif /* WINDOWS */
 
+// Extracts the FMU with the built-in zip reader, without starting a process.
+// Falls back to the external tool for archives the reader cannot handle.
+int unzip(const char *zipPath, const char *outPath) {
+    int ok = 0;
+    ZipArchive *za = zipOpen(zipPath);
+    if (za) {
+        ok = zipExtractAll(za, outPath);
+        zipClose(za);
+    }
+    if (!ok) {
+        printf("retrying with %s\n", UNZIP_CMD);
+        ok = unzipWithTool(zipPath, outPath);
+    }
+    return ok;
+}
+
 #if WINDOWS
 // fileName is an absolute path, e.g. C:\test\a.fmu
 // or relative to the current dir, e.g. ..\test\a.fmu
@@ -144,11 +197,14 @@ static char* getTmpPath() {
 #endif /* WINDOWS */
 
 char *getTempFmuLocation() {
-    char *tempPath = getTmpPath();
-    char *fmuLocation = (char *)calloc(sizeof(char), 8 + strlen(tempPath));
+    char *fmuLocation;
+    // when unpacking lazily, the resources are extracted only now
+    if (fmuArchive && !resourcesExtracted) {
+        resourcesExtracted = zipExtractDir(fmuArchive, "resources/", unpackedPath);
+    }
+    fmuLocation = (char *)calloc(sizeof(char), 8 + strlen(unpackedPath));
     strcpy(fmuLocation, "file://");
-    strcat(fmuLocation, tempPath);
-    free(tempPath);
+    strcat(fmuLocation, unpackedPath);
     return fmuLocation;
 }
 
@@ -261,6 +317,113 @@ static void printModelDescription(ModelDescription* md){
 #endif // FMI_COSIMULATION  
 }
 
+static int checkVersion(char *xmlFmiVersion, const char *xmlPath);
+
+static int getUnpackMode() {
+    const char *mode = getenv(UNPACK_MODE_ENV);
+    if (!mode || !*mode || !strcmp(mode, "full")) return UNPACK_FULL;
+    if (!strcmp(mode, "lazy")) return UNPACK_LAZY;
+    if (!strcmp(mode, "memory")) {
+        if (MEMORY_FILES_SUPPORTED) return UNPACK_MEMORY;
+        printf("warning: %s=memory is only supported on Linux, unpacking lazily\n", UNPACK_MODE_ENV);
+        return UNPACK_LAZY;
+    }
+    printf("warning: Unknown %s=%s, unpacking the full FMU\n", UNPACK_MODE_ENV, mode);
+    return UNPACK_FULL;
+}
+
+// Returns the entry of fmuArchive at path, which may use '\\' as separator
+// like DLL_DIR on Windows, NULL if not found
+static const ZipEntry *findArchiveEntry(const char *path) {
+    const ZipEntry *entry;
+    char *p;
+    char *name = strdup(path);
+    for (p = name; *p; p++) {
+        if (*p == '\\') *p = '/';
+    }
+    entry = zipFindEntry(fmuArchive, name);
+    if (!entry) printf("error: %s not found in the FMU\n", name);
+    free(name);
+    return entry;
+}
+
+// Extracts the file at path, relative to the FMU root, from fmuArchive to unpackedPath.
+// Returns 0 to indicate failure.
+static int extractFromArchive(const char *path) {
+    const ZipEntry *entry = findArchiveEntry(path);
+    return entry && zipExtractEntry(fmuArchive, entry, unpackedPath);
+}
+
+#if MEMORY_FILES_SUPPORTED
+// Returns a path for unpackedPath that is not created unless the FMU has
+// resources, so that loading from memory leaves no empty dirs behind
+static char *getMemoryTmpPath() {
+    char *tmpPath = (char *)calloc(sizeof(char), 32);
+    sprintf(tmpPath, "fmuMem%d/", (int)getpid());
+    return tmpPath;
+}
+
+// Inflates the file at path, relative to the FMU root, from fmuArchive into
+// a memfd. Returns the path of the memfd below /proc/self/fd, to be passed to
+// dlopen(). Returns NULL to indicate failure.
+static char *extractToMemoryFile(const char *path) {
+    size_t size;
+    size_t written = 0;
+    char *data;
+    char *fdPath;
+    const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    const ZipEntry *entry = findArchiveEntry(path);
+    if (!entry) return NULL;
+    data = (char *)zipExtractToMemory(fmuArchive, entry, &size);
+    if (!data) return NULL;
+    memoryFileFd = (int)syscall(SYS_memfd_create, name, 0);
+    if (memoryFileFd < 0) {
+        printf("error: Could not create memory file for %s: %s\n", path, strerror(errno));
+        free(data);
+        return NULL;
+    }
+    while (written < size) {
+        ssize_t n = write(memoryFileFd, data + written, size - written);
+        if (n <= 0) break;
+        written += n;
+    }
+    free(data);
+    if (written < size) {
+        printf("error: Could not write memory file for %s\n", path);
+        return NULL;
+    }
+    fdPath = (char *)calloc(sizeof(char), 32);
+    sprintf(fdPath, "/proc/self/fd/%d", memoryFileFd);
+    return fdPath;
+}
+#else /* MEMORY_FILES_SUPPORTED */
+static char *getMemoryTmpPath() {
+    return NULL;
+}
+
+static char *extractToMemoryFile(const char *path) {
+    return NULL;
+}
+#endif /* MEMORY_FILES_SUPPORTED */
+
+// Parses the model description in fmuArchive without extracting it.
+// Returns NULL to indicate failure.
+static ModelDescription *parseFromArchive() {
+    ModelDescription *md = NULL;
+    size_t size;
+    char *xml;
+    const ZipEntry *entry = findArchiveEntry(XML_FILE);
+    if (!entry) return NULL;
+    xml = (char *)zipExtractToMemory(fmuArchive, entry, &size);
+    if (!xml) return NULL;
+    // check FMI version of the FMU to match current simulator version
+    if (checkVersion(extractVersionFromMemory(xml, (int)size, XML_FILE), XML_FILE)) {
+        md = parseFromMemory(XML_FILE, xml, (int)size);
+    }
+    free(xml);
+    return md;
+}
+
 void loadFMU(const char* fmuFileName) {
     char* fmuPath;
     char* tmpPath;
@@ -271,27 +434,36 @@ void loadFMU(const char* fmuFileName) {
     fmuPath = getFmuPath(fmuFileName);
     if (!fmuPath) exit(EXIT_FAILURE);
 
-    // unzip the FMU to the tmpPath directory
-    tmpPath = getTmpPath();
-    if (!unzip(fmuPath, tmpPath)) exit(EXIT_FAILURE);
-
-    // parse tmpPath\modelDescription.xml
-    xmlPath = calloc(sizeof(char), strlen(tmpPath) + strlen(XML_FILE) + 1);
-    sprintf(xmlPath, "%s%s", tmpPath, XML_FILE);
-
-    // parse tmpPath\modelDescription.xml
-    xmlPath = calloc(sizeof(char), strlen(tmpPath) + strlen(XML_FILE) + 1);
-    sprintf(xmlPath, "%s%s", tmpPath, XML_FILE);
-    // check FMI version of the FMU to match current simulator version
-    if (!checkFmiVersion(xmlPath)) {
+    // reuse the FMU unpacked by an earlier run, if the unpack cache is enabled,
+    // else unzip the FMU to the tmpPath directory, or open it for lazy unpacking
+    tmpPath = unpackToCache(fmuPath);
+    if (tmpPath) {
+        unpackedToCache = 1;
+    } else {
+        int unpackMode = getUnpackMode();
+        if (unpackMode != UNPACK_FULL) fmuArchive = zipOpen(fmuPath);
+        unpackedToMemory = fmuArchive && unpackMode == UNPACK_MEMORY;
+        tmpPath = unpackedToMemory ? getMemoryTmpPath() : getTmpPath();
+        if (!fmuArchive && !unzip(fmuPath, tmpPath)) exit(EXIT_FAILURE);
+    }
+    unpackedPath = strdup(tmpPath);
+
+    if (fmuArchive) {
+        fmu.modelDescription = parseFromArchive();
+    } else {
+        // parse tmpPath\modelDescription.xml
+        xmlPath = calloc(sizeof(char), strlen(tmpPath) + strlen(XML_FILE) + 1);
+        sprintf(xmlPath, "%s%s", tmpPath, XML_FILE);
+        // check FMI version of the FMU to match current simulator version
+        if (!checkFmiVersion(xmlPath)) {
+            free(xmlPath);
+            free(fmuPath);
+            free(tmpPath);
+            exit(EXIT_FAILURE);
+        }
+        fmu.modelDescription = parse(xmlPath);
         free(xmlPath);
-        free(fmuPath);
-        free(tmpPath);
-        exit(EXIT_FAILURE);
     }
-
-    fmu.modelDescription = parse(xmlPath);
-    free(xmlPath);
     if (!fmu.modelDescription) exit(EXIT_FAILURE);
     printModelDescription(fmu.modelDescription);
 
@@ -299,7 +471,17 @@ void loadFMU(const char* fmuFileName) {
     dllPath = calloc(sizeof(char), strlen(tmpPath) + strlen(DLL_DIR)
             + strlen( getModelIdentifier(fmu.modelDescription)) +  strlen(DLL_SUFFIX) + 1);
     sprintf(dllPath,"%s%s%s%s", tmpPath, DLL_DIR, getModelIdentifier(fmu.modelDescription), DLL_SUFFIX);
-    if (!loadDll(dllPath, &fmu)) {
+    if (unpackedToMemory) {
+        // load the binary from memory instead of a file below tmpPath
+        char *memoryPath = extractToMemoryFile(dllPath + strlen(tmpPath));
+        free(dllPath);
+        dllPath = memoryPath;
+    } else if (fmuArchive && !extractFromArchive(dllPath + strlen(tmpPath))) {
+        // when unpacking lazily, extract only the binary for this platform
+        free(dllPath);
+        dllPath = NULL;
+    }
+    if (!dllPath || !loadDll(dllPath, &fmu)) {
         free(dllPath);
         free(fmuPath);
         free(tmpPath);
@@ -310,8 +492,8 @@ void loadFMU(const char* fmuFileName) {
     free(tmpPath);
 }
 
-int checkFmiVersion(const char *xmlPath) {
-    char *xmlFmiVersion = extractVersion(xmlPath);
+// Checks and frees the xmlFmiVersion read from xmlPath
+static int checkVersion(char *xmlFmiVersion, const char *xmlPath) {
     if (xmlFmiVersion == NULL) {
         printf("The FMI version of the FMU could not be read: %s", xmlPath);
         return 0;
@@ -324,17 +506,40 @@ int checkFmiVersion(const char *xmlPath) {
     return 0;
 }
 
+int checkFmiVersion(const char *xmlPath) {
+    return checkVersion(extractVersion(xmlPath), xmlPath);
+}
+
 void deleteUnzippedFiles() {
-    char *fmuTempPath = getTmpPath();
-    char *cmd = (char *)calloc(15 + strlen(fmuTempPath), sizeof(char));
+    char *cmd;
+    if (fmuArchive) {
+        zipClose(fmuArchive);
+        fmuArchive = NULL;
+    }
+#if MEMORY_FILES_SUPPORTED
+    if (memoryFileFd >= 0) {
+        close(memoryFileFd);
+        memoryFileFd = -1;
+    }
+#endif /* MEMORY_FILES_SUPPORTED */
+    if (!unpackedPath) return;
+    if (unpackedToCache) {
+        // keep the files for the next run, just allow their eviction
+        releaseCachedFmu();
+        free(unpackedPath);
+        unpackedPath = NULL;
+        return;
+    }
+    cmd = (char *)calloc(15 + strlen(unpackedPath), sizeof(char));
 #if WINDOWS
-    sprintf(cmd, "rmdir /S /Q %s", fmuTempPath);
+    sprintf(cmd, "rmdir /S /Q %s", unpackedPath);
 #else /* WINDOWS */
-    sprintf(cmd, "rm -rf %s", fmuTempPath);
+    sprintf(cmd, "rm -rf %s", unpackedPath);
 #endif /* WINDOWS */
     system(cmd);
     free(cmd);
-    free(fmuTempPath);
+    free(unpackedPath);
+    unpackedPath = NULL;
 }
 
 static void doubleToCommaString(char* buffer, double r){
@@ -355,7 +560,7 @@ void outputRow(FMU *fmu, fmiComponent c, double time, FILE* file, char separator
     fmiBoolean b;
     fmiString s;
     fmiValueReference vr;
-    ScalarVariable** vars = fmu->modelDescription->modelVariables;
+    VariableTable* vt = fmu->modelDescription->variables;
     char buffer[32];
 
     // print first column
@@ -372,14 +577,13 @@ void outputRow(FMU *fmu, fmiComponent c, double time, FILE* file, char separator
     }
 
     // print all other columns(void *)
-    for (k=0; vars[k]; k++) {
-        ScalarVariable* sv = vars[k];
-        if (getAlias(sv)!=enu_noAlias) continue;
+    for (k=0; vt && k<vt->n; k++) {
+        if (vt->aliases[k]!=enu_noAlias) continue;
         if (header) {
             // output names only
             if (separator==',') {
                 // treat array element, e.g. print a[1, 2] as a[1.2]
-                const char* s = getName(sv);
+                const char* s = vt->names[k];
                 fprintf(file, "%c", separator);
                 while (*s) {
                    if (*s!=' ') fprintf(file, "%c", *s==',' ? '.' : *s);
@@ -387,12 +591,12 @@ void outputRow(FMU *fmu, fmiComponent c, double time, FILE* file, char separator
                 }
              }
             else
-                fprintf(file, "%c%s", separator, getName(sv));
+                fprintf(file, "%c%s", separator, vt->names[k]);
         }
         else {
             // output values
-            vr = getValueReference(sv);
-            switch (sv->typeSpec->type){
+            vr = vt->valueReferences[k];
+            switch (vt->types[k]){
                 case elm_Real:
                     fmu->getReal(c, &vr, 1, &r);
                     if (separator==',') 
@@ -417,7 +621,7 @@ void outputRow(FMU *fmu, fmiComponent c, double time, FILE* file, char separator
                     fprintf(file, "%c%s", separator, s);
                     break;
                 default: 
-                    fprintf(file, "%cNoValueForType=%d", separator,sv->typeSpec->type);
+                    fprintf(file, "%cNoValueForType=%d", separator,vt->types[k]);
             }
         }
     } // for
@@ -440,13 +644,10 @@ static const char* fmiStatusToString(fmiStatus status){
     }
 }
 
-// search a fmu for the given variable
+// search a fmu for the given variable, i means integer or enumeration
 // return NULL if not found or vr = fmiUndefinedValueReference
 static ScalarVariable* getSV(FMU* fmu, char type, fmiValueReference vr) {
-    int i;
     Elm tp;
-    ScalarVariable** vars = fmu->modelDescription->modelVariables;
-    if (vr==fmiUndefinedValueReference) return NULL;
     switch (type) {
         case 'r': tp = elm_Real;    break;
         case 'i': tp = elm_Integer; break;
@@ -454,12 +655,7 @@ static ScalarVariable* getSV(FMU* fmu, char type, fmiValueReference vr) {
         case 's': tp = elm_String;  break;
         default:  tp = elm_BAD_DEFINED; break;
     }
-    for (i=0; vars[i]; i++) {
-        ScalarVariable* sv = vars[i];
-        if (vr==getValueReference(sv) && tp==sv->typeSpec->type)
-            return sv;
-    }
-    return NULL;
+    return getVariable(fmu->modelDescription, vr, tp);
 }
 
 // replace e.g. #r1365# by variable name and ## by # in message
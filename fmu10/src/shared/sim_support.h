@@ -59,6 +59,7 @@
 
 void fmuLogger(fmiComponent c, fmiString instanceName, fmiStatus status, fmiString category, fmiString message, ...);
 int unzip(const char *zipPath, const char *outPath);
+int unzipWithTool(const char *zipPath, const char *outPath);
 void parseArguments(int argc, char *argv[], const char** fmuFileName, double* tEnd, double* h, int* loggingOn, char* csv_separator);
 void loadFMU(const char* fmuFileName);
 int checkFmiVersion(const char *xmlPath);
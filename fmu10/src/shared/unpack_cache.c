@@ -0,0 +1,386 @@
+/* -------------------------------------------------------------------------
+ * unpack_cache.c
+ * Persistent cache of unpacked FMUs, see unpack_cache.h.
+ *
+ * Layout of the cache directory, with <key> the 16 hex digits of the hash:
+ *   <key>/           the unpacked FMU, appears atomically by rename()
+ *   <key>.lock       flock()ed shared by every process using <key>/,
+ *                    exclusively while <key>/ is evicted
+ *   <key>.tmpXXXXXX  an FMU being unpacked
+ * The modification time of <key>/ is set on every use and serves as
+ * last access time for the eviction by age and for the LRU order.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unpack_cache.h"
+#include "zip_reader.h"
+
+#ifdef _WIN32
+
+char *unpackToCache(const char *fmuPath) {
+    return NULL; // not supported, the FMU is unpacked to the temp dir
+}
+
+void releaseCachedFmu() {
+}
+
+#else /* _WIN32 */
+
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define KEY_LEN 16
+#define DEFAULT_MAX_SIZE (1024.0 * 1024 * 1024)   // 1G
+#define DEFAULT_MAX_AGE  (30.0 * 24 * 3600)       // 30 days
+// tmp dirs left over from crashed processes are removed after this time
+#define STALE_TMP_AGE    3600
+
+typedef struct {
+    char key[KEY_LEN + 1];
+    time_t lastUse;
+    double size;
+} CacheEntry;
+
+static int lockFd = -1; // lock of the entry in use by this process
+
+// -------------------------------------------------------------------------
+// File system helpers
+
+static char *concat(const char *a, const char *b, const char *c) {
+    char *s = (char *)malloc(strlen(a) + strlen(b) + strlen(c) + 1);
+    if (s) sprintf(s, "%s%s%s", a, b, c);
+    return s;
+}
+
+// Creates path and its missing parent directories. Returns 0 to indicate failure.
+static int makeDirs(const char *path) {
+    int ok = 1;
+    char *p;
+    char *dir = strdup(path);
+    if (!dir) return 0;
+    for (p = dir + 1; ok && *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            ok = mkdir(dir, 0755) == 0 || errno == EEXIST;
+            *p = '/';
+        }
+    }
+    ok = ok && (mkdir(dir, 0755) == 0 || errno == EEXIST);
+    free(dir);
+    return ok;
+}
+
+// Removes path, with all its contents if it is a directory
+static void removeTree(const char *path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) return;
+    if (S_ISDIR(st.st_mode)) {
+        struct dirent *d;
+        DIR *dir = opendir(path);
+        if (dir) {
+            while ((d = readdir(dir)) != NULL) {
+                char *child;
+                if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, "..")) continue;
+                child = concat(path, "/", d->d_name);
+                if (child) removeTree(child);
+                free(child);
+            }
+            closedir(dir);
+        }
+        rmdir(path);
+    } else {
+        unlink(path);
+    }
+}
+
+// Returns the total size of the files below path
+static double treeSize(const char *path) {
+    struct stat st;
+    double size = 0;
+    if (lstat(path, &st) != 0) return 0;
+    if (S_ISDIR(st.st_mode)) {
+        struct dirent *d;
+        DIR *dir = opendir(path);
+        if (!dir) return 0;
+        while ((d = readdir(dir)) != NULL) {
+            char *child;
+            if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, "..")) continue;
+            child = concat(path, "/", d->d_name);
+            if (child) size += treeSize(child);
+            free(child);
+        }
+        closedir(dir);
+    } else {
+        size = (double)st.st_size;
+    }
+    return size;
+}
+
+static int isKey(const char *name) {
+    int i;
+    for (i = 0; i < KEY_LEN; i++) {
+        if (!((name[i] >= '0' && name[i] <= '9') || (name[i] >= 'a' && name[i] <= 'f'))) return 0;
+    }
+    return name[KEY_LEN] == '\0';
+}
+
+// -------------------------------------------------------------------------
+// Settings
+
+// Parses a size such as 1048576, 500K, 500M or 2G. Returns def if s is NULL or invalid.
+static double parseSize(const char *s, double def) {
+    char *end;
+    double v;
+    if (!s || !*s) return def;
+    v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; end++; break;
+        case 'm': case 'M': v *= 1024.0 * 1024; end++; break;
+        case 'g': case 'G': v *= 1024.0 * 1024 * 1024; end++; break;
+        case 't': case 'T': v *= 1024.0 * 1024 * 1024 * 1024; end++; break;
+    }
+    if (end == s || *end || v < 0) {
+        printf("warning: Ignoring invalid size %s\n", s);
+        return def;
+    }
+    return v;
+}
+
+// Parses a duration in seconds such as 3600, 90s, 30m, 12h or 7d. Returns def if s is NULL or invalid.
+static double parseAge(const char *s, double def) {
+    char *end;
+    double v;
+    if (!s || !*s) return def;
+    v = strtod(s, &end);
+    switch (*end) {
+        case 's': end++; break;
+        case 'm': v *= 60; end++; break;
+        case 'h': v *= 3600; end++; break;
+        case 'd': v *= 24 * 3600; end++; break;
+    }
+    if (end == s || *end || v < 0) {
+        printf("warning: Ignoring invalid duration %s\n", s);
+        return def;
+    }
+    return v;
+}
+
+// -------------------------------------------------------------------------
+// Key and locking
+
+// FNV-1a over the name, method, size and crc of every entry. The crc values
+// make the key depend on the contents, not on time stamps in the archive.
+static void computeKey(ZipArchive *za, char *key) {
+    int i;
+    unsigned long long h = 14695981039346656037ULL;
+    for (i = 0; i < zipGetEntryCount(za); i++) {
+        const ZipEntry *e = zipGetEntry(za, i);
+        unsigned long long fields[3];
+        const unsigned char *p;
+        size_t k;
+        fields[0] = e->method;
+        fields[1] = e->size;
+        fields[2] = e->crc32;
+        for (p = (const unsigned char *)e->name; *p; p++) h = (h ^ *p) * 1099511628211ULL;
+        h = (h ^ 0) * 1099511628211ULL; // terminates the name
+        for (k = 0; k < 3; k++) {
+            int b;
+            for (b = 0; b < 64; b += 8) h = (h ^ ((fields[k] >> b) & 0xFF)) * 1099511628211ULL;
+        }
+    }
+    sprintf(key, "%016llx", h);
+}
+
+// Opens and locks the lock file of an entry. Returns the file descriptor,
+// or -1 if blocking is 0 and the entry is locked by another process.
+// The lock file may be unlinked by an evicting process while we wait for
+// the lock, in which case we retry with the new lock file.
+static int lockEntry(const char *lockPath, int operation) {
+    for (;;) {
+        struct stat fdStat, pathStat;
+        int fd = open(lockPath, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return -1;
+        if (flock(fd, operation) != 0) {
+            close(fd);
+            return -1;
+        }
+        if (fstat(fd, &fdStat) == 0 && stat(lockPath, &pathStat) == 0
+                && fdStat.st_ino == pathStat.st_ino && fdStat.st_dev == pathStat.st_dev) {
+            return fd;
+        }
+        close(fd);
+    }
+}
+
+// -------------------------------------------------------------------------
+// Eviction
+
+static int compareLastUse(const void *a, const void *b) {
+    time_t ta = ((const CacheEntry *)a)->lastUse;
+    time_t tb = ((const CacheEntry *)b)->lastUse;
+    return ta < tb ? -1 : ta > tb;
+}
+
+// Removes the entry unless it is in use. Returns 0 if the entry is in use.
+static int evictEntry(const char *cacheDir, const char *key) {
+    char *entryPath = concat(cacheDir, "/", key);
+    char *lockPath = concat(entryPath, ".lock", "");
+    int fd = -1;
+    if (entryPath && lockPath) fd = lockEntry(lockPath, LOCK_EX | LOCK_NB);
+    if (fd >= 0) {
+        removeTree(entryPath);
+        unlink(lockPath); // while holding the lock, see lockEntry()
+        close(fd);
+    }
+    free(entryPath);
+    free(lockPath);
+    return fd >= 0;
+}
+
+// Evicts entries unused for longer than the maximum age, then the least
+// recently used entries until the cache fits the maximum size.
+// The entry 'current' is never evicted.
+static void evictEntries(const char *cacheDir, const char *current) {
+    double maxSize = parseSize(getenv(CACHE_MAX_SIZE_ENV), DEFAULT_MAX_SIZE);
+    double maxAge = parseAge(getenv(CACHE_MAX_AGE_ENV), DEFAULT_MAX_AGE);
+    time_t now = time(NULL);
+    double total = 0;
+    int i, n = 0, capacity = 16;
+    struct dirent *d;
+    CacheEntry *entries;
+    DIR *dir = opendir(cacheDir);
+    if (!dir) return;
+    entries = (CacheEntry *)malloc(capacity * sizeof(CacheEntry));
+    while (entries && (d = readdir(dir)) != NULL) {
+        struct stat st;
+        char *path = concat(cacheDir, "/", d->d_name);
+        if (!path || lstat(path, &st) != 0) {
+            free(path);
+            continue;
+        }
+        if (strlen(d->d_name) > KEY_LEN && strstr(d->d_name, ".tmp") == d->d_name + KEY_LEN) {
+            if (difftime(now, st.st_mtime) > STALE_TMP_AGE) removeTree(path);
+        } else if (isKey(d->d_name) && S_ISDIR(st.st_mode)) {
+            if (n == capacity) {
+                CacheEntry *grown = (CacheEntry *)realloc(entries, 2 * capacity * sizeof(CacheEntry));
+                if (!grown) {
+                    free(path);
+                    break;
+                }
+                entries = grown;
+                capacity *= 2;
+            }
+            strcpy(entries[n].key, d->d_name);
+            entries[n].lastUse = st.st_mtime;
+            entries[n].size = treeSize(path);
+            total += entries[n].size;
+            n++;
+        }
+        free(path);
+    }
+    closedir(dir);
+    if (!entries) return;
+    qsort(entries, n, sizeof(CacheEntry), compareLastUse);
+    for (i = 0; i < n; i++) {
+        int tooOld = difftime(now, entries[i].lastUse) > maxAge;
+        if (!tooOld && total <= maxSize) break;
+        if (strcmp(entries[i].key, current) && evictEntry(cacheDir, entries[i].key)) {
+            total -= entries[i].size;
+        }
+    }
+    free(entries);
+}
+
+// -------------------------------------------------------------------------
+// Public functions
+
+// Unpacks the archive to a private tmp dir and publishes it as entryPath.
+// Returns 0 to indicate failure.
+static int unpackEntry(ZipArchive *za, const char *cacheDir, const char *key, const char *entryPath) {
+    int ok;
+    char *outPath;
+    char *tmpPath = concat(cacheDir, "/", key);
+    char *template = tmpPath ? concat(tmpPath, ".tmpXXXXXX", "") : NULL;
+    free(tmpPath);
+    if (!template || !mkdtemp(template)) {
+        printf("error: Could not create a directory in %s\n", cacheDir);
+        free(template);
+        return 0;
+    }
+    chmod(template, 0755); // mkdtemp creates the dir accessible by the owner only
+    outPath = concat(template, "/", "");
+    ok = outPath && zipExtractAll(za, outPath);
+    free(outPath);
+    // rename fails if another process was faster, we then use its entry
+    if (!ok || rename(template, entryPath) != 0) {
+        struct stat st;
+        removeTree(template);
+        ok = ok && stat(entryPath, &st) == 0 && S_ISDIR(st.st_mode);
+    }
+    free(template);
+    return ok;
+}
+
+char *unpackToCache(const char *fmuPath) {
+    char key[KEY_LEN + 1];
+    char resolved[PATH_MAX];
+    char *entryPath = NULL;
+    char *lockPath = NULL;
+    char *result = NULL;
+    int unpacked = 0;
+    struct stat st;
+    ZipArchive *za;
+    const char *cacheDir = getenv(CACHE_DIR_ENV);
+
+    if (!cacheDir || !*cacheDir) return NULL;
+    if (!makeDirs(cacheDir) || !realpath(cacheDir, resolved)) {
+        printf("warning: Could not access cache directory %s\n", cacheDir);
+        return NULL;
+    }
+    za = zipOpen(fmuPath);
+    if (!za) return NULL;
+    computeKey(za, key);
+
+    entryPath = concat(resolved, "/", key);
+    lockPath = entryPath ? concat(entryPath, ".lock", "") : NULL;
+    if (lockPath) lockFd = lockEntry(lockPath, LOCK_SH);
+    if (lockFd < 0) {
+        printf("warning: Could not lock %s\n", lockPath ? lockPath : resolved);
+    } else if (stat(entryPath, &st) == 0 && S_ISDIR(st.st_mode)) {
+        result = concat(entryPath, "/", "");
+    } else if (unpackEntry(za, resolved, key, entryPath)) {
+        unpacked = 1;
+        result = concat(entryPath, "/", "");
+    }
+    zipClose(za);
+
+    if (result) {
+        utimes(entryPath, NULL); // last use, for the eviction
+        // only a new entry can make the cache exceed its size limit
+        if (unpacked) evictEntries(resolved, key);
+    } else {
+        releaseCachedFmu();
+    }
+    free(entryPath);
+    free(lockPath);
+    return result;
+}
+
+void releaseCachedFmu() {
+    if (lockFd >= 0) {
+        close(lockFd); // releases the flock
+        lockFd = -1;
+    }
+}
+
+#endif /* _WIN32 */
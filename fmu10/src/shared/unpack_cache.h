@@ -0,0 +1,37 @@
+/* -------------------------------------------------------------------------
+ * unpack_cache.h
+ * Persistent cache of unpacked FMUs, shared by all fmusim processes.
+ * An FMU is unpacked once into a directory named by a hash of its
+ * archive contents and reused by later runs until evicted.
+ * The cache is enabled by setting the environment variables
+ *   FMUSIM_CACHE_DIR       directory of the cache, created if missing
+ *   FMUSIM_CACHE_MAX_SIZE  size limit, e.g. 500M or 2G (default 1G)
+ *   FMUSIM_CACHE_MAX_AGE   evict entries unused for longer, e.g. 12h
+ *                          or 7d (default 30d)
+ * Only supported on Linux and Mac OS X.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#ifndef UNPACK_CACHE_H
+#define UNPACK_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CACHE_DIR_ENV      "FMUSIM_CACHE_DIR"
+#define CACHE_MAX_SIZE_ENV "FMUSIM_CACHE_MAX_SIZE"
+#define CACHE_MAX_AGE_ENV  "FMUSIM_CACHE_MAX_AGE"
+
+// Returns the cache directory holding the unpacked FMU, with a trailing
+// separator, unpacking the FMU first if it is not cached yet.
+// Returns NULL if the cache is disabled or fails, the caller must then
+// unpack the FMU itself. The receiver must free the result.
+// The entry stays protected from eviction until releaseCachedFmu().
+char *unpackToCache(const char *fmuPath);
+void releaseCachedFmu();
+
+#ifdef __cplusplus
+} // closing brace for extern "C"
+#endif
+#endif // UNPACK_CACHE_H
@@ -4,12 +4,16 @@
 
 /* ---------------------------------------------------------------------------*
  * xmlVersionParser.c
+ * Reads the fmiVersion attribute of the root element with expat. Parsing
+ * stops at the root element, the rest of the xml is not read.
  *
  * Author: Adrian Tirea
  * ---------------------------------------------------------------------------*/
 
-#ifdef STANDALONE_XML_PARSER
+#include <stdio.h>
 #include <string.h>
+
+#ifdef STANDALONE_XML_PARSER
 #define logThis(n, ...) printf(__VA_ARGS__); printf("\n")
 #define checkStrdup(str) strdup(str)
 #define BOOL int
@@ -21,55 +25,74 @@
 #include "minutil.h"  // checkStrdup
 #endif  // STANDALONE_XML_PARSER
 
-#include <libxml/xmlreader.h>
+#include "expat.h"
 #include "xmlVersionParser.h"
 
 // Element and attribute that identify the fmiVersion.
 #define ELM_fmiModelDescription_NAME "fmiModelDescription"
 #define ATT_fmiVersion_NAME "fmiVersion"
 
-static BOOL readNextInXml(xmlTextReaderPtr xmlReader) {
-    int ret;
-    do {
-        ret = xmlTextReaderRead(xmlReader);
-    } while (ret == 1 && xmlTextReaderNodeType(xmlReader) == XML_READER_TYPE_COMMENT);
+#define VERSION_BUFSIZE 4096
 
-    if (ret != 1) {
-        return FALSE;
-    }
-    return TRUE;
-}
+typedef struct {
+    XML_Parser parser;
+    BOOL rootRead;     // the root element was reached
+    char *fmiVersion;  // NULL if not found
+} VersionReader;
 
-// The receiver must free the return.
-static char *extractFmiVersionAttribute(xmlTextReaderPtr xmlReader) {
-    char *value = (char *)xmlTextReaderGetAttribute(xmlReader, ATT_fmiVersion_NAME);
-    char *result = value ? (char *)checkStrdup(value) : NULL;
-    xmlFree(value);
-    return result;
+static void XMLCALL startElement(void *context, const char *elm, const char **attr) {
+    VersionReader *reader = (VersionReader *)context;
+    const char *localName = strchr(elm, ':') ? strchr(elm, ':') + 1 : elm;
+    int i;
+    // I expect that first element is fmiModelDescription.
+    if (0 != strcmp(localName, ELM_fmiModelDescription_NAME)) {
+        logThis(ERROR_ERROR, "Expected '%s' element. Found instead: '%s'",
+            ELM_fmiModelDescription_NAME, localName);
+    } else {
+        for (i = 0; attr[i]; i += 2) {
+            if (0 == strcmp(attr[i], ATT_fmiVersion_NAME)) {
+                reader->fmiVersion = (char *)checkStrdup(attr[i + 1]);
+                break;
+            }
+        }
+    }
+    reader->rootRead = TRUE;
+    XML_StopParser(reader->parser, XML_FALSE);
 }
 
-// The receiver must free the return.
-static char *streamFile(const char *xmlPath) {
-    xmlTextReaderPtr xmlReader;
-    char *fmiVersion = NULL;
-    xmlReader = xmlReaderForFile(xmlPath, NULL, 0);
-    if (xmlReader != NULL) {
-        if (readNextInXml(xmlReader)) {
-            // I expect that first element is fmiModelDescription.
-            if (0 != strcmp((char *)xmlTextReaderConstLocalName(xmlReader), ELM_fmiModelDescription_NAME)) {
-                logThis(ERROR_ERROR, "Expected '%s' element. Found instead: '%s'",
-                    ELM_fmiModelDescription_NAME, xmlTextReaderConstLocalName(xmlReader));
-            } else {
-                fmiVersion = extractFmiVersionAttribute(xmlReader);
-            }
+// The receiver must free the return. Parses xml if not NULL, else the file.
+static char *streamReader(FILE *file, const char *xml, int size, const char *xmlPath) {
+    VersionReader reader;
+    char buffer[VERSION_BUFSIZE];
+    BOOL done = FALSE;
+    reader.rootRead = FALSE;
+    reader.fmiVersion = NULL;
+    reader.parser = XML_ParserCreate(NULL);
+    if (!reader.parser) {
+        logThis(ERROR_ERROR, "Out of memory");
+        return NULL;
+    }
+    XML_SetUserData(reader.parser, &reader);
+    XML_SetStartElementHandler(reader.parser, startElement);
+    while (!done && !reader.rootRead) {
+        const char *data = xml;
+        int n = size;
+        if (xml) {
+            done = TRUE;
         } else {
-            logThis(ERROR_ERROR, "Syntax error parsing xml file '%s'", xmlPath);
+            data = buffer;
+            n = (int)fread(buffer, 1, VERSION_BUFSIZE, file);
+            done = n < VERSION_BUFSIZE;
+        }
+        if (XML_Parse(reader.parser, data, n, done) == XML_STATUS_ERROR && !reader.rootRead) {
+            break;
         }
-        xmlFreeTextReader(xmlReader);
-    } else {
-        logThis(ERROR_ERROR, "Cannot open file '%s'", xmlPath);
     }
-    return fmiVersion;
+    if (!reader.rootRead) {
+        logThis(ERROR_ERROR, "Syntax error parsing xml file '%s'", xmlPath);
+    }
+    XML_ParserFree(reader.parser);
+    return reader.fmiVersion;
 }
 
 // Returns NULL to indicate failure
@@ -77,10 +100,18 @@ static char *streamFile(const char *xmlPath) {
 // The receiver must free the returned string.
 char *extractVersion(const char *xmlDescriptionPath) {
     char *fmiVersion;
-
-    fmiVersion = streamFile(xmlDescriptionPath);
-    // do NOT call here xmlCleanupParser() because we don't know all other modules linked into this DLL that
-    // might be using libxml2. For memory leak detections call xmlCleanupParser() just before exit()
-    //xmlCleanupParser();
+    FILE *file = fopen(xmlDescriptionPath, "rb");
+    if (!file) {
+        logThis(ERROR_ERROR, "Cannot open file '%s'", xmlDescriptionPath);
+        return NULL;
+    }
+    fmiVersion = streamReader(file, NULL, 0, xmlDescriptionPath);
+    fclose(file);
     return fmiVersion;
 }
+
+// Same as extractVersion() for a model description read into memory.
+// xmlName is used in error messages only.
+char *extractVersionFromMemory(const char *xml, int size, const char *xmlName) {
+    return streamReader(NULL, xml, size, xmlName);
+}
@@ -16,12 +16,8 @@
 extern "C" {
 #endif
 
-#ifdef _MSC_VER
-#pragma comment(lib, "libxml2.lib")
-#pragma comment(lib, "wsock32.lib")
-#endif /* _MSC_VER */
-
 char *extractVersion(const char *xmlDescriptionPath);
+char *extractVersionFromMemory(const char *xml, int size, const char *xmlName);
 
 #ifdef __cplusplus
 } // closing brace for extern "C"
@@ -14,6 +14,9 @@
  * - check for correct sequence of elements
  * - check for each attribute value that it is of the expected type
  * - check that all declaredType values reference an existing Type
+ * While parsing, the ScalarVariables are also added to a VariableTable with
+ * hash indexes by value reference and by name, so that variables are found
+ * in constant time.
  * Validation to be performed by this parser
  * - check that required attributes are present
  * - check that dependencies are only declared for outputs and
@@ -65,6 +68,7 @@ XML_Parser parser = NULL;    // non-NULL during parsing
 Stack* stack = NULL;         // the parser stack
 char* data = NULL;           // buffer that holds element content, see handleData
 int skipData=0;              // 1 to ignore element content, 0 when recording content
+VariableTable* variables = NULL; // rows of the ScalarVariables parsed so far
 
 // -------------------------------------------------------------------------
 // Low-level functions for inspecting the model description 
@@ -203,18 +207,6 @@ fmiValueReference getValueReference(void* scalarVariable) {
     return vr;
 }
 
-// the name is unique within a fmu
-ScalarVariable* getVariableByName(ModelDescription* md, const char* name) {
-    int i;
-    if (md->modelVariables) {
-        for (i=0; md->modelVariables[i]; i++){
-            ScalarVariable* sv = (ScalarVariable*)md->modelVariables[i];
-            if (!strcmp(getName(sv), name)) return sv;
-        }
-    }
-    return NULL;
-}
-
 // Enumeration and Integer have the same base type while
 // Real, String, Boolean define own base types.
 int sameBaseType(Elm t1, Elm t2){
@@ -223,30 +215,86 @@ int sameBaseType(Elm t1, Elm t2){
            t2==elm_Enumeration && t1==elm_Integer;
 }
 
+// Hash indexes of the VariableTable use open addressing with linear probing.
+// At most half of the slots are used.
+static unsigned int refHash(fmiValueReference vr, Elm type){
+    unsigned int h;
+    if (type == elm_Enumeration) type = elm_Integer; // same base type
+    h = (vr * 31u + (unsigned int)type) * 2654435769u;
+    return h ^ (h >> 15);
+}
+
+static unsigned int nameHash(const char* name){
+    unsigned int h = 2166136261u;
+    for (; *name; name++) {
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+// Returns the slot in rowsByRef of the row with vr and the base type of type,
+// an empty slot if there is no such row.
+static unsigned int refSlot(VariableTable* t, fmiValueReference vr, Elm type){
+    unsigned int mask = t->hashSize - 1;
+    unsigned int slot = refHash(vr, type) & mask;
+    int row;
+    while ((row = t->rowsByRef[slot] - 1) >= 0) {
+        if (t->valueReferences[row] == vr && sameBaseType(type, t->types[row])) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Returns the slot in rowsByName of the row with name, an empty slot if there is no such row.
+static unsigned int nameRowSlot(VariableTable* t, const char* name){
+    unsigned int mask = t->hashSize - 1;
+    unsigned int slot = nameHash(name) & mask;
+    int row;
+    while ((row = t->rowsByName[slot] - 1) >= 0) {
+        if (!strcmp(t->names[row], name)) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+int findVariableRow(ModelDescription* md, fmiValueReference vr, Elm type){
+    VariableTable* t = md->variables;
+    if (!t || vr==fmiUndefinedValueReference) return -1;
+    return t->rowsByRef[refSlot(t, vr, type)] - 1;
+}
+
+int findVariableRowByName(ModelDescription* md, const char* name){
+    VariableTable* t = md->variables;
+    if (!t) return -1;
+    return t->rowsByName[nameRowSlot(t, name)] - 1;
+}
+
+int getBaseVariableRow(ModelDescription* md, int row, int* negated){
+    VariableTable* t = md->variables;
+    assert(t && row >= 0 && row < t->n);
+    *negated = t->aliases[row] == enu_negatedAlias;
+    return t->bases[row];
+}
+
+// the name is unique within a fmu
+ScalarVariable* getVariableByName(ModelDescription* md, const char* name) {
+    int row = findVariableRowByName(md, name);
+    return row < 0 ? NULL : md->variables->variables[row];
+}
+
 // returns NULL if variable not found or vr==fmiUndefinedValueReference
 // problem: vr/type in not a unique key, may return alias
 ScalarVariable* getVariable(ModelDescription* md, fmiValueReference vr, Elm type){
-    int i;
-    if (md->modelVariables && vr!=fmiUndefinedValueReference)
-    for (i=0; md->modelVariables[i]; i++){
-        ScalarVariable* sv = (ScalarVariable*)md->modelVariables[i];
-        if (sameBaseType(type, sv->typeSpec->type) && getValueReference(sv) == vr)
-            return sv;
-    }
-    return NULL;
+    int row = findVariableRow(md, vr, type);
+    return row < 0 ? NULL : md->variables->variables[row];
 }
 
 // returns NULL if variable not found or vr==fmiUndefinedValueReference
 // problem: vr/type in not a unique key, return just the non alias variable
 ScalarVariable* getNonAliasVariable(ModelDescription* md, fmiValueReference vr, Elm type){
-    int i;
-    if (md->modelVariables && vr!=fmiUndefinedValueReference)
-    for (i=0; md->modelVariables[i]; i++){
-        ScalarVariable* sv = (ScalarVariable*)md->modelVariables[i];
-        if (sameBaseType(type, sv->typeSpec->type) && getValueReference(sv) == vr && getAlias(sv) == enu_noAlias)
-            return sv;
-    }
-    return NULL;
+    int row = findVariableRow(md, vr, type);
+    if (row >= 0) row = md->variables->bases[row];
+    return row < 0 ? NULL : md->variables->variables[row];
 }
 
 Type* getDeclaredType(ModelDescription* md, const char* declaredType){
@@ -326,11 +374,62 @@ static int checkPointer(const void* ptr){
     return 1; // success
 }
 
-static int checkName(const char* name, const char* kind, const char* array[], int n){
+// Perfect hash table of the names in one of the arrays elmNames, attNames and
+// enuNames. initNameTable searches a seed for which every name hashes to a
+// different slot, so that a lookup costs one hash and one strcmp instead of a
+// strcmp per name. The tables are built from the arrays on first use and can
+// therefore not get out of sync with them.
+#define NAME_TABLE_MAX_BITS 12
+typedef struct {
+    const char** names;
+    unsigned int seed;
+    int bits;  // log2 of the number of slots, 0 until initialized
+    unsigned char slots[1 << NAME_TABLE_MAX_BITS]; // 1 + index of the name hashed to the slot, 0 if none
+} NameTable;
+
+static NameTable elmTable;
+static NameTable attTable;
+static NameTable enuTable;
+
+static unsigned int nameSlot(const NameTable* table, const char* name){
+    unsigned int h = table->seed;
+    for (; *name; name++) {
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    }
+    return (h * 2654435769u) >> (32 - table->bits);
+}
+
+static int fillNameTable(NameTable* table, int n){
     int i;
+    memset(table->slots, 0, (size_t)1 << table->bits);
     for (i=0; i<n; i++) {
-        if (!strcmp(name, array[i])) return i;
+        unsigned char* s = &table->slots[nameSlot(table, table->names[i])];
+        if (*s) return 0; // collision
+        *s = (unsigned char)(i + 1);
     }
+    return 1;
+}
+
+static void initNameTable(NameTable* table, const char* array[], int n){
+    table->names = array;
+    // with n*n/2 slots, a random seed is collision free with probability 1/e
+    for (table->bits=1; (1 << table->bits) < n * n / 2; table->bits++);
+    for (table->seed=1; !fillNameTable(table, n); table->seed++) {
+        if (table->seed % 64 == 0 && table->bits < NAME_TABLE_MAX_BITS) table->bits++;
+    }
+}
+
+// Returns the index of name in array, -1 if not found
+static int findName(const char* name, NameTable* table, const char* array[], int n){
+    int i;
+    if (!table->bits) initNameTable(table, array, n);
+    i = table->slots[nameSlot(table, name)] - 1;
+    return i >= 0 && !strcmp(name, array[i]) ? i : -1;
+}
+
+static int checkName(const char* name, const char* kind, NameTable* table, const char* array[], int n){
+    int i = findName(name, table, array, n);
+    if (i >= 0) return i;
     logThis(ERROR_FATAL, "Illegal %s %s", kind, name);
     XML_StopParser(parser, XML_FALSE);
     return -1;
@@ -338,17 +437,17 @@ static int checkName(const char* name, const char* kind, const char* array[], in
 
 // Returns elm_BAD_DEFINED to indicate error
 static Elm checkElement(const char* elm){
-    return (Elm)checkName(elm, "element", elmNames, SIZEOF_ELM);
+    return (Elm)checkName(elm, "element", &elmTable, elmNames, SIZEOF_ELM);
 }
 
 // Returns att_BAD_DEFINED to indicate error
 static Att checkAttribute(const char* att){
-    return (Att)checkName(att, "attribute", attNames, SIZEOF_ATT);
+    return (Att)checkName(att, "attribute", &attTable, attNames, SIZEOF_ATT);
 }
 
 // Returns enu_BAD_DEFINED to indicate error
 static Enu checkEnumValue(const char* enu){
-    return (Enu)checkName(enu, "enum value", enuNames, SIZEOF_ENU);
+    return (Enu)checkName(enu, "enum value", &enuTable, enuNames, SIZEOF_ENU);
 }
 
 static void logFatalTypeError(const char* expected, Elm found) {
@@ -462,6 +561,119 @@ Element* newElement(Elm type, int size, const char** attr) {
     return e;
 }
 
+// -------------------------------------------------------------------------
+// Variable table, filled while parsing
+
+static void freeVariableTable(VariableTable* t){
+    if (!t) return;
+    free((void *)t->variables);
+    free((void *)t->names);
+    free(t->valueReferences);
+    free(t->types);
+    free(t->causalities);
+    free(t->variabilities);
+    free(t->aliases);
+    free(t->bases);
+    free(t->rowsByRef);
+    free(t->rowsByName);
+    free(t);
+}
+
+// Returns 0 to indicate error
+static int growColumn(void** column, int capacity, size_t size){
+    void* p = realloc(*column, capacity * size);
+    if (!checkPointer(p)) return 0;
+    *column = p;
+    return 1;
+}
+
+// Like getEnumValue, but returns enu_BAD_DEFINED for an illegal value without
+// logging an error: the value is reported only if a getter is called for it.
+static Enu decodeEnumValue(void* element, Att a){
+    ValueStatus vs;
+    const char* value = getString(element, a);
+    if (!value) return getEnumValue(element, a, &vs); // the default
+    return (Enu)findName(value, &enuTable, enuNames, SIZEOF_ENU);
+}
+
+// Returns 0 to indicate error
+// Appends a row for sv, whose typeSpec is set, to the variable table
+static int addVariableRow(ScalarVariable* sv){
+    VariableTable* t = variables;
+    ValueStatus vs;
+    int i;
+    if (!t) {
+        t = (VariableTable*)calloc(1, sizeof(VariableTable));
+        if (!checkPointer(t)) return 0;
+        variables = t;
+    }
+    if (t->n == t->capacity) {
+        int capacity = t->capacity ? 2 * t->capacity : 64;
+        if (!growColumn((void **)&t->variables, capacity, sizeof(*t->variables))
+                || !growColumn((void **)&t->names, capacity, sizeof(*t->names))
+                || !growColumn((void **)&t->valueReferences, capacity, sizeof(*t->valueReferences))
+                || !growColumn((void **)&t->types, capacity, sizeof(*t->types))
+                || !growColumn((void **)&t->causalities, capacity, sizeof(*t->causalities))
+                || !growColumn((void **)&t->variabilities, capacity, sizeof(*t->variabilities))
+                || !growColumn((void **)&t->aliases, capacity, sizeof(*t->aliases))
+                || !growColumn((void **)&t->bases, capacity, sizeof(*t->bases))) return 0;
+        t->capacity = capacity;
+    }
+    i = t->n++;
+    t->variables[i] = sv;
+    t->names[i] = getString(sv, att_name);
+    t->valueReferences[i] = getUInt(sv, att_valueReference, &vs);
+    if (vs != valueDefined) t->valueReferences[i] = fmiUndefinedValueReference;
+    t->types[i] = sv->typeSpec->type;
+    t->causalities[i] = decodeEnumValue(sv, att_causality);
+    t->variabilities[i] = decodeEnumValue(sv, att_variability);
+    t->aliases[i] = decodeEnumValue(sv, att_alias);
+    return 1;
+}
+
+// Returns 0 to indicate error
+// Moves the rows added for md->modelVariables to md and builds the indexes
+static int finishVariableTable(ModelDescription* md){
+    VariableTable* t = variables;
+    int i, n = 0;
+    md->variables = t; // freed with md from now on
+    variables = NULL;
+    if (md->modelVariables) while (md->modelVariables[n]) n++;
+    if (n != (t ? t->n : 0)) {
+        logThis(ERROR_FATAL, "Illegal document structure, ScalarVariable outside of ModelVariables");
+        XML_StopParser(parser, XML_FALSE);
+        return 0; // error
+    }
+    if (!t) return 1; // no variables
+    for (t->hashSize = 2; t->hashSize < 2 * t->n; t->hashSize *= 2);
+    t->rowsByRef = (int*)calloc(t->hashSize, sizeof(int));
+    if (!checkPointer(t->rowsByRef)) return 0;
+    t->rowsByName = (int*)calloc(t->hashSize, sizeof(int));
+    if (!checkPointer(t->rowsByName)) return 0;
+    // index the first row of each key, as the linear search did before
+    for (i=0; i<t->n; i++) {
+        t->bases[i] = -1;
+        if (t->valueReferences[i] != fmiUndefinedValueReference) {
+            int* slot = &t->rowsByRef[refSlot(t, t->valueReferences[i], t->types[i])];
+            if (!*slot) *slot = i + 1;
+        }
+        if (t->names[i]) {
+            int* slot = &t->rowsByName[nameRowSlot(t, t->names[i])];
+            if (!*slot) *slot = i + 1;
+        }
+    }
+    // the base of a key is its first noAlias row, store it at the first row of the key
+    for (i=0; i<t->n; i++) {
+        int first = findVariableRow(md, t->valueReferences[i], t->types[i]);
+        if (t->aliases[i] == enu_noAlias && first >= 0 && t->bases[first] < 0) t->bases[first] = i;
+    }
+    for (i=0; i<t->n; i++) {
+        int first = findVariableRow(md, t->valueReferences[i], t->types[i]);
+        if (first >= 0) t->bases[i] = t->bases[first];
+    }
+    return 1;
+}
+
 // -------------------------------------------------------------------------
 // callback functions called by the XML parser 
 
@@ -577,6 +789,7 @@ static void XMLCALL endElement(void *context, const char *elm) {
                  md->unitDefinitions = ud;
                  md->cosimulation = cs;
                  stackPush(stack, md);
+                 if (!finishVariableTable(md)) return;
                  break;
             }
         case elm_Implementation:
@@ -659,6 +872,7 @@ static void XMLCALL endElement(void *context, const char *elm) {
                 }
                 sv->directDependencies = list;
                 sv->typeSpec = child;
+                if (!addVariableRow(sv)) return;
                 break;
             }
         case elm_ModelVariables:    popList(elm_ScalarVariable); break;
@@ -824,6 +1038,7 @@ void freeElement(void* element){
             freeList((void **)md->vendorAnnotations);
             freeList((void **)md->modelVariables);
             freeElement(md->cosimulation);
+            freeVariableTable(md->variables);
             break;
         }
     }
@@ -868,14 +1083,18 @@ ModelDescription* validate(ModelDescription* md) {
 static void cleanup(FILE *file) {
     stackFree(stack);
     stack = NULL;
+    freeVariableTable(variables);
+    variables = NULL;
     XML_ParserFree(parser);
     parser = NULL;
-    fclose(file);
+    if (file) fclose(file);
 }
 
-ModelDescription* parse_encoding(const char* xmlPath, const char *encoding) {
+// Parses the file at xmlPath, or xml[0..size-1] if xml is not NULL.
+// xmlPath is then used in messages only.
+static ModelDescription* parse_encoding(const char* xmlPath, const char *encoding, const char* xml, int size) {
     ModelDescription* md = NULL;
-    FILE *file;
+    FILE *file = NULL;
     int done = 0;
     stack = stackNew(100, 10);
     if (!checkPointer(stack)) return NULL; // failure
@@ -883,17 +1102,27 @@ ModelDescription* parse_encoding(const char* xmlPath, const char *encoding) {
     if (!checkPointer(parser)) return NULL; // failure
     XML_SetElementHandler(parser, startElement, endElement);
     XML_SetCharacterDataHandler(parser, handleData);
-    file = fopen(xmlPath, "rb");
-    if (file == NULL) {
-        logThis(ERROR_ERROR, "Cannot open file '%s'", xmlPath);
-        XML_ParserFree(parser);
-        return NULL; // failure
+    if (!xml) {
+        file = fopen(xmlPath, "rb");
+        if (file == NULL) {
+            logThis(ERROR_ERROR, "Cannot open file '%s'", xmlPath);
+            XML_ParserFree(parser);
+            return NULL; // failure
+        }
     }
     logThis(ERROR_INFO, "parse %s", xmlPath);
     while (!done) {
-        int n = fread(text, sizeof(char), XMLBUFSIZE, file);
-        if (n != XMLBUFSIZE) done = 1;
-        if (!XML_Parse(parser, text, n, done)){
+        const char *buffer = text;
+        int n;
+        if (xml) {
+            buffer = xml;
+            n = size;
+            done = 1;
+        } else {
+            n = fread(text, sizeof(char), XMLBUFSIZE, file);
+            if (n != XMLBUFSIZE) done = 1;
+        }
+        if (!XML_Parse(parser, buffer, n, done)){
             logThis(ERROR_ERROR, "Parse error in file %s at line %d:\n%s\n",
                 xmlPath,
                 XML_GetCurrentLineNumber(parser),
@@ -911,26 +1140,23 @@ ModelDescription* parse_encoding(const char* xmlPath, const char *encoding) {
     return validate(md); // success if all refs are valid
 }
 
-// Returns NULL to indicate failure
-// Otherwise, return the root node md of the AST.
-// The receiver must call freeElement(md) to release AST memory.
-ModelDescription* parse(const char* xmlPath) {
+static ModelDescription* parse_any_encoding(const char* xmlPath, const char* xml, int size) {
     // UTF-8
     // ISO-8859-1
     // US-ASCII
     // UTF-16
     ModelDescription* md = NULL;
-    md = parse_encoding(xmlPath, "UTF-8");
+    md = parse_encoding(xmlPath, "UTF-8", xml, size);
     if (md != NULL) {
         return md;
     }
     logThis(ERROR_WARNING, "Failed to parse using UTF-8, will try ISO-8859-1 encoding. %s", xmlPath);
-    md = parse_encoding(xmlPath, "ISO-8859-1");
+    md = parse_encoding(xmlPath, "ISO-8859-1", xml, size);
     if (md != NULL) {
         return md;
     }
     logThis(ERROR_WARNING, "Failed to parse using ISO-8859-1, will try US-ASCII encoding. %s", xmlPath);
-    md = parse_encoding(xmlPath, "US-ASCII");
+    md = parse_encoding(xmlPath, "US-ASCII", xml, size);
     if (md != NULL) {
         return md;
     }
@@ -938,6 +1164,19 @@ ModelDescription* parse(const char* xmlPath) {
     return NULL;
 }
 
+// Returns NULL to indicate failure
+// Otherwise, return the root node md of the AST.
+// The receiver must call freeElement(md) to release AST memory.
+ModelDescription* parse(const char* xmlPath) {
+    return parse_any_encoding(xmlPath, NULL, 0);
+}
+
+// Same as parse() for a model description read into memory, e.g. from the FMU archive.
+// xmlName is used in messages only.
+ModelDescription* parseFromMemory(const char* xmlName, const char* xml, int size) {
+    return parse_any_encoding(xmlName, xml, size);
+}
+
 // #define TEST
 #ifdef TEST
 int main(int argc, char**argv) {
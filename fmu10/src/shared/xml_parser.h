@@ -114,6 +114,28 @@ typedef struct {
     ListElement* model;      // non-NULL to support tool coupling, NULL for standalone
 } CoSimulation;
 
+// Columnar table of the ScalarVariables, filled by the parser while reading them.
+// Row i describes modelVariables[i] with its attributes decoded, defaults applied.
+typedef struct {
+    int n;                              // number of rows
+    int capacity;                       // allocated rows
+    ScalarVariable** variables;         // the AST nodes
+    const char** names;                 // NULL if missing
+    fmiValueReference* valueReferences; // fmiUndefinedValueReference if missing
+    Elm* types;                         // type of the typeSpec, e.g. elm_Real
+    Enu* causalities;                   // enu_BAD_DEFINED if illegal
+    Enu* variabilities;                 // enu_BAD_DEFINED if illegal
+    Enu* aliases;                       // enu_noAlias, enu_alias, enu_negatedAlias or enu_BAD_DEFINED
+    // row of the noAlias variable with the same vr and base type, the row itself for
+    // noAlias variables, -1 if there is none. The value of a row with alias
+    // enu_negatedAlias is the negated value of its base.
+    int* bases;
+    // hash indexes, 1 + row or 0 for an empty slot, see findVariableRow
+    int hashSize;                       // number of slots, a power of 2
+    int* rowsByRef;                     // by vr and base type, the first row in document order
+    int* rowsByName;                    // by name
+} VariableTable;
+
 // AST node for element ModelDescription
 typedef struct {
     Elm type;                // element type
@@ -125,6 +147,7 @@ typedef struct {
     ListElement** vendorAnnotations;  // NULL or null-terminated list of Tools
     ScalarVariable** modelVariables;  // NULL or null-terminated list of ScalarVariable
     CoSimulation* cosimulation;       // NULL if this ModelDescription is for model exchange only
+    VariableTable* variables;         // NULL or table of the modelVariables
 } ModelDescription;
 
 // types of AST nodes used to represent an element
@@ -146,6 +169,7 @@ typedef enum {
 
 // Public methods: Parsing and low-level AST access
 ModelDescription* parse(const char* xmlPath);
+ModelDescription* parseFromMemory(const char* xmlName, const char* xml, int size);
 const char* getString(void* element, Att a);
 double getDouble     (void* element, Att a, ValueStatus* vs);
 int getInt           (void* element, Att a, ValueStatus* vs);
@@ -174,6 +198,17 @@ double getVariableAttributeDouble(ModelDescription* md, fmiValueReference vr, El
 //double getNominal(ModelDescription* md, ScalarVariable* sv);
 double getNominal(ModelDescription* md, fmiValueReference vr);
 
+// Lookups in md->variables, in constant time. Rows are indexes into md->modelVariables.
+// Returns the first row in document order with the given vr and the base type of type,
+// -1 if not found or vr==fmiUndefinedValueReference.
+int findVariableRow(ModelDescription* md, fmiValueReference vr, Elm type);
+// Returns the row of the variable with the given name, -1 if not found.
+int findVariableRowByName(ModelDescription* md, const char* name);
+// Returns the row of the noAlias variable that the variable at row is an alias of,
+// row itself for a noAlias variable, -1 if there is none. Sets *negated to 1 if the
+// value of the variable is the negated value of the base variable, else to 0.
+int getBaseVariableRow(ModelDescription* md, int row, int* negated);
+
 #ifdef __cplusplus
 } // closing brace for extern "C"
 #endif
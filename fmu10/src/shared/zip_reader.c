@@ -0,0 +1,763 @@
+/* -------------------------------------------------------------------------
+ * zip_reader.c
+ * In-process reader for the ZIP archives used as FMU container.
+ * Replaces the former system() call of unzip or 7z.exe: the archive is
+ * memory mapped, the central directory is read once and the entries are
+ * inflated on demand by the table-driven inflater below.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "zip_reader.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>  // _mkdir()
+#else /* _WIN32 */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#endif /* _WIN32 */
+
+#define SIG_LOCAL_HEADER   0x04034b50
+#define SIG_CENTRAL_HEADER 0x02014b50
+#define SIG_END_OF_CD      0x06054b50
+#define SIG_ZIP64_LOCATOR  0x07064b50
+#define SIG_ZIP64_END_OF_CD 0x06064b50
+
+#define LOCAL_HEADER_SIZE   30
+#define CENTRAL_HEADER_SIZE 46
+#define END_OF_CD_SIZE      22
+#define ZIP64_LOCATOR_SIZE  20
+#define ZIP64_END_OF_CD_SIZE 56
+#define MAX_COMMENT_SIZE    0xFFFF
+
+#define FLAG_ENCRYPTED 0x0001
+
+struct ZipArchive {
+    const unsigned char *data;  // mapped archive
+    size_t size;                // size of the mapped archive
+    int nEntries;
+    ZipEntry *entries;
+};
+
+// -------------------------------------------------------------------------
+// Little-endian access into the mapped archive
+
+static unsigned int readU16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned long readU32(const unsigned char *p) {
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8)
+        | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static unsigned long long readU64(const unsigned char *p) {
+    return (unsigned long long)readU32(p) | ((unsigned long long)readU32(p + 4) << 32);
+}
+
+// -------------------------------------------------------------------------
+// CRC-32 (polynomial 0xEDB88320), slicing by 8 bytes
+
+static unsigned long crcTable[8][256];
+static int crcTableReady = 0;
+
+static void makeCrcTable() {
+    int i, k;
+    for (i = 0; i < 256; i++) {
+        unsigned long c = (unsigned long)i;
+        for (k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+        crcTable[0][i] = c;
+    }
+    for (i = 0; i < 256; i++) {
+        for (k = 1; k < 8; k++) {
+            unsigned long c = crcTable[k - 1][i];
+            crcTable[k][i] = crcTable[0][c & 0xFF] ^ (c >> 8);
+        }
+    }
+    crcTableReady = 1;
+}
+
+static unsigned long crc32(const unsigned char *p, size_t n) {
+    unsigned long c = 0xFFFFFFFFUL;
+    if (!crcTableReady) makeCrcTable();
+    while (n >= 8) {
+        unsigned long lo = c ^ readU32(p);
+        unsigned long hi = readU32(p + 4);
+        c = crcTable[7][lo & 0xFF] ^ crcTable[6][(lo >> 8) & 0xFF]
+          ^ crcTable[5][(lo >> 16) & 0xFF] ^ crcTable[4][(lo >> 24) & 0xFF]
+          ^ crcTable[3][hi & 0xFF] ^ crcTable[2][(hi >> 8) & 0xFF]
+          ^ crcTable[1][(hi >> 16) & 0xFF] ^ crcTable[0][(hi >> 24) & 0xFF];
+        p += 8;
+        n -= 8;
+    }
+    while (n--) c = crcTable[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return (c ^ 0xFFFFFFFFUL) & 0xFFFFFFFFUL;
+}
+
+// -------------------------------------------------------------------------
+// Inflate (RFC 1951). Decodes into an output buffer of known size, which
+// ZIP provides through the uncompressed size of each entry. Huffman codes
+// of up to FAST_BITS bits are decoded with a single table lookup.
+
+#define FAST_BITS 9
+#define FAST_MASK ((1 << FAST_BITS) - 1)
+
+typedef struct {
+    unsigned short fast[1 << FAST_BITS]; // (code length << 9) | symbol, 0 for longer codes
+    unsigned short firstCode[16];
+    int maxCode[17];                     // first code of next length, left aligned to 16 bits
+    unsigned short firstSymbol[16];
+    unsigned char size[288];
+    unsigned short value[288];
+} Huffman;
+
+typedef struct {
+    const unsigned char *in;
+    size_t inLen;
+    size_t inPos;                 // may run past inLen while the bit buffer is padded with zeros
+    unsigned long long bitBuf;
+    int bitCount;
+    unsigned char *out;
+    size_t outLen;
+    size_t outPos;
+    Huffman lengths;
+    Huffman distances;
+} Inflater;
+
+static const unsigned short lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const unsigned char lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const unsigned short distanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const unsigned char distanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const unsigned char codeLengthOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+static int bitReverse16(int n) {
+    n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
+    n = ((n & 0xCCCC) >> 2) | ((n & 0x3333) << 2);
+    n = ((n & 0xF0F0) >> 4) | ((n & 0x0F0F) << 4);
+    n = ((n & 0xFF00) >> 8) | ((n & 0x00FF) << 8);
+    return n;
+}
+
+// Returns 0 to indicate an over-subscribed code
+static int buildHuffman(Huffman *h, const unsigned char *sizes, int n) {
+    int i, k = 0, code = 0;
+    int nextCode[16], count[17];
+    memset(count, 0, sizeof(count));
+    memset(h->fast, 0, sizeof(h->fast));
+    for (i = 0; i < n; i++) count[sizes[i]]++;
+    count[0] = 0;
+    for (i = 1; i < 16; i++) {
+        if (count[i] > (1 << i)) return 0;
+    }
+    for (i = 1; i < 16; i++) {
+        nextCode[i] = code;
+        h->firstCode[i] = (unsigned short)code;
+        h->firstSymbol[i] = (unsigned short)k;
+        code += count[i];
+        if (count[i] && code - 1 >= (1 << i)) return 0;
+        h->maxCode[i] = code << (16 - i);
+        code <<= 1;
+        k += count[i];
+    }
+    h->maxCode[16] = 0x10000; // sentinel
+    for (i = 0; i < n; i++) {
+        int s = sizes[i];
+        if (s) {
+            int c = nextCode[s] - h->firstCode[s] + h->firstSymbol[s];
+            h->size[c] = (unsigned char)s;
+            h->value[c] = (unsigned short)i;
+            if (s <= FAST_BITS) {
+                int j = bitReverse16(nextCode[s]) >> (16 - s);
+                while (j < (1 << FAST_BITS)) {
+                    h->fast[j] = (unsigned short)((s << 9) | i);
+                    j += (1 << s);
+                }
+            }
+            nextCode[s]++;
+        }
+    }
+    return 1;
+}
+
+static void refill(Inflater *z) {
+    while (z->bitCount <= 56) {
+        unsigned long long byte = z->inPos < z->inLen ? z->in[z->inPos] : 0;
+        z->inPos++;
+        z->bitBuf |= byte << z->bitCount;
+        z->bitCount += 8;
+    }
+}
+
+static unsigned int getBits(Inflater *z, int n) {
+    unsigned int v;
+    if (z->bitCount < n) refill(z);
+    v = (unsigned int)(z->bitBuf & ((1UL << n) - 1));
+    z->bitBuf >>= n;
+    z->bitCount -= n;
+    return v;
+}
+
+// Returns the decoded symbol or -1 for an invalid code
+static int decodeSymbol(Inflater *z, Huffman *h) {
+    int b, s, k;
+    if (z->bitCount < 16) refill(z);
+    b = h->fast[z->bitBuf & FAST_MASK];
+    if (b) {
+        s = b >> 9;
+        z->bitBuf >>= s;
+        z->bitCount -= s;
+        return b & 511;
+    }
+    k = bitReverse16((int)(z->bitBuf & 0xFFFF));
+    for (s = FAST_BITS + 1; k >= h->maxCode[s]; s++);
+    if (s >= 16) return -1;
+    b = (k >> (16 - s)) - h->firstCode[s] + h->firstSymbol[s];
+    if (b >= 288 || h->size[b] != s) return -1;
+    z->bitBuf >>= s;
+    z->bitCount -= s;
+    return h->value[b];
+}
+
+// true if the decoder consumed more bits than available in the input
+static int inputOverrun(Inflater *z) {
+    return z->inPos * 8 - z->bitCount > z->inLen * 8;
+}
+
+static int inflateStored(Inflater *z) {
+    unsigned int len, nlen;
+    size_t pos;
+    // drop the bits up to the next byte boundary and return unused bytes to the input
+    getBits(z, z->bitCount & 7);
+    pos = z->inPos - z->bitCount / 8;
+    z->bitBuf = 0;
+    z->bitCount = 0;
+    if (pos + 4 > z->inLen) return 0;
+    len = readU16(z->in + pos);
+    nlen = readU16(z->in + pos + 2);
+    pos += 4;
+    if ((len ^ 0xFFFF) != nlen) return 0;
+    if (pos + len > z->inLen || len > z->outLen - z->outPos) return 0;
+    memcpy(z->out + z->outPos, z->in + pos, len);
+    z->outPos += len;
+    z->inPos = pos + len;
+    return 1;
+}
+
+static int inflateCodes(Inflater *z) {
+    for (;;) {
+        int sym = decodeSymbol(z, &z->lengths);
+        if (sym < 256) {
+            if (sym < 0 || z->outPos >= z->outLen) return 0;
+            z->out[z->outPos++] = (unsigned char)sym;
+        } else if (sym == 256) {
+            return !inputOverrun(z);
+        } else {
+            size_t len, dist;
+            unsigned char *dst, *src;
+            sym -= 257;
+            if (sym >= 29) return 0;
+            len = lengthBase[sym] + (lengthExtra[sym] ? getBits(z, lengthExtra[sym]) : 0);
+            sym = decodeSymbol(z, &z->distances);
+            if (sym < 0 || sym >= 30) return 0;
+            dist = distanceBase[sym] + (distanceExtra[sym] ? getBits(z, distanceExtra[sym]) : 0);
+            if (dist > z->outPos || len > z->outLen - z->outPos) return 0;
+            dst = z->out + z->outPos;
+            src = dst - dist;
+            z->outPos += len;
+            if (dist >= len) {
+                memcpy(dst, src, len);
+            } else {
+                while (len--) *dst++ = *src++; // overlapping copy repeats the pattern
+            }
+        }
+        if (inputOverrun(z)) return 0;
+    }
+}
+
+static int buildFixedCodes(Inflater *z) {
+    unsigned char sizes[288];
+    int i;
+    for (i = 0; i < 144; i++) sizes[i] = 8;
+    for (; i < 256; i++) sizes[i] = 9;
+    for (; i < 280; i++) sizes[i] = 7;
+    for (; i < 288; i++) sizes[i] = 8;
+    if (!buildHuffman(&z->lengths, sizes, 288)) return 0;
+    for (i = 0; i < 30; i++) sizes[i] = 5;
+    return buildHuffman(&z->distances, sizes, 30);
+}
+
+static int buildDynamicCodes(Inflater *z) {
+    Huffman codeLengths;
+    unsigned char sizes[286 + 30 + 137];
+    unsigned char codeLengthSizes[19];
+    int i, n;
+    int hlit = getBits(z, 5) + 257;
+    int hdist = getBits(z, 5) + 1;
+    int hclen = getBits(z, 4) + 4;
+    memset(codeLengthSizes, 0, sizeof(codeLengthSizes));
+    for (i = 0; i < hclen; i++) codeLengthSizes[codeLengthOrder[i]] = (unsigned char)getBits(z, 3);
+    if (!buildHuffman(&codeLengths, codeLengthSizes, 19)) return 0;
+    n = 0;
+    while (n < hlit + hdist) {
+        int c = decodeSymbol(z, &codeLengths);
+        if (c < 0 || c >= 19) return 0;
+        if (c < 16) {
+            sizes[n++] = (unsigned char)c;
+        } else {
+            unsigned char fill = 0;
+            int repeat;
+            if (c == 16) {
+                if (n == 0) return 0;
+                repeat = getBits(z, 2) + 3;
+                fill = sizes[n - 1];
+            } else if (c == 17) {
+                repeat = getBits(z, 3) + 3;
+            } else {
+                repeat = getBits(z, 7) + 11;
+            }
+            if (n + repeat > hlit + hdist) return 0;
+            memset(sizes + n, fill, repeat);
+            n += repeat;
+        }
+        if (inputOverrun(z)) return 0;
+    }
+    if (sizes[256] == 0) return 0; // end of block code is required
+    if (!buildHuffman(&z->lengths, sizes, hlit)) return 0;
+    return buildHuffman(&z->distances, sizes + hlit, hdist);
+}
+
+// Returns 0 to indicate corrupt input or a size mismatch
+static int inflate(const unsigned char *in, size_t inLen, unsigned char *out, size_t outLen) {
+    int final;
+    Inflater *z = (Inflater *)calloc(1, sizeof(Inflater));
+    if (!z) return 0;
+    z->in = in;
+    z->inLen = inLen;
+    z->out = out;
+    z->outLen = outLen;
+    do {
+        int ok;
+        final = getBits(z, 1);
+        switch (getBits(z, 2)) {
+            case 0:  ok = inflateStored(z); break;
+            case 1:  ok = buildFixedCodes(z) && inflateCodes(z); break;
+            case 2:  ok = buildDynamicCodes(z) && inflateCodes(z); break;
+            default: ok = 0;
+        }
+        if (!ok) {
+            free(z);
+            return 0;
+        }
+    } while (!final);
+    final = z->outPos == outLen;
+    free(z);
+    return final;
+}
+
+// -------------------------------------------------------------------------
+// Memory mapping of the archive
+
+static const unsigned char *mapFile(const char *path, size_t *size) {
+#ifdef _WIN32
+    void *data;
+    LARGE_INTEGER fileSize;
+    HANDLE mapping;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+    mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return NULL;
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    *size = (size_t)fileSize.QuadPart;
+    return (const unsigned char *)data;
+#else /* _WIN32 */
+    void *data;
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return (const unsigned char *)data;
+#endif /* _WIN32 */
+}
+
+static void unmapFile(const unsigned char *data, size_t size) {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else /* _WIN32 */
+    munmap((void *)data, size);
+#endif /* _WIN32 */
+}
+
+// -------------------------------------------------------------------------
+// Central directory
+
+// Returns 0 to indicate failure
+static int findCentralDirectory(ZipArchive *za, unsigned long long *cdOffset,
+                                unsigned long long *cdSize, unsigned long long *nEntries) {
+    const unsigned char *p;
+    const unsigned char *end = za->data + za->size;
+    const unsigned char *stop;
+    if (za->size < END_OF_CD_SIZE) return 0;
+    // the end of central directory record is followed only by the archive comment
+    stop = za->size > END_OF_CD_SIZE + MAX_COMMENT_SIZE ? end - END_OF_CD_SIZE - MAX_COMMENT_SIZE : za->data;
+    for (p = end - END_OF_CD_SIZE; p >= stop; p--) {
+        if (readU32(p) == SIG_END_OF_CD) break;
+    }
+    if (p < stop) return 0;
+    *nEntries = readU16(p + 10);
+    *cdSize = readU32(p + 12);
+    *cdOffset = readU32(p + 16);
+
+    // ZIP64: the locator immediately precedes the end of central directory record
+    if (p - za->data >= ZIP64_LOCATOR_SIZE && readU32(p - ZIP64_LOCATOR_SIZE) == SIG_ZIP64_LOCATOR) {
+        unsigned long long offset = readU64(p - ZIP64_LOCATOR_SIZE + 8);
+        if (offset + ZIP64_END_OF_CD_SIZE <= za->size
+                && readU32(za->data + offset) == SIG_ZIP64_END_OF_CD) {
+            const unsigned char *z64 = za->data + offset;
+            *nEntries = readU64(z64 + 32);
+            *cdSize = readU64(z64 + 40);
+            *cdOffset = readU64(z64 + 48);
+        }
+    }
+    return *cdOffset <= za->size && *cdSize <= za->size - *cdOffset;
+}
+
+// Replaces sizes and offset marked with 0xFFFFFFFF by the values of the ZIP64 extra field
+static void readZip64Extra(ZipEntry *entry, const unsigned char *extra, unsigned int extraLen) {
+    const unsigned char *end = extra + extraLen;
+    while (extra + 4 <= end) {
+        unsigned int id = readU16(extra);
+        unsigned int len = readU16(extra + 2);
+        const unsigned char *field = extra + 4;
+        const unsigned char *fieldEnd = field + len;
+        if (fieldEnd > end) return;
+        if (id == 0x0001) {
+            if (entry->size == 0xFFFFFFFFUL && field + 8 <= fieldEnd) {
+                entry->size = readU64(field);
+                field += 8;
+            }
+            if (entry->compressedSize == 0xFFFFFFFFUL && field + 8 <= fieldEnd) {
+                entry->compressedSize = readU64(field);
+                field += 8;
+            }
+            if (entry->localHeaderOffset == 0xFFFFFFFFUL && field + 8 <= fieldEnd) {
+                entry->localHeaderOffset = readU64(field);
+            }
+            return;
+        }
+        extra = fieldEnd;
+    }
+}
+
+static void freeEntries(ZipArchive *za) {
+    int i;
+    for (i = 0; i < za->nEntries; i++) free(za->entries[i].name);
+    free(za->entries);
+    za->entries = NULL;
+    za->nEntries = 0;
+}
+
+// Returns 0 to indicate failure
+static int readCentralDirectory(ZipArchive *za) {
+    unsigned long long cdOffset, cdSize, n, i;
+    const unsigned char *p, *end;
+    if (!findCentralDirectory(za, &cdOffset, &cdSize, &n)) return 0;
+    // each central directory record takes at least CENTRAL_HEADER_SIZE bytes
+    if (n > cdSize / CENTRAL_HEADER_SIZE) return 0;
+    za->entries = (ZipEntry *)calloc((size_t)(n ? n : 1), sizeof(ZipEntry));
+    if (!za->entries) return 0;
+    p = za->data + cdOffset;
+    end = p + cdSize;
+    for (i = 0; i < n; i++) {
+        ZipEntry *entry = &za->entries[i];
+        unsigned int nameLen, extraLen, commentLen;
+        if (p + CENTRAL_HEADER_SIZE > end || readU32(p) != SIG_CENTRAL_HEADER) return 0;
+        nameLen = readU16(p + 28);
+        extraLen = readU16(p + 30);
+        commentLen = readU16(p + 32);
+        if (p + CENTRAL_HEADER_SIZE + nameLen + extraLen + commentLen > end) return 0;
+        entry->flags = readU16(p + 8);
+        entry->method = readU16(p + 10);
+        entry->crc32 = readU32(p + 16);
+        entry->compressedSize = readU32(p + 20);
+        entry->size = readU32(p + 24);
+        entry->localHeaderOffset = readU32(p + 42);
+        entry->name = (char *)malloc(nameLen + 1);
+        if (!entry->name) return 0;
+        memcpy(entry->name, p + CENTRAL_HEADER_SIZE, nameLen);
+        entry->name[nameLen] = '\0';
+        za->nEntries++;
+        readZip64Extra(entry, p + CENTRAL_HEADER_SIZE + nameLen, extraLen);
+        p += CENTRAL_HEADER_SIZE + nameLen + extraLen + commentLen;
+    }
+    return 1;
+}
+
+ZipArchive *zipOpen(const char *zipPath) {
+    ZipArchive *za = (ZipArchive *)calloc(1, sizeof(ZipArchive));
+    if (!za) {
+        printf("error: Out of memory\n");
+        return NULL;
+    }
+    za->data = mapFile(zipPath, &za->size);
+    if (!za->data) {
+        printf("error: Could not open %s\n", zipPath);
+        free(za);
+        return NULL;
+    }
+    if (!readCentralDirectory(za)) {
+        printf("error: %s is not a valid zip archive\n", zipPath);
+        zipClose(za);
+        return NULL;
+    }
+    return za;
+}
+
+void zipClose(ZipArchive *za) {
+    if (!za) return;
+    freeEntries(za);
+    if (za->data) unmapFile(za->data, za->size);
+    free(za);
+}
+
+int zipGetEntryCount(ZipArchive *za) {
+    return za->nEntries;
+}
+
+const ZipEntry *zipGetEntry(ZipArchive *za, int index) {
+    if (index < 0 || index >= za->nEntries) return NULL;
+    return &za->entries[index];
+}
+
+const ZipEntry *zipFindEntry(ZipArchive *za, const char *name) {
+    int i;
+    for (i = 0; i < za->nEntries; i++) {
+        if (!strcmp(za->entries[i].name, name)) return &za->entries[i];
+    }
+    return NULL;
+}
+
+// -------------------------------------------------------------------------
+// Extraction
+
+// Returns a pointer to the compressed data of the entry, NULL on error
+static const unsigned char *getEntryData(ZipArchive *za, const ZipEntry *entry) {
+    const unsigned char *p;
+    unsigned long long start;
+    // an archive of only an end of central directory record is shorter than a local header
+    if (za->size < LOCAL_HEADER_SIZE || entry->localHeaderOffset > za->size - LOCAL_HEADER_SIZE) return NULL;
+    p = za->data + entry->localHeaderOffset;
+    if (readU32(p) != SIG_LOCAL_HEADER) return NULL;
+    // name and extra field of the local header may differ from the central directory
+    start = entry->localHeaderOffset + LOCAL_HEADER_SIZE + readU16(p + 26) + readU16(p + 28);
+    if (start > za->size || entry->compressedSize > za->size - start) return NULL;
+    return za->data + start;
+}
+
+// Returns 0 to indicate failure
+static int extractTo(ZipArchive *za, const ZipEntry *entry, unsigned char *out) {
+    const unsigned char *data;
+    if (entry->flags & FLAG_ENCRYPTED) {
+        printf("error: Encrypted zip entry %s is not supported\n", entry->name);
+        return 0;
+    }
+    data = getEntryData(za, entry);
+    if (!data) {
+        printf("error: Zip entry %s is corrupt\n", entry->name);
+        return 0;
+    }
+    switch (entry->method) {
+        case ZIP_METHOD_STORED:
+            if (entry->compressedSize != entry->size) {
+                printf("error: Zip entry %s is corrupt\n", entry->name);
+                return 0;
+            }
+            memcpy(out, data, (size_t)entry->size);
+            break;
+        case ZIP_METHOD_DEFLATE:
+            if (!inflate(data, (size_t)entry->compressedSize, out, (size_t)entry->size)) {
+                printf("error: Could not inflate zip entry %s\n", entry->name);
+                return 0;
+            }
+            break;
+        default:
+            printf("error: Compression method %d of zip entry %s is not supported\n", entry->method, entry->name);
+            return 0;
+    }
+    if (crc32(out, (size_t)entry->size) != entry->crc32) {
+        printf("error: CRC mismatch for zip entry %s\n", entry->name);
+        return 0;
+    }
+    return 1;
+}
+
+void *zipExtractToMemory(ZipArchive *za, const ZipEntry *entry, size_t *size) {
+    unsigned char *out;
+    if (entry->size >= (size_t)-1) {
+        printf("error: Zip entry %s is too large\n", entry->name);
+        return NULL;
+    }
+    out = (unsigned char *)malloc((size_t)entry->size + 1);
+    if (!out) {
+        printf("error: Out of memory\n");
+        return NULL;
+    }
+    if (!extractTo(za, entry, out)) {
+        free(out);
+        return NULL;
+    }
+    out[entry->size] = '\0';
+    if (size) *size = (size_t)entry->size;
+    return out;
+}
+
+int zipExtractToFile(ZipArchive *za, const ZipEntry *entry, const char *path) {
+    size_t size;
+    int ok;
+    FILE *file;
+    void *data = zipExtractToMemory(za, entry, &size);
+    if (!data) return 0;
+    file = fopen(path, "wb");
+    if (!file) {
+        printf("error: Could not write %s\n", path);
+        free(data);
+        return 0;
+    }
+    ok = fwrite(data, 1, size, file) == size;
+    ok = (fclose(file) == 0) && ok;
+    free(data);
+    if (!ok) printf("error: Could not write %s\n", path);
+    return ok;
+}
+
+// Entries must stay inside the output directory
+static int isSafeName(const char *name) {
+    const char *p = name;
+    if (name[0] == '/' || name[0] == '\\' || strchr(name, ':')) return 0;
+    while (*p) {
+        if (p[0] == '.' && p[1] == '.' && (p[2] == '/' || p[2] == '\\' || p[2] == '\0')
+                && (p == name || p[-1] == '/' || p[-1] == '\\')) {
+            return 0;
+        }
+        p++;
+    }
+    return 1;
+}
+
+static int makeDir(const char *path) {
+#ifdef _WIN32
+    return _mkdir(path) == 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else /* _WIN32 */
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+#endif /* _WIN32 */
+}
+
+// Creates all directories of path up to the last separator.
+// Starts at offset 'from' since the directories before exist already.
+static int makeParentDirs(char *path, size_t from) {
+    char *p;
+    for (p = path + from; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            char c = *p;
+            *p = '\0';
+            if (!makeDir(path)) {
+                printf("error: Could not create directory %s\n", path);
+                *p = c;
+                return 0;
+            }
+            *p = c;
+        }
+    }
+    return 1;
+}
+
+// Creates outDir itself, its parent directories must exist
+static int makeOutDir(const char *outDir) {
+    size_t outLen = strlen(outDir);
+    char *dir = strdup(outDir);
+    int ok;
+    if (!dir) {
+        printf("error: Out of memory\n");
+        return 0;
+    }
+    if (outLen > 1) dir[outLen - 1] = '\0';
+    ok = makeDir(dir);
+    if (!ok) printf("error: Could not create directory %s\n", dir);
+    free(dir);
+    return ok;
+}
+
+// Extracts the entry below outDir, which exists already
+static int extractBelow(ZipArchive *za, const ZipEntry *entry, const char *outDir) {
+    size_t outLen = strlen(outDir);
+    size_t nameLen = strlen(entry->name);
+    char *path;
+    int ok;
+    if (!isSafeName(entry->name)) {
+        printf("error: Illegal path %s in zip archive\n", entry->name);
+        return 0;
+    }
+    path = (char *)malloc(outLen + nameLen + 1);
+    if (!path) {
+        printf("error: Out of memory\n");
+        return 0;
+    }
+    memcpy(path, outDir, outLen);
+    memcpy(path + outLen, entry->name, nameLen + 1);
+    ok = makeParentDirs(path, outLen);
+    // directory entries end with '/', their directory is created above
+    if (ok && nameLen > 0 && entry->name[nameLen - 1] != '/') {
+        ok = zipExtractToFile(za, entry, path);
+    }
+    free(path);
+    return ok;
+}
+
+int zipExtractEntry(ZipArchive *za, const ZipEntry *entry, const char *outDir) {
+    return makeOutDir(outDir) && extractBelow(za, entry, outDir);
+}
+
+int zipExtractDir(ZipArchive *za, const char *prefix, const char *outDir) {
+    int i;
+    int outDirMade = 0;
+    size_t prefixLen = strlen(prefix);
+    for (i = 0; i < za->nEntries; i++) {
+        const ZipEntry *entry = &za->entries[i];
+        if (strncmp(entry->name, prefix, prefixLen)) continue;
+        // outDir is created only if there is something to extract
+        if (!outDirMade && !makeOutDir(outDir)) return 0;
+        outDirMade = 1;
+        if (!extractBelow(za, entry, outDir)) return 0;
+    }
+    return 1;
+}
+
+int zipExtractAll(ZipArchive *za, const char *outDir) {
+    return zipExtractDir(za, "", outDir);
+}
@@ -0,0 +1,242 @@
+/* -------------------------------------------------------------------------
+ * bench_parser.cpp
+ * Measures parsing of a model description, in full, in full on one thread
+ * per core and only the sections used by the simulators, loading these
+ * sections from the binary cache of the model description, building the
+ * dependency matrix of its outputs, and the classification of its element
+ * and attribute names compared to the linear strcmp search done before the
+ * names were looked up in perfect hash tables.
+ * Command syntax: bench_parser <modelDescription.xml> [<n>]
+ *             or: bench_parser -v <variables> [<n>]
+ * The second form generates a model description with the given number of
+ * variables, every fourth with a tool annotation and every fourth an output
+ * that depends on the two variables before it. Parses the model
+ * description n times (default 10) and prints the mean time per parse and
+ * per classified name. The model description and its cache are written to
+ * bench_parser.xml and bench_parser.bin in the current directory, and
+ * removed at the end.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "fmu20/XmlParser.h"
+#include "fmu20/XmlReader.h"
+#include "XmlParserCApi.h"
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Returns a model description with n variables of all types
+static std::string generate(int n) {
+    std::string xml;
+    char line[512]; // the longest line, of a Real with Annotations, is about 320 chars
+    xml += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           "<fmiModelDescription fmiVersion=\"2.0\" modelName=\"bench\" guid=\"{bench}\" "
+           "numberOfEventIndicators=\"0\">\n"
+           "<ModelExchange modelIdentifier=\"bench\"/>\n"
+           "<UnitDefinitions><Unit name=\"m\"><BaseUnit m=\"1\"/></Unit></UnitDefinitions>\n"
+           "<TypeDefinitions><SimpleType name=\"Mode\"><Enumeration>"
+           "<Item name=\"off\" value=\"1\"/><Item name=\"on\" value=\"2\"/>"
+           "</Enumeration></SimpleType></TypeDefinitions>\n"
+           "<ModelVariables>\n";
+    for (int i = 0; i < n; i++) {
+        switch (i % 4) {
+            case 0:
+                snprintf(line, sizeof(line), "<ScalarVariable name=\"x%d\" valueReference=\"%d\" description=\"state %d\" "
+                    "causality=\"local\" variability=\"continuous\" initial=\"exact\">"
+                    "<Real start=\"1\" unit=\"m\" nominal=\"2\"/><Annotations><Tool name=\"bench\">"
+                    "<Plot color=\"red\" width=\"2\"/><Plot color=\"blue\" width=\"1\"/></Tool></Annotations>"
+                    "</ScalarVariable>\n", i, i, i);
+                break;
+            case 1:
+                snprintf(line, sizeof(line), "<ScalarVariable name=\"k%d\" valueReference=\"%d\" causality=\"parameter\" "
+                    "variability=\"fixed\" initial=\"exact\"><Integer start=\"%d\" min=\"0\"/>"
+                    "</ScalarVariable>\n", i, i, i);
+                break;
+            case 2:
+                snprintf(line, sizeof(line), "<ScalarVariable name=\"b%d\" valueReference=\"%d\" causality=\"output\" "
+                    "variability=\"discrete\"><Boolean/></ScalarVariable>\n", i, i);
+                break;
+            default:
+                snprintf(line, sizeof(line), "<ScalarVariable name=\"e%d\" valueReference=\"%d\" causality=\"input\" "
+                    "variability=\"discrete\"><Enumeration declaredType=\"Mode\" start=\"1\"/>"
+                    "</ScalarVariable>\n", i, i);
+        }
+        xml += line;
+    }
+    xml += "</ModelVariables>\n<ModelStructure>\n<Outputs>\n";
+    for (int i = 2; i < n; i += 4) {
+        snprintf(line, sizeof(line), "<Unknown index=\"%d\" dependencies=\"%d %d\" dependenciesKind=\"dependent fixed\"/>\n",
+            i + 1, i - 1, i);
+        xml += line;
+    }
+    xml += "</Outputs>\n</ModelStructure>\n</fmiModelDescription>\n";
+    return xml;
+}
+
+static bool readFile(const char *path, std::string &xml) {
+    char buffer[65536];
+    size_t n;
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        xml.append(buffer, n);
+    }
+    fclose(file);
+    return true;
+}
+
+// Collects the element and attribute names of xml in document order,
+// except the tool specific ones inside Tool elements
+static void collectNames(const std::string &xml, std::vector<std::string> &elements,
+                         std::vector<std::string> &attributes) {
+    XmlReader reader(xml.data(), xml.size(), "bench");
+    while (reader.read()) {
+        if (reader.getNodeType() != XmlReader::nodeElement) continue;
+        elements.push_back(reader.getLocalName());
+        for (int i = 0; i < reader.getAttributeCount(); i++) {
+            const XmlReader::Attribute &att = reader.getAttribute(i);
+            attributes.push_back(std::string(att.name, att.nameLength));
+        }
+        if (!strcmp(reader.getLocalName(), "Tool") && !reader.isEmptyElement()) {
+            reader.skipElement();
+        }
+    }
+}
+
+// The search done by XmlParser before it used perfect hash tables
+static int linearSearch(const char *name, const char *array[], int n) {
+    for (int i = 0; i < n; i++) {
+        if (!strcmp(name, array[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Returns the time to classify all names, in seconds, and adds the indexes to sum
+static double classify(const std::vector<std::string> &elements, const std::vector<std::string> &attributes,
+                       bool hashed, long *sum) {
+    double start = now();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const char *name = elements[i].c_str();
+        *sum += hashed ? XmlParser::checkElement(name)
+                       : linearSearch(name, XmlParser::elmNames, XmlParser::SIZEOF_ELM);
+    }
+    for (size_t i = 0; i < attributes.size(); i++) {
+        const char *name = attributes[i].c_str();
+        *sum += hashed ? XmlParser::checkAttribute(name)
+                       : linearSearch(name, XmlParser::attNames, XmlParser::SIZEOF_ATT);
+    }
+    return now() - start;
+}
+
+int main(int argc, char *argv[]) {
+    int n = 10;
+    int arg = 2;
+    std::string xml;
+    std::vector<std::string> elements, attributes;
+    double linear = 0, hashed = 0, parsing = 0, parsingThreads = 0, parsingSections = 0, loading = 0, building = 0;
+    const char *xmlPath = "bench_parser.xml";
+    const char *cachePath = "bench_parser.bin";
+    const int sections = sec_DefaultExperiment | sec_ModelVariables | sec_ModelStructure;
+    long sumLinear = 0, sumHashed = 0;
+
+    if (argc > 2 && !strcmp(argv[1], "-v")) {
+        xml = generate(atoi(argv[2]));
+        arg = 3;
+    } else if (argc < 2 || !readFile(argv[1], xml)) {
+        printf("usage: %s <modelDescription.xml> [<n>]\n", argv[0]);
+        printf("       %s -v <variables> [<n>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > arg) n = atoi(argv[arg]);
+    if (n <= 0) {
+        printf("error: n must be positive\n");
+        return EXIT_FAILURE;
+    }
+    collectNames(xml, elements, attributes);
+    FILE *file = fopen(xmlPath, "wb");
+    if (!file || fwrite(xml.data(), 1, xml.size(), file) != xml.size() || fclose(file)) {
+        printf("error: Could not write %s\n", xmlPath);
+        return EXIT_FAILURE;
+    }
+    remove(cachePath);
+    // the first parse writes the cache, later ones load it
+    freeModelDescription(parseWithCache((char *)xmlPath, cachePath, sections));
+    for (int i = 0; i < n; i++) {
+        double start = now();
+        ModelDescription *md = parseFromMemory((char *)"bench.xml", xml.data(), (int)xml.size());
+        parsing += now() - start;
+        if (!md) {
+            printf("error: Could not parse the model description\n");
+            return EXIT_FAILURE;
+        }
+        freeModelDescription(md);
+        setParserThreads(0);
+        start = now();
+        md = parseFromMemory((char *)"bench.xml", xml.data(), (int)xml.size());
+        parsingThreads += now() - start;
+        setParserThreads(1);
+        if (!md) {
+            printf("error: Could not parse the model description on threads\n");
+            return EXIT_FAILURE;
+        }
+        freeModelDescription(md);
+        start = now();
+        md = parseSectionsFromMemory((char *)"bench.xml", xml.data(), (int)xml.size(), sections);
+        parsingSections += now() - start;
+        if (!md) {
+            printf("error: Could not parse the sections of the model description\n");
+            return EXIT_FAILURE;
+        }
+        freeModelDescription(md);
+        start = now();
+        md = parseWithCache((char *)xmlPath, cachePath, sections);
+        loading += now() - start;
+        if (!md) {
+            printf("error: Could not load the model description from its cache\n");
+            return EXIT_FAILURE;
+        }
+        start = now();
+        DependencyMatrix *dm = buildDependencyMatrix(md, elm_Outputs);
+        building += now() - start;
+        if (!dm) {
+            printf("error: Could not build the dependency matrix of the outputs\n");
+            return EXIT_FAILURE;
+        }
+        freeDependencyMatrix(dm);
+        freeModelDescription(md);
+        linear += classify(elements, attributes, false, &sumLinear);
+        hashed += classify(elements, attributes, true, &sumHashed);
+    }
+    remove(xmlPath);
+    remove(cachePath);
+    if (sumLinear != sumHashed) {
+        printf("error: Names classified differently\n");
+        return EXIT_FAILURE;
+    }
+    size_t names = elements.size() + attributes.size();
+    printf("model description of %lu bytes with %lu elements and %lu attributes, mean of %d runs\n",
+        (unsigned long)xml.size(), (unsigned long)elements.size(), (unsigned long)attributes.size(), n);
+    printf("  parse:               %10.3f ms\n", parsing / n * 1000);
+    printf("  parse on threads:    %10.3f ms\n", parsingThreads / n * 1000);
+    printf("  parse sections used\n");
+    printf("    by simulators:     %10.3f ms\n", parsingSections / n * 1000);
+    printf("    from cache:        %10.3f ms\n", loading / n * 1000);
+    printf("  build dependencies\n");
+    printf("    of outputs:        %10.3f ms\n", building / n * 1000);
+    printf("  classify names:\n");
+    printf("    linear search:     %10.3f ms  %6.1f ns/name\n", linear / n * 1000, linear / n / names * 1e9);
+    printf("    perfect hash:      %10.3f ms  %6.1f ns/name\n", hashed / n * 1000, hashed / n / names * 1e9);
+    printf("    speedup:           %10.1fx\n", linear / hashed);
+    return EXIT_SUCCESS;
+}
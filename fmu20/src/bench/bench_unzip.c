@@ -0,0 +1,79 @@
+/* -------------------------------------------------------------------------
+ * bench_unzip.c
+ * Measures the time to unpack an FMU with the built-in zip reader,
+ * compared to starting the external unzip tool as done before.
+ * Command syntax: bench_unzip <fmu> [<n>]
+ * Unpacks the given FMU n times (default 50) with each method into a
+ * fresh temporary directory and prints the mean time per unpack.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "fmi2.h"
+#include "sim_support.h"
+
+FMU fmu; // referenced by sim_support.c
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Returns the mean time per unpack in seconds, or -1 to indicate failure
+static double run(const char *label, int (*unpack)(const char *, const char *),
+                  const char *fmuPath, int n) {
+    int i;
+    double total = 0;
+    char cmd[64];
+    for (i = 0; i < n; i++) {
+        double start;
+        int ok;
+        char outPath[32];
+        char *tmp;
+        strcpy(outPath, "benchTmpXXXXXX");
+        tmp = mkdtemp(outPath);
+        if (!tmp) {
+            printf("error: Could not create temporary directory\n");
+            return -1;
+        }
+        strcat(outPath, "/");
+        start = now();
+        ok = unpack(fmuPath, outPath);
+        total += now() - start;
+        sprintf(cmd, "rm -rf %s", outPath);
+        system(cmd);
+        if (!ok) {
+            printf("error: %s failed to unpack %s\n", label, fmuPath);
+            return -1;
+        }
+    }
+    return total / n;
+}
+
+int main(int argc, char *argv[]) {
+    int n = 50;
+    double builtIn, tool;
+    if (argc < 2) {
+        printf("usage: %s <fmu> [<n>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 2) n = atoi(argv[2]);
+    if (n <= 0) {
+        printf("error: n must be positive\n");
+        return EXIT_FAILURE;
+    }
+    // the external tool prints its command line, keep the measurement output apart
+    tool = run("unzip tool", unzipWithTool, argv[1], n);
+    builtIn = run("zip reader", unzip, argv[1], n);
+    if (tool < 0 || builtIn < 0) return EXIT_FAILURE;
+    printf("unpacking %s, mean of %d runs\n", argv[1], n);
+    printf("  zip reader: %10.3f ms\n", builtIn * 1000);
+    printf("  unzip tool: %10.3f ms\n", tool * 1000);
+    printf("  speedup:    %10.1fx\n", tool / builtIn);
+    return EXIT_SUCCESS;
+}
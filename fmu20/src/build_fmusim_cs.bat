@@ -39,13 +39,13 @@ if defined VS80COMNTOOLS (call "%VS80COMNTOOLS%\vsvars32.bat") else ^
 goto noCompiler
 )
 
-set SRC=main.c ..\shared\sim_support.c ..\shared\xmlVersionParser.c ..\shared\parser\XmlParser.cpp ..\shared\parser\XmlElement.cpp ..\shared\parser\XmlParserCApi.cpp
+set SRC=main.c ..\shared\sim_support.c ..\shared\zip_reader.c ..\shared\unpack_cache.c ..\shared\number_format.cpp ..\shared\parser\XmlParser.cpp ..\shared\parser\XmlArena.cpp ..\shared\parser\XmlDependencyMatrix.cpp ..\shared\parser\XmlElement.cpp ..\shared\parser\XmlModelCache.cpp ..\shared\parser\XmlParserCApi.cpp ..\shared\parser\XmlReader.cpp ..\shared\parser\XmlVariableTable.cpp ..\shared\result_pyramid.cpp ..\shared\result_store.cpp ..\shared\result_summary.cpp ..\shared\result_writer.cpp
 set INC=/I..\shared\include /I..\shared /I..\shared\parser
-set OPTIONS=/DFMI_COSIMULATION /nologo /EHsc /DSTANDALONE_XML_PARSER /DLIBXML_STATIC
+set OPTIONS=/DFMI_COSIMULATION /nologo /EHsc /std:c++17 /DSTANDALONE_XML_PARSER
 
 rem create fmusim_cs.exe in co_simulation dir
 pushd co_simulation
-cl %SRC% %INC% %OPTIONS% /Fefmusim_cs.exe /link /LIBPATH:..\shared\parser\%x64%
+cl %SRC% %INC% %OPTIONS% /Fefmusim_cs.exe
 del *.obj
 popd
 if not exist co_simulation\fmusim_cs.exe goto compileError
@@ -20,7 +20,6 @@
  *
  * Free libraries and tools used to implement this simulator:
  *  - header files from the FMI specification
- *  - libxml2 XML parser, see http://xmlsoft.org
  *  - 7z.exe 4.57 zip and unzip tool, see http://www.7-zip.org
  * Author: Adrian Tirea
  * Copyright QTronic GmbH. All rights reserved.
@@ -78,6 +77,10 @@ static int simulate(FMU* fmu, double tEnd, double h, fmi2Boolean loggingOn, char
         toleranceDefined = fmi2True;
     }
 
+    // the rest of the simulation uses fmu->variables only
+    freeModelDescription(md);
+    fmu->modelDescription = NULL;
+
     fmi2Flag = fmu->setupExperiment(c, toleranceDefined, tolerance, tStart, fmi2True, tEnd);
     if (fmi2Flag > fmi2Warning) {
         return error("could not initialize model; failed FMI setup experiment");
@@ -92,8 +95,8 @@ static int simulate(FMU* fmu, double tEnd, double h, fmi2Boolean loggingOn, char
     }
 
     // open result file
-    if (!(file = fopen(RESULT_FILE, "w"))) {
-        printf("could not write %s because:\n", RESULT_FILE);
+    if (!(file = openResultFile())) {
+        printf("could not write %s because:\n", getResultFileName());
         printf("    %s\n", strerror(errno));
         return 0; // failure
     }
@@ -130,6 +133,7 @@ static int simulate(FMU* fmu, double tEnd, double h, fmi2Boolean loggingOn, char
     // end simulation
     fmu->terminate(c);
     fmu->freeInstance(c);
+    finishOutput(fmu);
     fclose(file);
 
     // print simulation summary
@@ -163,7 +167,8 @@ int main(int argc, char *argv[]) {
     printf("}\n");
 
     simulate(&fmu, tEnd, h, loggingOn, csv_separator, nCategories, categories);
-    printf("CSV file '%s' written\n", RESULT_FILE);
+    finishOutput(&fmu); // write the rows of a simulation that stopped with an error
+    printf("%s file '%s' written\n", getResultFormatName(), getResultFileName());
 
     // release FMU
 #if WINDOWS
@@ -172,6 +177,8 @@ int main(int argc, char *argv[]) {
     dlclose(fmu.dllHandle);
 #endif /* WINDOWS */
     freeModelDescription(fmu.modelDescription);
+    freeVariableTable(fmu.variables);
+    freeOutputPlan(fmu.outputPlan);
     if (categories) free(categories);
 
     // delete temp files obtained by unzipping the FMU
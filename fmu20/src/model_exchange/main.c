@@ -19,7 +19,6 @@
  *
  * Free libraries and tools used to implement this simulator:
  *  - header files from the FMU specification
- *  - libxml2 XML parser, see http://xmlsoft.org
  *  - 7z.exe 4.57 zip and unzip tool, see http://www.7-zip.org
  * Author: Adrian Tirea
  * Copyright QTronic GmbH. All rights reserved.
@@ -87,6 +86,9 @@ static int simulate(FMU* fmu, double tEnd, double h, fmi2Boolean loggingOn, char
     nx = getDerivativesSize(getModelStructure(md)); // number of continuous states is number of derivatives
                                                     // declared in model structure
     nz = getAttributeInt((Element *)md, att_numberOfEventIndicators, &vs); // number of event indicators
+    // the rest of the simulation uses fmu->variables only
+    freeModelDescription(md);
+    fmu->modelDescription = NULL;
     x    = (double *) calloc(nx, sizeof(double));
     xdot = (double *) calloc(nx, sizeof(double));
     if (nz>0) {
@@ -96,8 +98,8 @@ static int simulate(FMU* fmu, double tEnd, double h, fmi2Boolean loggingOn, char
     if ((!x || !xdot) || (nz>0 && (!z || !prez))) return error("out of memory");
 
     // open result file
-    if (!(file = fopen(RESULT_FILE, "w"))) {
-        printf("could not write %s because:\n", RESULT_FILE);
+    if (!(file = openResultFile())) {
+        printf("could not write %s because:\n", getResultFileName());
         printf("    %s\n", strerror(errno));
         free (x);
         free(xdot);
@@ -185,16 +187,19 @@ static int simulate(FMU* fmu, double tEnd, double h, fmi2Boolean loggingOn, char
                 fmu->enterEventMode(c);
                 if (timeEvent) {
                     nTimeEvents++;
+                    outputEvent(OUTPUT_TIME_EVENT);
                     if (loggingOn) printf("time event at t=%.16g\n", time);
                 }
                 if (stateEvent) {
                     nStateEvents++;
+                    outputEvent(OUTPUT_STATE_EVENT);
                     if (loggingOn) for (i=0; i<nz; i++)
                         printf("state event %s z[%d] at t=%.16g\n",
                                (prez[i]>0 && z[i]<0) ? "-\\-" : "-/-", i, time);
                 }
                 if (stepEvent) {
                     nStepEvents++;
+                    outputEvent(OUTPUT_STEP_EVENT);
                     if (loggingOn) printf("step event at t=%.16g\n", time);
                 }
 
@@ -229,6 +234,7 @@ static int simulate(FMU* fmu, double tEnd, double h, fmi2Boolean loggingOn, char
     // cleanup
     fmu->terminate(c);
     fmu->freeInstance(c);
+    finishOutput(fmu);
     fclose(file);
     if (x != NULL) free(x);
     if (xdot != NULL) free(xdot);
@@ -270,7 +276,8 @@ int main(int argc, char *argv[]) {
     printf("}\n");
 
     simulate(&fmu, tEnd, h, loggingOn, csv_separator, nCategories, categories);
-    printf("CSV file '%s' written\n", RESULT_FILE);
+    finishOutput(&fmu); // write the rows of a simulation that stopped with an error
+    printf("%s file '%s' written\n", getResultFormatName(), getResultFileName());
 
     // release FMU
 #if WINDOWS
@@ -279,6 +286,8 @@ int main(int argc, char *argv[]) {
     dlclose(fmu.dllHandle);
 #endif /* WINDOWS */
     freeModelDescription(fmu.modelDescription);
+    freeVariableTable(fmu.variables);
+    freeOutputPlan(fmu.outputPlan);
     if (categories) free(categories);
 
     // delete temp files obtained by unzipping the FMU
@@ -0,0 +1,235 @@
+/* -------------------------------------------------------------------------
+ * main.c
+ * Reads a compressed columnar result store written by fmusim_me or
+ * fmusim_cs with option -o format=fmr, or a pyramid written with option
+ * -o pyramid=on.
+ * Command syntax: fmuresult <result.fmr>
+ *             or: fmuresult <result.fmr> <name>...
+ * The first form lists the signals with their type, kind, min and max, read from
+ * the block headers without decoding any value. The second form writes
+ * time and the given signals in CSV format to stdout. Only the columns of
+ * these signals are decoded, slice by slice, so the memory used does not
+ * grow with the length of the simulation. Errors are reported on stderr.
+ * For a pyramid (.fmp), the first form lists the signals, the second form
+ * writes the min, max and mean of the given signals in ENVELOPE_PIXELS
+ * intervals of time in CSV format, reading about as many bins, whatever
+ * the length of the simulation.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "result_pyramid.h"
+#include "result_store.h"
+#include "number_format.h"
+
+// rows decoded at a time
+#define SLICE_ROWS 4096
+// intervals of the envelope of a pyramid
+#define ENVELOPE_PIXELS 1000
+
+static void printHelp(const char *fmuresult) {
+    printf("command syntax: %s <result.fmr> [<name>...]\n", fmuresult);
+    printf("   <result.fmr> ... result store written with -o format=fmr, or pyramid\n");
+    printf("                    written with -o pyramid=on, required\n");
+    printf("   <name> ......... signals to write as CSV to stdout, optional,\n");
+    printf("                    lists all signals if none is given\n");
+}
+
+static const char *typeName(int type) {
+    switch (type) {
+        case STORE_REAL:    return "Real";
+        case STORE_INTEGER: return "Integer";
+        default:            return "Boolean";
+    }
+}
+
+static const char *kindName(int kind) {
+    switch (kind) {
+        case STORE_CONSTANT: return "constant";
+        case STORE_DISCRETE: return "discrete";
+        default:             return "continuous";
+    }
+}
+
+static int listSignals(ResultStore *rs) {
+    char min[NUMBER_BUFSIZE], max[NUMBER_BUFSIZE];
+    double lo, hi;
+    int i;
+    printf("%lu rows\n", (unsigned long)getStoreRowCount(rs));
+    for (i = STORE_TIME; i < getStoreSignalCount(rs); i++) {
+        if (!getStoreSignalRange(rs, i, &lo, &hi)) return 0;
+        min[0] = max[0] = 0; // no rows
+        if (getStoreRowCount(rs)) {
+            min[formatDouble(min, lo, '.')] = 0;
+            max[formatDouble(max, hi, '.')] = 0;
+        }
+        if (i == STORE_TIME) {
+            printf("time Real continuous [%s, %s]\n", min, max);
+        } else {
+            printf("%s %s %s [%s, %s] %s\n", getStoreSignalName(rs, i), typeName(getStoreSignalType(rs, i)),
+                   kindName(getStoreSignalKind(rs, i)), min, max, getStoreSignalDescription(rs, i));
+        }
+    }
+    return 1;
+}
+
+static int writeSignals(ResultStore *rs, int n, const int *signals) {
+    char buffer[NUMBER_BUFSIZE];
+    size_t rows = getStoreRowCount(rs);
+    size_t first, r;
+    int i;
+    double *values = (double *)calloc((size_t)(n + 1) * SLICE_ROWS, sizeof(double));
+    if (!values) {
+        fprintf(stderr, "out of memory\n");
+        return 0;
+    }
+    printf("time");
+    for (i = 0; i < n; i++) printf(",%s", getStoreSignalName(rs, signals[i]));
+    printf("\n");
+    for (first = 0; first < rows; first += SLICE_ROWS) {
+        size_t slice = rows - first < SLICE_ROWS ? rows - first : SLICE_ROWS;
+        for (i = 0; i <= n; i++) {
+            if (!readStoreSignal(rs, i ? signals[i - 1] : STORE_TIME, first, slice, values + i * SLICE_ROWS)) {
+                free(values);
+                return 0;
+            }
+        }
+        for (r = 0; r < slice; r++) {
+            for (i = 0; i <= n; i++) {
+                if (i) putchar(',');
+                fwrite(buffer, 1, formatDouble(buffer, values[i * SLICE_ROWS + r], '.'), stdout);
+            }
+            putchar('\n');
+        }
+    }
+    free(values);
+    return 1;
+}
+
+static void listPyramid(ResultPyramid *rp) {
+    char start[NUMBER_BUFSIZE], end[NUMBER_BUFSIZE];
+    double t0, t1;
+    int i;
+    start[0] = end[0] = 0; // no rows
+    if (getPyramidTimeRange(rp, &t0, &t1)) {
+        start[formatDouble(start, t0, '.')] = 0;
+        end[formatDouble(end, t1, '.')] = 0;
+    }
+    printf("%lu rows, %d levels, time [%s, %s]\n", (unsigned long)getPyramidRowCount(rp),
+           getPyramidLevelCount(rp), start, end);
+    for (i = 0; i < getPyramidSignalCount(rp); i++) printf("%s\n", getPyramidSignalName(rp, i));
+}
+
+static int writeEnvelopes(ResultPyramid *rp, int n, const int *signals) {
+    char buffer[NUMBER_BUFSIZE];
+    double t0, t1;
+    int i, k, p;
+    // per signal min, max and mean of each pixel
+    double *values = (double *)calloc((size_t)n * 3 * ENVELOPE_PIXELS, sizeof(double));
+    if (!values) {
+        fprintf(stderr, "out of memory\n");
+        return 0;
+    }
+    printf("time");
+    for (i = 0; i < n; i++) {
+        const char *name = getPyramidSignalName(rp, signals[i]);
+        printf(",%s.min,%s.max,%s.mean", name, name, name);
+    }
+    printf("\n");
+    if (!getPyramidTimeRange(rp, &t0, &t1)) {
+        free(values);
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        double *v = values + (size_t)i * 3 * ENVELOPE_PIXELS;
+        if (!readPyramidEnvelope(rp, signals[i], t0, t1, ENVELOPE_PIXELS, v, v + ENVELOPE_PIXELS,
+                                 v + 2 * ENVELOPE_PIXELS)) {
+            free(values);
+            return 0;
+        }
+    }
+    for (p = 0; p < ENVELOPE_PIXELS; p++) {
+        // the start of the interval
+        fwrite(buffer, 1, formatDouble(buffer, t0 + (t1 - t0) * p / ENVELOPE_PIXELS, '.'), stdout);
+        for (i = 0; i < n; i++) {
+            for (k = 0; k < 3; k++) {
+                putchar(',');
+                fwrite(buffer, 1, formatDouble(buffer, values[((size_t)i * 3 + k) * ENVELOPE_PIXELS + p], '.'), stdout);
+            }
+        }
+        putchar('\n');
+    }
+    free(values);
+    return 1;
+}
+
+static int readPyramid(ResultPyramid *rp, int argc, char *argv[]) {
+    int *signals;
+    int i, ok;
+    if (argc == 2) {
+        listPyramid(rp);
+        return 1;
+    }
+    signals = (int *)calloc(argc - 2, sizeof(int));
+    if (!signals) {
+        fprintf(stderr, "out of memory\n");
+        return 0;
+    }
+    for (i = 0; i < argc - 2; i++) {
+        if ((signals[i] = findPyramidSignal(rp, argv[i + 2])) < 0) {
+            fprintf(stderr, "error: no signal %s in %s\n", argv[i + 2], argv[1]);
+            free(signals);
+            return 0;
+        }
+    }
+    ok = writeEnvelopes(rp, argc - 2, signals);
+    if (!ok) fprintf(stderr, "error: could not read %s\n", argv[1]);
+    free(signals);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    ResultStore *rs;
+    ResultPyramid *rp;
+    int *signals;
+    int i, ok;
+    if (argc < 2) {
+        printf("error: no result file\n");
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if ((rp = openResultPyramid(argv[1]))) {
+        ok = readPyramid(rp, argc, argv);
+        closeResultPyramid(rp);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (!(rs = openResultStore(argv[1]))) {
+        fprintf(stderr, "error: could not read result store or pyramid %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (argc == 2) {
+        ok = listSignals(rs);
+    } else {
+        signals = (int *)calloc(argc - 2, sizeof(int));
+        if (!signals) {
+            fprintf(stderr, "out of memory\n");
+            closeResultStore(rs);
+            return EXIT_FAILURE;
+        }
+        for (i = 0; i < argc - 2; i++) {
+            if ((signals[i] = findStoreSignal(rs, argv[i + 2])) < 0) {
+                fprintf(stderr, "error: no signal %s in %s\n", argv[i + 2], argv[1]);
+                free(signals);
+                closeResultStore(rs);
+                return EXIT_FAILURE;
+            }
+        }
+        ok = writeSignals(rs, argc - 2, signals);
+        free(signals);
+    }
+    if (!ok) fprintf(stderr, "error: could not read %s\n", argv[1]);
+    closeResultStore(rs);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -29,7 +29,10 @@
 #include "XmlParserCApi.h"
 
 typedef struct {
-    ModelDescription* modelDescription;
+    ModelDescription* modelDescription;  // NULL once the simulation has started
+    VariableTable* variables;            // the variables of the model description, decoded
+    struct OutputPlan* outputPlan;       // the columns of the result file, see result_writer.h
+    struct ResultWriter* resultWriter;   // NULL until the first row is output
 
     HMODULE dllHandle; // fmu.dll handle
     /***************************************************
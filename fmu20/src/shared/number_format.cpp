@@ -0,0 +1,132 @@
+/* -------------------------------------------------------------------------
+ * number_format.cpp
+ * Conversion of numbers to text for the result file. The shortest digits
+ * that read back exactly are taken from std::to_chars where the C++
+ * library provides it for floating-point numbers, its shortest round-trip
+ * conversion is several times faster than printf. Otherwise, the shortest
+ * of %.14e, %.15e and %.16e that reads back exactly is used. The digits are
+ * then laid out in fixed or exponential notation as by std::to_chars,
+ * writing the decimal point given, so that a decimal comma needs no pass
+ * over the text.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include "number_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define HAVE_TO_CHARS 1
+#else
+#define HAVE_TO_CHARS 0
+#endif
+
+// Writes d, given by its sign and digits, e.g. "15", with the exponent of the
+// first digit, e.g. -1 for 0.15, in fixed or exponential notation, whichever
+// is shorter, fixed if both are equally long, as std::to_chars does.
+static int layoutDigits(char *buffer, double d, int negative, const char *digits, int k, int exponent,
+                        char decimalPoint) {
+    char *p = buffer;
+    int absExponent = exponent < 0 ? -exponent : exponent;
+    int exponentLength = absExponent >= 100 ? 3 : 2;
+    int exponentialLength = k + (k > 1) + 2 + exponentLength;
+    int fixedLength = exponent < 0 ? 1 - exponent + k : k > exponent + 1 ? k + 1 : exponent + 1;
+    int i;
+#if HAVE_TO_CHARS
+    if (fixedLength <= exponentialLength && k <= exponent + 1) {
+        // an integer, with all its digits as std::to_chars writes it, e.g. 123456789012345683968
+        return (int)(std::to_chars(buffer, buffer + NUMBER_BUFSIZE, d, std::chars_format::fixed).ptr - buffer);
+    }
+#else
+    (void)d;
+#endif
+    if (negative) *p++ = '-';
+    if (fixedLength <= exponentialLength) {
+        if (exponent < 0) {
+            *p++ = '0';
+            *p++ = decimalPoint;
+            for (i = 1; i < -exponent; i++) *p++ = '0';
+            memcpy(p, digits, k);
+            p += k;
+        } else if (k > exponent + 1) {
+            memcpy(p, digits, exponent + 1);
+            p += exponent + 1;
+            *p++ = decimalPoint;
+            memcpy(p, digits + exponent + 1, k - exponent - 1);
+            p += k - exponent - 1;
+        } else {
+            memcpy(p, digits, k);
+            p += k;
+            for (i = k; i <= exponent; i++) *p++ = '0';
+        }
+    } else {
+        *p++ = digits[0];
+        if (k > 1) {
+            *p++ = decimalPoint;
+            memcpy(p, digits + 1, k - 1);
+            p += k - 1;
+        }
+        *p++ = 'e';
+        *p++ = exponent < 0 ? '-' : '+';
+        if (absExponent >= 100) *p++ = (char)('0' + absExponent / 100);
+        *p++ = (char)('0' + absExponent / 10 % 10);
+        *p++ = (char)('0' + absExponent % 10);
+    }
+    return (int)(p - buffer);
+}
+
+int formatDouble(char *buffer, double d, char decimalPoint) {
+    char text[NUMBER_BUFSIZE];
+    char digits[NUMBER_BUFSIZE];
+    const char *p = text;
+    int negative, n, k = 0;
+#if HAVE_TO_CHARS
+    if (decimalPoint == '.') {
+        // the layout of std::to_chars with its own decimal point
+        return (int)(std::to_chars(buffer, buffer + NUMBER_BUFSIZE, d).ptr - buffer);
+    }
+    n = (int)(std::to_chars(text, text + sizeof(text) - 1, d, std::chars_format::scientific).ptr - text);
+    text[n] = 0;
+#else
+    int precision;
+    for (precision = 15; ; precision++) {
+        n = snprintf(text, sizeof(text), "%.*e", precision - 1, d);
+        if (precision == 17 || strtod(text, NULL) == d) break;
+    }
+#endif
+    if (!(d - d == 0)) {
+        // inf or nan, no digits to lay out
+        memcpy(buffer, text, n);
+        return n;
+    }
+    // text is [-]d[.ddd]e(+|-)dd
+    negative = *p == '-';
+    if (negative) p++;
+    digits[k++] = *p++;
+    if (*p == '.') {
+        for (p++; *p != 'e'; p++) digits[k++] = *p;
+    }
+    while (k > 1 && digits[k - 1] == '0') k--; // %e pads with zeros
+    return layoutDigits(buffer, d, negative, digits, k, atoi(p + 1), decimalPoint);
+}
+
+int formatInt(char *buffer, int i) {
+    unsigned int u = i < 0 ? 0u - (unsigned int)i : (unsigned int)i;
+    char digits[NUMBER_BUFSIZE];
+    int k = 0;
+    int n = 0;
+    do {
+        digits[k++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (i < 0) buffer[n++] = '-';
+    while (k) buffer[n++] = digits[--k];
+    return n;
+}
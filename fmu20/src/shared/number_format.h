@@ -0,0 +1,32 @@
+/* -------------------------------------------------------------------------
+ * number_format.h
+ * Conversion of numbers to text for the result file, without printf.
+ * Doubles are written as the shortest text that reads back as exactly the
+ * same double, e.g. 0.1 and not 0.1000000000000000055511151231257827.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#ifndef NUMBER_FORMAT_H
+#define NUMBER_FORMAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// size of a buffer that holds any formatted number, incl. the terminating 0
+#define NUMBER_BUFSIZE 32
+
+// Writes d to buffer, with decimalPoint ('.' or ',') as decimal point.
+// Uses fixed or exponential notation, whichever is shorter, e.g. 1e-07.
+// buffer must have room for NUMBER_BUFSIZE chars. The text is not 0 terminated.
+// Returns the length of the text.
+int formatDouble(char *buffer, double d, char decimalPoint);
+
+// Writes i in decimal to buffer like formatDouble, returns the length of the text.
+int formatInt(char *buffer, int i);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // NUMBER_FORMAT_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlArena.cpp
+ * Block allocator and string pool holding a model description of a FMI 2.0
+ * model.
+ * ---------------------------------------------------------------------------*/
+
+#include "fmu20/XmlArena.h"
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_SIZE 65536
+#define ALIGNMENT 8
+// requests above this size get a block of their own, to waste little of the current block
+#define LARGE_SIZE (BLOCK_SIZE / 4)
+#define INITIAL_POOL_SIZE 256
+
+static size_t hashString(const char *s, size_t length) {
+    // FNV-1a
+    size_t h = (size_t)2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// true if the 0 terminated string pooled equals s of given length
+static bool equalString(const char *pooled, const char *s, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (pooled[i] != s[i] || !pooled[i]) return false;
+    }
+    return pooled[length] == 0;
+}
+
+XmlArena::XmlArena() {
+    next = NULL;
+    left = 0;
+    pooled = 0;
+}
+
+XmlArena::~XmlArena() {
+    for (std::vector<char *>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+        free(*it);
+    }
+}
+
+char *XmlArena::allocateBlock(size_t size) {
+    char *block = (char *)malloc(size);
+    if (!block) throw std::bad_alloc();
+    try {
+        blocks.push_back(block);
+    } catch (std::bad_alloc& ) {
+        free(block);
+        throw;
+    }
+    return block;
+}
+
+void *XmlArena::allocate(size_t size) {
+    size = (size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+    if (size > LARGE_SIZE) {
+        return allocateBlock(size);
+    }
+    if (size > left) {
+        next = allocateBlock(BLOCK_SIZE);
+        left = BLOCK_SIZE;
+    }
+    void *result = next;
+    next += size;
+    left -= size;
+    return result;
+}
+
+const char *XmlArena::copy(const char *s, size_t length) {
+    char *copy = (char *)allocate(length + 1);
+    memcpy(copy, s, length);
+    copy[length] = 0;
+    return copy;
+}
+
+void XmlArena::merge(XmlArena &other) {
+    blocks.reserve(blocks.size() + other.blocks.size());
+    blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+    other.blocks.clear();
+    other.next = NULL;
+    other.left = 0;
+}
+
+void XmlArena::growPool() {
+    std::vector<const char *> old;
+    old.swap(pool);
+    pool.assign(old.empty() ? INITIAL_POOL_SIZE : 2 * old.size(), (const char *)NULL);
+    size_t mask = pool.size() - 1;
+    for (std::vector<const char *>::const_iterator it = old.begin(); it != old.end(); ++it) {
+        if (!*it) continue;
+        size_t i = hashString(*it, strlen(*it)) & mask;
+        while (pool[i]) i = (i + 1) & mask;
+        pool[i] = *it;
+    }
+}
+
+const char *XmlArena::intern(const char *s, size_t length) {
+    // keep the pool at most half full
+    if (2 * (pooled + 1) > pool.size()) growPool();
+    size_t mask = pool.size() - 1;
+    size_t i = hashString(s, length) & mask;
+    for (; pool[i]; i = (i + 1) & mask) {
+        if (equalString(pool[i], s, length)) {
+            return pool[i];
+        }
+    }
+    pool[i] = copy(s, length);
+    pooled++;
+    return pool[i];
+}
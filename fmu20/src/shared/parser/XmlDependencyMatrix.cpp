@@ -0,0 +1,109 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlDependencyMatrix.cpp
+ * Dependencies of the unknowns of a FMI 2.0 model in compressed sparse row
+ * format, decoded once from the ModelStructure.
+ * ---------------------------------------------------------------------------*/
+
+#include "fmu20/XmlDependencyMatrix.h"
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include "fmu20/XmlElement.h"
+#include "fmu20/XmlParserException.h"
+
+// return the 0 based index of the variable at the 1 based index in value,
+// the attribute att of the r-th Unknown of list. Advance value past it.
+static int decodeIndex(const char **value, int variables, XmlParser::Elm list, int r, XmlParser::Att att) {
+    char *end;
+    long index = strtol(*value, &end, 10);
+    if (end == *value || index < 1 || index > variables || (*end && *end != ' ')) {
+        throw XmlParserException("Invalid %s of Unknown %d in %s: '%s'", XmlParser::attNames[att], r + 1,
+            XmlParser::elmNames[list], *value);
+    }
+    *value = end;
+    return (int)index - 1;
+}
+
+static const char *skipSpaces(const char *s) {
+    while (*s == ' ') s++;
+    return s;
+}
+
+DependencyMatrix::DependencyMatrix(ModelDescription *md, XmlParser::Elm list) {
+    const std::vector<Element *> *unknownList = NULL;
+    ModelStructure *ms = md->modelStructure;
+    int variables = (int)md->modelVariables.size();
+    switch (list) {
+        case XmlParser::elm_Outputs:         if (ms) unknownList = &ms->outputs; break;
+        case XmlParser::elm_Derivatives:     if (ms) unknownList = &ms->derivatives; break;
+        case XmlParser::elm_DiscreteStates:  if (ms) unknownList = &ms->discreteStates; break;
+        case XmlParser::elm_InitialUnknowns: if (ms) unknownList = &ms->initialUnknowns; break;
+        default:
+            throw XmlParserException("Element '%s' is not a list of Unknowns",
+                list == XmlParser::elm_BAD_DEFINED ? "?" : XmlParser::elmNames[list]);
+    }
+    rows = unknownList ? (int)unknownList->size() : 0;
+    unknowns.resize(rows);
+    dependsOnAll.resize(rows);
+    rowStarts.reserve(rows + 1);
+    rowStarts.push_back(0);
+    valueReferences.resize(variables);
+    for (int i = 0; i < variables; i++) {
+        valueReferences[i] = md->modelVariables[i]->getValueReference();
+    }
+    std::string kind;
+    for (int r = 0; r < rows; r++) {
+        Element *unknown = (*unknownList)[r];
+        const char *index = unknown->getAttributeValue(XmlParser::att_index);
+        if (!index) {
+            throw XmlParserException("Unknown %d in %s misses required attribute %s", r + 1,
+                XmlParser::elmNames[list], XmlParser::attNames[XmlParser::att_index]);
+        }
+        unknowns[r] = decodeIndex(&index, variables, list, r, XmlParser::att_index);
+        if (*skipSpaces(index)) {
+            throw XmlParserException("Invalid %s of Unknown %d in %s: '%s'", XmlParser::attNames[XmlParser::att_index],
+                r + 1, XmlParser::elmNames[list], index);
+        }
+
+        const char *dependencies = unknown->getAttributeValue(XmlParser::att_dependencies);
+        const char *dependenciesKind = unknown->getAttributeValue(XmlParser::att_dependenciesKind);
+        if (!dependencies) {
+            dependsOnAll[r] = 1;
+            rowStarts.push_back((int)columns.size());
+            continue;
+        }
+        for (const char *p = skipSpaces(dependencies); *p; p = skipSpaces(p)) {
+            columns.push_back(decodeIndex(&p, variables, list, r, XmlParser::att_dependencies));
+        }
+        // without dependenciesKind all dependencies are of kind dependent
+        int entries = (int)columns.size() - rowStarts.back();
+        int nKinds = 0;
+        for (const char *p = skipSpaces(dependenciesKind ? dependenciesKind : ""); *p; p = skipSpaces(p)) {
+            const char *end = p;
+            while (*end && *end != ' ') end++;
+            kind.assign(p, end - p);
+            XmlParser::Enu k = XmlParser::checkEnumValue(kind.c_str());
+            if (k != XmlParser::enu_dependent && k != XmlParser::enu_constant && k != XmlParser::enu_fixed
+                    && k != XmlParser::enu_tunable && k != XmlParser::enu_discrete) {
+                throw XmlParserException("Invalid %s of Unknown %d in %s: '%s'",
+                    XmlParser::attNames[XmlParser::att_dependenciesKind], r + 1, XmlParser::elmNames[list],
+                    kind.c_str());
+            }
+            kinds.push_back((signed char)k);
+            nKinds++;
+            p = end;
+        }
+        if (!dependenciesKind) {
+            kinds.resize(columns.size(), (signed char)XmlParser::enu_dependent);
+        } else if (nKinds != entries) {
+            throw XmlParserException("Unknown %d in %s has %d %s, but %d %s", r + 1, XmlParser::elmNames[list],
+                entries, XmlParser::attNames[XmlParser::att_dependencies], nKinds,
+                XmlParser::attNames[XmlParser::att_dependenciesKind]);
+        }
+        rowStarts.push_back((int)columns.size());
+    }
+}
@@ -13,11 +13,12 @@
 
 #include "fmu20/XmlElement.h"
 #include <assert.h>
-#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include <string.h> // strcmp
 #include "fmu20/XmlParserException.h"
+#include "fmu20/XmlReader.h"
 
 #ifdef STANDALONE_XML_PARSER
 #define logThis(n, ...) printf(__VA_ARGS__); printf("\n")
@@ -26,11 +27,50 @@
 #include "logging.h"  // logThis
 #endif  // STANDALONE_XML_PARSER
 
+size_t StringHash::operator()(const char *s) const {
+    // FNV-1a
+    size_t h = (size_t)2166136261u;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+bool StringEqual::operator()(const char *s1, const char *s2) const {
+    return 0 == strcmp(s1, s2);
+}
+
+Element::Element() {
+    type = XmlParser::elm_BAD_DEFINED;
+    attributes = NULL;
+    nAttributes = 0;
+}
 Element::~Element() {
-    for (std::map<XmlParser::Att, char *>::const_iterator it = attributes.begin(); it != attributes.end(); ++it) {
-        free(it->second);
+}
+void *Element::operator new(size_t size, XmlArena *arena) {
+    return arena->allocate(size);
+}
+void Element::operator delete(void *p, XmlArena *arena) {
+}
+void Element::operator delete(void *p) {
+}
+void Element::setAttributes(XmlArena *arena, Attribute *atts, int n) {
+    // insertion sort, elements have few attributes. Stable, so that the first
+    // of equal atts comes first.
+    for (int i = 1; i < n; i++) {
+        Attribute a = atts[i];
+        int j = i;
+        for (; j > 0 && atts[j - 1].att > a.att; j--) {
+            atts[j] = atts[j - 1];
+        }
+        atts[j] = a;
+    }
+    attributes = (Attribute *)arena->allocate(n * sizeof(Attribute));
+    nAttributes = 0;
+    for (int i = 0; i < n; i++) {
+        if (nAttributes > 0 && attributes[nAttributes - 1].att == atts[i].att) continue;
+        attributes[nAttributes++] = atts[i];
     }
-    attributes.clear();
 }
 template <typename T> void Element::deleteListOfElements(const std::vector<T *> &list) {
     typename std::vector<T*>::const_iterator it;
@@ -46,8 +86,8 @@ void Element::handleElement(XmlParser *parser, const char *childName, int isEmpt
 void Element::printElement(int indent) {
     std::string indentS(indent, ' ');
     logThis(ERROR_INFO, "%s%s", indentS.c_str(), XmlParser::elmNames[type]);
-    for (std::map<XmlParser::Att, char *>::const_iterator it = attributes.begin(); it != attributes.end(); ++it) {
-        logThis(ERROR_INFO, "%s%s=%s", indentS.c_str(), XmlParser::attNames[it->first], it->second);
+    for (int i = 0; i < nAttributes; i++) {
+        logThis(ERROR_INFO, "%s%s=%s", indentS.c_str(), XmlParser::attNames[attributes[i].att], attributes[i].value);
     }
 }
 template <typename T> void Element::printListOfElements(int indent, const std::vector<T *> &list) {
@@ -58,9 +98,10 @@ template <typename T> void Element::printListOfElements(int indent, const std::v
 }
 
 const char *Element::getAttributeValue(XmlParser::Att att) {
-    std::map<XmlParser::Att, char *>::const_iterator it = attributes.find(att);
-    if (it != attributes.end()) {
-        return it->second;
+    for (int i = 0; i < nAttributes && attributes[i].att <= att; i++) {
+        if (attributes[i].att == att) {
+            return attributes[i].value;
+        }
     }
     return NULL;
 }
@@ -101,7 +142,7 @@ ListElement::~ListElement() {
 void ListElement::handleElement(XmlParser *parser, const char *childName, int isEmptyElement) {
     XmlParser::Elm childType = parser->checkElement(childName);
     if (childType == XmlParser::elm_Item) {
-        Element *item = new Element;
+        Element *item = new (parser->getArena()) Element;
         item->type = childType;
         parser->parseElementAttributes(item);
         if (!isEmptyElement) {
@@ -132,14 +173,14 @@ Unit::~Unit() {
 void Unit::handleElement(XmlParser *parser, const char *childName, int isEmptyElement) {
     XmlParser::Elm childType = parser->checkElement(childName);
     if (childType == XmlParser::elm_BaseUnit) {
-        baseUnit = new Element;
+        baseUnit = new (parser->getArena()) Element;
         baseUnit->type = childType;
         parser->parseElementAttributes(baseUnit);
         if (!isEmptyElement) {
             parser->parseEndElement();
         }
     } else if (childType == XmlParser::elm_DisplayUnit) {
-        Element *displayUnit = new Element;
+        Element *displayUnit = new (parser->getArena()) Element;
         displayUnit->type = childType;
         parser->parseElementAttributes(displayUnit);
         displayUnits.push_back(displayUnit);
@@ -185,7 +226,7 @@ void SimpleType::handleElement(XmlParser *parser, const char *childName, int isE
         case XmlParser::elm_Integer:
         case XmlParser::elm_Boolean:
         case XmlParser::elm_String: {
-            typeSpec = new Element;
+            typeSpec = new (parser->getArena()) Element;
             typeSpec->type = childType;
             parser->parseElementAttributes(typeSpec);
             if (!isEmptyElement) {
@@ -194,7 +235,7 @@ void SimpleType::handleElement(XmlParser *parser, const char *childName, int isE
             break;
         }
         case XmlParser::elm_Enumeration: {
-            typeSpec = new ListElement;
+            typeSpec = new (parser->getArena()) ListElement;
             typeSpec->type = childType;
             parser->parseElementAttributes(typeSpec);
             if (!isEmptyElement) {
@@ -232,7 +273,7 @@ void Component::handleElement(XmlParser *parser, const char *childName, int isEm
             parser->parseChildElements(this);
         }
     } else if (childType == XmlParser::elm_File) {
-        Element *sourceFile = new Element;
+        Element *sourceFile = new (parser->getArena()) Element;
         sourceFile->type = childType;
         parser->parseElementAttributes(sourceFile);
         if (!isEmptyElement) {
@@ -269,7 +310,7 @@ void ScalarVariable::handleElement(XmlParser *parser, const char *childName, int
         case XmlParser::elm_Boolean:
         case XmlParser::elm_String:
         case XmlParser::elm_Enumeration: {
-            typeSpec = new Element;
+            typeSpec = new (parser->getArena()) Element;
             typeSpec->type = childType;
             parser->parseElementAttributes(typeSpec);
             if (!isEmptyElement) {
@@ -279,11 +320,12 @@ void ScalarVariable::handleElement(XmlParser *parser, const char *childName, int
         }
         case XmlParser::elm_Annotations: {
             // no attributes expected; this class handles also the Tool
+            if (parser->parseSkipSection(XmlParser::sec_Annotations, isEmptyElement)) break;
             if (!isEmptyElement) parser->parseChildElements(this);
             break;
         }
         case XmlParser::elm_Tool: {
-            Element *tool = new Element;
+            Element *tool = new (parser->getArena()) Element;
             tool->type = childType;
             parser->parseElementAttributes(tool, false);
             if (!isEmptyElement) {
@@ -369,7 +411,7 @@ void ModelStructure::handleElement(XmlParser *parser, const char *childName, int
         }
     case XmlParser::elm_Unknown:
         {
-            Element *unknown = new Element;
+            Element *unknown = new (parser->getArena()) Element;
             unknown->type = childType;
             parser->parseElementAttributes(unknown);
             if (!isEmptyElement) {
@@ -425,10 +467,18 @@ void ModelStructure::printElement(int indent) {
 
 
 ModelDescription::ModelDescription() {
+    indexed = false;
     modelExchange = NULL;
     coSimulation = NULL;
     defaultExperiment = NULL;
     modelStructure = NULL;
+    cacheFile = NULL;
+}
+void *ModelDescription::operator new(size_t size) {
+    return ::operator new(size);
+}
+void ModelDescription::operator delete(void *p) {
+    ::operator delete(p);
 }
 ModelDescription::~ModelDescription() {
     deleteListOfElements(unitDefinitions);
@@ -440,13 +490,14 @@ ModelDescription::~ModelDescription() {
     deleteListOfElements(vendorAnnotations);
     deleteListOfElements(modelVariables);
     if (modelStructure) delete modelStructure;
+    delete cacheFile;
 }
 void ModelDescription::handleElement(XmlParser *parser, const char *childName, int isEmptyElement) {
     XmlParser::Elm childType = parser->checkElement(childName);
     switch (childType) {
     case XmlParser::elm_CoSimulation:
         {
-            coSimulation = new Component;
+            coSimulation = new (parser->getArena()) Component;
             coSimulation->type = childType;
             parser->parseElementAttributes(coSimulation);
             if (!isEmptyElement) {
@@ -456,7 +507,7 @@ void ModelDescription::handleElement(XmlParser *parser, const char *childName, i
         }
     case XmlParser::elm_ModelExchange:
         {
-            modelExchange = new Component;
+            modelExchange = new (parser->getArena()) Component;
             modelExchange->type = childType;
             parser->parseElementAttributes(modelExchange);
             if (!isEmptyElement) {
@@ -467,40 +518,45 @@ void ModelDescription::handleElement(XmlParser *parser, const char *childName, i
     case XmlParser::elm_UnitDefinitions:
         {
             // no attributes expected; this class handles the Category
+            if (parser->parseSkipSection(XmlParser::sec_UnitDefinitions, isEmptyElement)) break;
             if (!isEmptyElement) parser->parseChildElements(this);
             break;
         }
     case XmlParser::elm_Unit:
         {
-            Unit *unit = new Unit;
+            Unit *unit = new (parser->getArena()) Unit;
             unit->type = childType;
             parser->parseElementAttributes(unit);
+            // add before parsing the children, to be destroyed with the model description on errors
+            unitDefinitions.push_back(unit);
             if (!isEmptyElement) {
                 parser->parseChildElements(unit);
             }
-            unitDefinitions.push_back(unit);
             break;
         }
     case XmlParser::elm_TypeDefinitions:
         {
             // no attributes expected; this class handles also the SimpleType
+            if (parser->parseSkipSection(XmlParser::sec_TypeDefinitions, isEmptyElement)) break;
             if (!isEmptyElement) parser->parseChildElements(this);
             break;
         }
     case XmlParser::elm_SimpleType:
         {
-            SimpleType *type = new SimpleType;
+            SimpleType *type = new (parser->getArena()) SimpleType;
             type->type = childType;
             parser->parseElementAttributes(type);
+            // add before parsing the children, to be destroyed with the model description on errors
+            typeDefinitions.push_back(type);
             if (!isEmptyElement) {
                 parser->parseChildElements(type);
             }
-            typeDefinitions.push_back(type);
             break;
         }
     case XmlParser::elm_DefaultExperiment:
         {
-            defaultExperiment = new Element;
+            if (parser->parseSkipSection(XmlParser::sec_DefaultExperiment, isEmptyElement)) break;
+            defaultExperiment = new (parser->getArena()) Element;
             defaultExperiment->type = childType;
             parser->parseElementAttributes(defaultExperiment);
             if (!isEmptyElement) {
@@ -511,12 +567,13 @@ void ModelDescription::handleElement(XmlParser *parser, const char *childName, i
     case XmlParser::elm_LogCategories:
         {
             // no attributes expected; this class handles also the Category
+            if (parser->parseSkipSection(XmlParser::sec_LogCategories, isEmptyElement)) break;
             if (!isEmptyElement) parser->parseChildElements(this);
             break;
         }
     case XmlParser::elm_Category:
         {
-            Element *category = new Element;
+            Element *category = new (parser->getArena()) Element;
             category->type = childType;
             parser->parseElementAttributes(category);
             if (!isEmptyElement) {
@@ -528,12 +585,13 @@ void ModelDescription::handleElement(XmlParser *parser, const char *childName, i
     case XmlParser::elm_VendorAnnotations:
         {
             // no attributes expected; this class handles also the Tool
+            if (parser->parseSkipSection(XmlParser::sec_VendorAnnotations, isEmptyElement)) break;
             if (!isEmptyElement) parser->parseChildElements(this);
             break;
         }
     case XmlParser::elm_Tool:
         {
-            Element *tool = new Element;
+            Element *tool = new (parser->getArena()) Element;
             tool->type = childType;
             parser->parseElementAttributes(tool, false);
             if (!isEmptyElement) {
@@ -545,23 +603,26 @@ void ModelDescription::handleElement(XmlParser *parser, const char *childName, i
     case XmlParser::elm_ModelVariables:
         {
             // no attributes expected; this class handles also the ScalarVariable
-            if (!isEmptyElement) parser->parseChildElements(this);
+            if (parser->parseSkipSection(XmlParser::sec_ModelVariables, isEmptyElement)) break;
+            if (!isEmptyElement && !parser->parseModelVariables(this)) parser->parseChildElements(this);
             break;
         }
     case XmlParser::elm_ScalarVariable:
         {
-            ScalarVariable *variable = new ScalarVariable;
+            ScalarVariable *variable = new (parser->getArena()) ScalarVariable;
             variable->type = childType;
             parser->parseElementAttributes(variable);
+            // add before parsing the children, to be destroyed with the model description on errors
+            modelVariables.push_back(variable);
             if (!isEmptyElement) {
                 parser->parseChildElements(variable);
             }
-            modelVariables.push_back(variable);
             break;
         }
     case XmlParser::elm_ModelStructure:
         {
-            modelStructure = new ModelStructure;
+            if (parser->parseSkipSection(XmlParser::sec_ModelStructure, isEmptyElement)) break;
+            modelStructure = new (parser->getArena()) ModelStructure;
             modelStructure->type = childType;
             parser->parseElementAttributes(modelStructure);
             if (!isEmptyElement) {
@@ -570,7 +631,7 @@ void ModelDescription::handleElement(XmlParser *parser, const char *childName, i
             break;
         }
     default:
-        throw XmlParserException("Element '%s' is not expected inside of '%s' | '%s' | '%s' | '%s'.",
+        throw XmlParserException("Element '%s' is not expected inside of '%s'.",
             childName,
             XmlParser::elmNames[type]);
     }
@@ -601,42 +662,57 @@ void ModelDescription::printElement(int indent) {
     if (modelStructure) modelStructure->printElement(childIndent);
 }
 
-SimpleType *ModelDescription::getSimpleType(const char *name) {
-    for (std::vector<SimpleType *>::const_iterator it = typeDefinitions.begin(); it != typeDefinitions.end(); ++it) {
-        const char *typeName = (*it)->getAttributeValue(XmlParser::att_name);
-        if (typeName && 0 == strcmp(typeName, name)) {
-            return (*it);
-        }
+// Enumeration and Integer have the same base type while
+// Real, String, Boolean define own base types.
+static unsigned long long refKey(fmi2ValueReference vr, XmlParser::Elm type) {
+    if (type == XmlParser::elm_Enumeration) type = XmlParser::elm_Integer;
+    return (unsigned long long)vr << 8 | (unsigned char)type;
+}
+
+template <typename T> static void indexByName(
+        std::unordered_map<const char *, T *, StringHash, StringEqual> &index, const std::vector<T *> &list) {
+    index.reserve(list.size());
+    for (typename std::vector<T *>::const_iterator it = list.begin(); it != list.end(); ++it) {
+        const char *name = (*it)->getAttributeValue(XmlParser::att_name);
+        if (name) index.insert(std::make_pair(name, *it));
     }
-    return NULL;
 }
 
-ScalarVariable *ModelDescription::getVariable(const char *name) {
-    if (!name) return NULL;
+void ModelDescription::buildIndexes() {
+    indexByName(variablesByName, modelVariables);
+    indexByName(typesByName, typeDefinitions);
+    indexByName(unitsByName, unitDefinitions);
+    variablesByRef.reserve(modelVariables.size());
     for (std::vector<ScalarVariable *>::const_iterator it = modelVariables.begin(); it != modelVariables.end(); ++it) {
-        const char *varName = (*it)->getAttributeValue(XmlParser::att_name);
-        if (varName && 0 == strcmp(name, varName)) {
-            return (*it);
+        // variables without valueReference or type are reported by XmlParser::validate
+        XmlParser::ValueStatus vs;
+        fmi2ValueReference vr = (*it)->getAttributeUInt(XmlParser::att_valueReference, &vs);
+        if (vs == XmlParser::valueDefined && (*it)->typeSpec) {
+            variablesByRef.insert(std::make_pair(refKey(vr, (*it)->typeSpec->type), *it));
         }
     }
-    return NULL;
+    indexed = true;
 }
 
-// Enumeration and Integer have the same base type while
-// Real, String, Boolean define own base types.
-static int sameBaseType(XmlParser::Elm  t1, XmlParser::Elm  t2){
-    return t1 == t2 ||
-           t1 == XmlParser::elm_Enumeration && t2 == XmlParser::elm_Integer ||
-           t2 == XmlParser::elm_Enumeration && t1 == XmlParser::elm_Integer;
+SimpleType *ModelDescription::getSimpleType(const char *name) {
+    if (!name) return NULL;
+    if (!indexed) buildIndexes();
+    std::unordered_map<const char *, SimpleType *, StringHash, StringEqual>::const_iterator it = typesByName.find(name);
+    return it != typesByName.end() ? it->second : NULL;
+}
+
+ScalarVariable *ModelDescription::getVariable(const char *name) {
+    if (!name) return NULL;
+    if (!indexed) buildIndexes();
+    std::unordered_map<const char *, ScalarVariable *, StringHash, StringEqual>::const_iterator it =
+        variablesByName.find(name);
+    return it != variablesByName.end() ? it->second : NULL;
 }
 
 ScalarVariable *ModelDescription::getVariable(fmi2ValueReference vr, XmlParser::Elm type) {
-    for (std::vector<ScalarVariable *>::const_iterator it = modelVariables.begin(); it != modelVariables.end(); ++it) {
-        if (vr == (*it)->getValueReference() && sameBaseType(type, (*it)->typeSpec->type)) {
-            return (*it);
-        }
-    }
-    return NULL;
+    if (!indexed) buildIndexes();
+    std::unordered_map<unsigned long long, ScalarVariable *>::const_iterator it = variablesByRef.find(refKey(vr, type));
+    return it != variablesByRef.end() ? it->second : NULL;
 }
 
 const char *ModelDescription::getDescriptionForVariable(ScalarVariable *sv) {
@@ -666,11 +742,7 @@ const char *ModelDescription::getAttributeFromTypeOrDeclaredType(ScalarVariable
 
 Unit *ModelDescription::getUnit(const char *name) {
     if (!name) return NULL;
-    for (std::vector<Unit *>::const_iterator it = unitDefinitions.begin(); it != unitDefinitions.end(); ++it) {
-        const char *unitName = (*it)->getAttributeValue(XmlParser::att_name);
-        if (unitName && 0 == strcmp(name, unitName)) {
-            return (*it);
-        }
-    }
-    return NULL;
+    if (!indexed) buildIndexes();
+    std::unordered_map<const char *, Unit *, StringHash, StringEqual>::const_iterator it = unitsByName.find(name);
+    return it != unitsByName.end() ? it->second : NULL;
 }
@@ -0,0 +1,393 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlModelCache.cpp
+ * Binary cache of a parsed model description of a FMI 2.0 model.
+ * Writes the ModelDescription AST to a file and reads it back from a memory
+ * mapping of that file. Attribute values are stored 0 terminated and used
+ * in place in the mapping, which the model description keeps until it is
+ * freed, so that loading allocates only the elements.
+ * ---------------------------------------------------------------------------*/
+
+#include "fmu20/XmlModelCache.h"
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fmu20/XmlElement.h"
+#include "fmu20/XmlParserException.h"
+#include "fmu20/XmlReader.h"
+
+#ifdef _WIN32
+#include <process.h>  // _getpid
+#define getpid _getpid
+#else
+#include <unistd.h>  // getpid
+#endif
+
+// File layout, all numbers in native byte order:
+//   header    CacheHeader, the hashes detect stale and damaged files
+//   element   type (1 byte), number of attributes (1 byte), then per attribute
+//             its Att (1 byte), length (4 bytes) and value with trailing 0
+//   list      number of entries (4 bytes) followed by the entries
+//   optional  1 byte, 0 if absent, else 1 followed by the entry
+// Elements with children are followed by their children in the order of the
+// fields of their class, see CacheWriter.
+// Increment CACHE_VERSION when the layout changes, so that old files are ignored.
+#define CACHE_MAGIC   0x43444d46  // "FMDC"
+#define CACHE_VERSION 3
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int sections;   // mask of the parsed sections, see XmlParser::setSections
+    unsigned int reserved;
+    unsigned long long xmlSize;
+    unsigned long long xmlHash;   // hashBytes of the xml
+    unsigned long long dataHash;  // hashBytes of the rest of the file
+} CacheHeader;
+
+#define HASH_PRIME 1099511628211ULL
+
+static unsigned long long mix(unsigned long long h, unsigned long long word) {
+    h = (h ^ word) * HASH_PRIME;
+    return h ^ (h >> 29);
+}
+
+// Hash of the bytes, read 8 at a time into 4 independent lanes, so that
+// the xml is checked at about the speed of memory on every load.
+static unsigned long long hashBytes(const char *bytes, size_t size) {
+    unsigned long long lanes[4] = { 14695981039346656037ULL, 1, 2, 3 };
+    unsigned long long word;
+    size_t i = 0;
+    for (; i + sizeof(lanes) <= size; i += sizeof(lanes)) {
+        for (int j = 0; j < 4; j++) {
+            memcpy(&word, bytes + i + j * sizeof(word), sizeof(word));
+            lanes[j] = mix(lanes[j], word);
+        }
+    }
+    for (; i < size; i++) {
+        lanes[0] = mix(lanes[0], (unsigned char)bytes[i]);
+    }
+    unsigned long long h = size;
+    for (int j = 0; j < 4; j++) {
+        h = mix(h, lanes[j]);
+    }
+    return h;
+}
+
+class CacheWriter {
+ public:
+    std::string data;
+
+ public:
+    void writeBytes(const void *bytes, size_t n) {
+        data.append((const char *)bytes, n);
+    }
+    void writeByte(int b) {
+        data.append(1, (char)b);
+    }
+    void writeUInt(unsigned int u) {
+        writeBytes(&u, sizeof(u));
+    }
+    void writeElement(Element *e) {
+        writeByte(e->type);
+        writeByte(e->nAttributes);
+        for (int i = 0; i < e->nAttributes; i++) {
+            unsigned int length = (unsigned int)strlen(e->attributes[i].value);
+            writeByte(e->attributes[i].att);
+            writeUInt(length);
+            writeBytes(e->attributes[i].value, length + 1);
+        }
+    }
+    void writeOptional(Element *e) {
+        writeByte(e != NULL);
+        if (e) writeElement(e);
+    }
+    template <typename T> void writeList(const std::vector<T *> &list) {
+        writeUInt((unsigned int)list.size());
+        for (typename std::vector<T *>::const_iterator it = list.begin(); it != list.end(); ++it) {
+            write(*it);
+        }
+    }
+    void write(Element *e) {
+        writeElement(e);
+    }
+    void write(Unit *u) {
+        writeElement(u);
+        writeOptional(u->baseUnit);
+        writeList(u->displayUnits);
+    }
+    void write(SimpleType *st) {
+        writeElement(st);
+        writeOptional(st->typeSpec);
+        // SimpleType creates a ListElement for the Item list of an Enumeration
+        if (st->typeSpec && st->typeSpec->type == XmlParser::elm_Enumeration) {
+            writeList(((ListElement *)st->typeSpec)->list);
+        }
+    }
+    void write(Component *c) {
+        writeElement(c);
+        writeList(c->files);
+    }
+    void write(ScalarVariable *sv) {
+        writeElement(sv);
+        writeOptional(sv->typeSpec);
+        writeList(sv->annotations);
+    }
+    void write(ModelStructure *ms) {
+        writeElement(ms);
+        writeList(ms->outputs);
+        writeList(ms->derivatives);
+        writeList(ms->discreteStates);
+        writeList(ms->initialUnknowns);
+    }
+    void write(ModelDescription *md) {
+        writeElement(md);
+        writeList(md->unitDefinitions);
+        writeList(md->typeDefinitions);
+        writeByte(md->modelExchange != NULL);
+        if (md->modelExchange) write(md->modelExchange);
+        writeByte(md->coSimulation != NULL);
+        if (md->coSimulation) write(md->coSimulation);
+        writeList(md->logCategories);
+        writeOptional(md->defaultExperiment);
+        writeList(md->vendorAnnotations);
+        writeList(md->modelVariables);
+        writeByte(md->modelStructure != NULL);
+        if (md->modelStructure) write(md->modelStructure);
+    }
+};
+
+// Reads what CacheWriter wrote into the arena of the model description. The
+// attribute values point into the data.
+// Every element is linked into the AST before its content is read, so that
+// deleting the root frees a partially read AST.
+// throw XmlParserException if the data is corrupt.
+class CacheReader {
+ private:
+    const char *pos;
+    const char *end;
+    XmlArena *arena;
+
+ public:
+    CacheReader(const char *data, const char *dataEnd, XmlArena *arena) {
+        pos = data;
+        end = dataEnd;
+        this->arena = arena;
+    }
+    bool atEnd() {
+        return pos == end;
+    }
+    void need(size_t n) {
+        if ((size_t)(end - pos) < n) {
+            throw XmlParserException("Unexpected end of model description cache");
+        }
+    }
+    int readByte() {
+        need(1);
+        return (unsigned char)*pos++;
+    }
+    unsigned int readUInt() {
+        unsigned int u;
+        need(sizeof(u));
+        memcpy(&u, pos, sizeof(u));
+        pos += sizeof(u);
+        return u;
+    }
+    // number of entries of a list, each entry takes at least 2 bytes
+    unsigned int readCount() {
+        unsigned int n = readUInt();
+        if (n > (size_t)(end - pos) / 2) {
+            throw XmlParserException("Invalid list size %u in model description cache", n);
+        }
+        return n;
+    }
+    XmlParser::Elm peekType() {
+        need(1);
+        int type = (unsigned char)*pos;
+        if (type >= XmlParser::SIZEOF_ELM) {
+            throw XmlParserException("Invalid element type %d in model description cache", type);
+        }
+        return (XmlParser::Elm)type;
+    }
+    void readElement(Element *e) {
+        Attribute atts[XmlParser::SIZEOF_ATT];
+        e->type = peekType();
+        pos++;
+        int n = readByte();
+        if (n > XmlParser::SIZEOF_ATT) {
+            throw XmlParserException("Invalid number of attributes %d in model description cache", n);
+        }
+        for (int i = 0; i < n; i++) {
+            int att = readByte();
+            if (att >= XmlParser::SIZEOF_ATT) {
+                throw XmlParserException("Invalid attribute %d in model description cache", att);
+            }
+            unsigned int length = readUInt();
+            need((size_t)length + 1);
+            if (pos[length]) {
+                throw XmlParserException("Unterminated attribute value in model description cache");
+            }
+            atts[i].att = (XmlParser::Att)att;
+            atts[i].value = pos;
+            pos += (size_t)length + 1;
+        }
+        e->setAttributes(arena, atts, n);
+    }
+    void readOptional(Element **e) {
+        if (!readByte()) return;
+        *e = new (arena) Element;
+        readElement(*e);
+    }
+    template <typename T> void readList(std::vector<T *> &list) {
+        unsigned int n = readCount();
+        list.reserve(n);
+        for (unsigned int i = 0; i < n; i++) {
+            T *e = new (arena) T;
+            list.push_back(e);
+            read(e);
+        }
+    }
+    void read(Element *e) {
+        readElement(e);
+    }
+    void read(Unit *u) {
+        readElement(u);
+        readOptional(&u->baseUnit);
+        readList(u->displayUnits);
+    }
+    void read(SimpleType *st) {
+        readElement(st);
+        if (!readByte()) return;
+        if (peekType() == XmlParser::elm_Enumeration) {
+            ListElement *enumeration = new (arena) ListElement;
+            st->typeSpec = enumeration;
+            readElement(enumeration);
+            readList(enumeration->list);
+        } else {
+            st->typeSpec = new (arena) Element;
+            readElement(st->typeSpec);
+        }
+    }
+    void read(Component *c) {
+        readElement(c);
+        readList(c->files);
+    }
+    void read(ScalarVariable *sv) {
+        readElement(sv);
+        readOptional(&sv->typeSpec);
+        readList(sv->annotations);
+    }
+    void read(ModelStructure *ms) {
+        readElement(ms);
+        readList(ms->outputs);
+        readList(ms->derivatives);
+        readList(ms->discreteStates);
+        readList(ms->initialUnknowns);
+    }
+    void read(ModelDescription *md) {
+        readElement(md);
+        if (md->type != XmlParser::elm_fmiModelDescription) {
+            throw XmlParserException("Model description cache does not start with '%s'",
+                XmlParser::elmNames[XmlParser::elm_fmiModelDescription]);
+        }
+        readList(md->unitDefinitions);
+        readList(md->typeDefinitions);
+        if (readByte()) {
+            md->modelExchange = new (arena) Component;
+            read(md->modelExchange);
+        }
+        if (readByte()) {
+            md->coSimulation = new (arena) Component;
+            read(md->coSimulation);
+        }
+        readList(md->logCategories);
+        readOptional(&md->defaultExperiment);
+        readList(md->vendorAnnotations);
+        readList(md->modelVariables);
+        if (readByte()) {
+            md->modelStructure = new (arena) ModelStructure;
+            read(md->modelStructure);
+        }
+    }
+};
+
+ModelDescription *XmlModelCache::load(const char *cachePath, const char *xml, int size, int sections) {
+    ModelDescription *md = NULL;
+    CacheHeader header;
+    XmlMappedFile *file = new (std::nothrow) XmlMappedFile;
+    if (!file || !file->open(cachePath)) {
+        delete file;
+        return NULL;
+    }
+    const char *data = file->getData();
+    size_t length = file->getSize();
+    if (length >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+        if (header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.sections == (unsigned int)sections
+                && header.xmlSize == (unsigned long long)size && header.xmlHash == hashBytes(xml, size)
+                && header.dataHash == hashBytes(data + sizeof(header), length - sizeof(header))) {
+            try {
+                md = new ModelDescription;
+                md->cacheFile = file;
+                file = NULL;
+                CacheReader reader(data + sizeof(header), data + length, &md->arena);
+                reader.read(md);
+                if (!reader.atEnd()) {
+                    throw XmlParserException("Unexpected data at end of model description cache");
+                }
+                md->buildIndexes();
+            } catch (XmlParserException& ) {
+                delete md;
+                md = NULL;
+            } catch (std::bad_alloc& ) {
+                delete md;
+                md = NULL;
+            }
+        }
+    }
+    delete file;
+    return md;
+}
+
+bool XmlModelCache::store(const char *cachePath, ModelDescription *md, const char *xml, int size, int sections) {
+    CacheWriter writer;
+    CacheHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.sections = sections;
+    header.reserved = 0;
+    header.xmlSize = size;
+    header.xmlHash = hashBytes(xml, size);
+    try {
+        writer.writeBytes(&header, sizeof(header));
+        writer.write(md);
+    } catch (std::bad_alloc& ) {
+        return false;
+    }
+    header.dataHash = hashBytes(writer.data.data() + sizeof(header), writer.data.size() - sizeof(header));
+    writer.data.replace(0, sizeof(header), (const char *)&header, sizeof(header));
+
+    // write to a file private to this process, then rename it to cachePath
+    std::string tmpPath(cachePath);
+    char suffix[32];
+    sprintf(suffix, ".%d", (int)getpid());
+    tmpPath += suffix;
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(writer.data.data(), 1, writer.data.size(), file) == writer.data.size();
+    if (fclose(file)) ok = false;
+#ifdef _WIN32
+    // rename does not replace an existing file on Windows
+    if (ok) remove(cachePath);
+#endif
+    if (ok && rename(tmpPath.c_str(), cachePath)) ok = false;
+    if (!ok) remove(tmpPath.c_str());
+    return ok;
+}
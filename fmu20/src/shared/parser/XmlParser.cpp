@@ -6,17 +6,24 @@
  * XmlParser.cpp
  * Parser implementation for xml model description file of a FMI 2.0 model.
  * The result of parsing is a ModelDescription object that can be queried to
- * get necessary information. The parsing is based on libxml2.lib.
+ * get necessary information. The xml is read with XmlReader.
  *
  * Author: Adrian Tirea
  * ---------------------------------------------------------------------------*/
 
 #include "fmu20/XmlParser.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <string.h>
 #include "fmu20/XmlElement.h"
 #include "fmu20/XmlParserException.h"
+#include "fmu20/XmlReader.h"
 
 #ifdef STANDALONE_XML_PARSER
 #define logThis(n, ...) printf(__VA_ARGS__); printf("\n")
@@ -27,6 +34,14 @@
 #include "minutil.h"  // checkStrdup
 #endif  // STANDALONE_XML_PARSER
 
+// the value of attribute fmiVersion of model descriptions accepted by this parser
+#define FMI_VERSION "2.0"
+
+// ModelVariables sections smaller than this are parsed on one thread
+#define PARALLEL_MIN_SIZE (1 << 20)
+// chunks of a ModelVariables section per thread, more than 1 to balance the load
+#define CHUNKS_PER_THREAD 4
+
 /* Helper functions to check validity of xml. */
 static int checkAttribute(const char* att);
 
@@ -72,44 +87,93 @@ const char *XmlParser::enuNames[SIZEOF_ENU] = {
 
 XmlParser::XmlParser(char *xmlPath) {
     this->xmlPath = (char *)checkStrdup(xmlPath);
+    xmlBuffer = NULL;
+    xmlSize = 0;
+    xmlReader = NULL;
+    arena = NULL;
+    sections = sec_ALL;
+    threads = 1;
+}
+
+XmlParser::XmlParser(char *xmlName, const char *xml, int size) {
+    this->xmlPath = (char *)checkStrdup(xmlName);
+    xmlBuffer = xml;
+    xmlSize = size;
     xmlReader = NULL;
+    arena = NULL;
+    sections = sec_ALL;
+    threads = 1;
 }
 
 XmlParser::~XmlParser() {
     free(xmlPath);
-    // do NOT call here xmlCleanupParser() because we don't know all other modules linked into this DLL that
-    // might be using libxml2. For memory leak detections call xmlCleanupParser() just before exit()
-    //xmlCleanupParser();
+}
+
+void XmlParser::setSections(int sections) {
+    this->sections = sections;
+}
+
+void XmlParser::setThreads(int threads) {
+    this->threads = threads;
 }
 
 ModelDescription *XmlParser::parse() {
-    xmlReader = xmlReaderForFile(xmlPath, NULL, 0);
+    XmlMappedFile file;
+    const char *xml = xmlBuffer;
+    size_t size = xmlSize;
+    if (!xml) {
+        if (file.open(xmlPath)) {
+            xml = file.getData();
+            size = file.getSize();
+        }
+    }
     ModelDescription *md = NULL;
-    if (xmlReader != NULL) {
+    if (xml != NULL) {
         try {
+            XmlReader reader(xml, size, xmlPath);
+            xmlReader = &reader;
             if (readNextInXml()) {
                 // I expect that first element is fmiModelDescription.
-                if (0 != strcmp((char *)xmlTextReaderConstLocalName(xmlReader), elmNames[elm_fmiModelDescription])) {
+                if (0 != strcmp(xmlReader->getLocalName(), elmNames[elm_fmiModelDescription])) {
                     throw XmlParserException("Expected '%s' element. Found instead: '%s'.",
                         elmNames[elm_fmiModelDescription],
-                        xmlTextReaderConstLocalName(xmlReader));
+                        xmlReader->getLocalName());
+                }
+
+                // check the FMI version before the attributes, an FMU of another version
+                // typically fails on its first attribute or element unknown in FMI 2.0
+                int i = xmlReader->findAttribute(attNames[att_fmiVersion]);
+                if (i >= 0) {
+                    size_t length;
+                    const char *value = xmlReader->getAttributeValue(i, &length);
+                    if (length != strlen(FMI_VERSION) || 0 != memcmp(value, FMI_VERSION, length)) {
+                        std::string version(value, length);
+                        throw XmlParserException(
+                            "The FMU to simulate is FMI %s standard, but expected a FMI %s standard FMU",
+                            version.c_str(), FMI_VERSION);
+                    }
                 }
 
                 md = new ModelDescription;
                 md->type = elm_fmiModelDescription;
+                arena = &md->arena;
                 parseElementAttributes((Element *)md);
                 parseChildElements(md);
+                md->buildIndexes();
             } else {
                 throw XmlParserException("Syntax error parsing xml file '%s'", xmlPath);
             }
         } catch (XmlParserException& e) {
             logThis(ERROR_ERROR, "%s", e.what());
+            delete md;
             md = NULL;
         } catch (std::bad_alloc& ) {
             logThis(ERROR_FATAL, "Out of memory");
+            delete md;
             md = NULL;
         }
-        xmlFreeTextReader(xmlReader);
+        arena = NULL;
+        xmlReader = NULL;
     } else {
         logThis(ERROR_ERROR, "Unable to open '%s'", xmlPath);
     }
@@ -117,24 +181,44 @@ ModelDescription *XmlParser::parse() {
     return validate(md);
 }
 
+// true for attributes whose values differ from element to element, such as the
+// name of a variable. These are copied to the arena without interning.
+static bool isUniqueValue(XmlParser::Att att) {
+    switch (att) {
+        case XmlParser::att_name:
+        case XmlParser::att_description:
+        case XmlParser::att_valueReference:
+        case XmlParser::att_derivative:
+        case XmlParser::att_index:
+        case XmlParser::att_dependencies:
+            return true;
+        default:
+            return false;
+    }
+}
+
 void XmlParser::parseElementAttributes(Element *element, bool ignoreUnknownAttributes) {
-    while (xmlTextReaderMoveToNextAttribute(xmlReader)) {
-        xmlChar *name = xmlTextReaderName(xmlReader);
-        xmlChar *value = xmlTextReaderValue(xmlReader);
+    // an element has each attribute at most once
+    Attribute atts[SIZEOF_ATT];
+    int n = 0;
+    for (int i = 0; i < xmlReader->getAttributeCount(); i++) {
+        const XmlReader::Attribute &att = xmlReader->getAttribute(i);
         try {
-            XmlParser::Att key = checkAttribute((char *)name);
-            char *theValue = value ? (char *)checkStrdup((char *)value) : NULL;
-            element->attributes.insert(std::pair<XmlParser::Att, char *>(key, theValue));
+            XmlParser::Att key = checkAttribute(att.name, att.nameLength);
+            if (n < SIZEOF_ATT) {
+                size_t length;
+                const char *value = xmlReader->getAttributeValue(i, &length);
+                atts[n].att = key;
+                atts[n].value = isUniqueValue(key) ? arena->copy(value, length) : arena->intern(value, length);
+                n++;
+            }
         } catch (XmlParserException &ex) {
             if (ignoreUnknownAttributes) {
-                xmlFree(name);
-                xmlFree(value);
                 throw;
             }
         }
-        xmlFree(name);
-        xmlFree(value);
     }
+    element->setAttributes(arena, atts, n);
 }
 
 void XmlParser::parseElementAttributes(Element *element) {
@@ -142,25 +226,20 @@ void XmlParser::parseElementAttributes(Element *element) {
 }
 
 void XmlParser::parseChildElements(Element *el) {
-    int elementIsEmpty = xmlTextReaderIsEmptyElement(xmlReader);
-    if (elementIsEmpty == -1) {
-        throw XmlParserException("Error parsing xml file '%s'", xmlPath);
-    } else if (elementIsEmpty == 1) {
+    if (xmlReader->isEmptyElement()) {
         return;
     }
 
     bool ret = readNextInXml();
-    while (ret  && xmlTextReaderNodeType(xmlReader) != XML_READER_TYPE_END_ELEMENT) {
-        if (xmlTextReaderNodeType(xmlReader) == XML_READER_TYPE_ELEMENT) {
-            const char *localName = (char *)xmlTextReaderConstLocalName(xmlReader);
-            int depthBefore = xmlTextReaderDepth(xmlReader);
-            int isEmptyElement = xmlTextReaderIsEmptyElement(xmlReader);
-            el->handleElement(this, localName, isEmptyElement);
-            if (!isEmptyElement) {
-                int depthAfter = xmlTextReaderDepth(xmlReader);
-                if (depthBefore != depthAfter) {
-                    throw XmlParserException("Parser error. Depth wrong after parsing sub-tree for %s.", localName);
-                }
+    while (ret  && xmlReader->getNodeType() != XmlReader::nodeEndElement) {
+        int depthBefore = xmlReader->getDepth();
+        int isEmptyElement = xmlReader->isEmptyElement();
+        el->handleElement(this, xmlReader->getLocalName(), isEmptyElement);
+        if (!isEmptyElement) {
+            int depthAfter = xmlReader->getDepth();
+            if (depthBefore != depthAfter || xmlReader->getNodeType() != XmlReader::nodeEndElement) {
+                throw XmlParserException("Parser error. Depth wrong after parsing sub-tree for %s.",
+                    xmlReader->getLocalName());
             }
         }
         ret = readNextInXml();
@@ -172,7 +251,7 @@ void XmlParser::parseChildElements(Element *el) {
 
 void XmlParser::parseEndElement() {
     bool ret = readNextInXml();
-    while (ret  && xmlTextReaderNodeType(xmlReader) != XML_READER_TYPE_END_ELEMENT) {
+    while (ret  && xmlReader->getNodeType() != XmlReader::nodeEndElement) {
         ret = readNextInXml();
     }
     if (!ret) {
@@ -181,26 +260,122 @@ void XmlParser::parseEndElement() {
 }
 
 void XmlParser::parseSkipChildElement() {
-    int depthBefore = xmlTextReaderDepth(xmlReader);
-    int depth = 0;
-    do {
-        bool ret = readNextInXml();
-        if (!ret) {
-            throw XmlParserException("Error parsing xml file '%s'", xmlPath);
-        }
-        depth = xmlTextReaderDepth(xmlReader);
-    } while (depth >= depthBefore);
+    xmlReader->skipElement();
+}
+
+bool XmlParser::parseSkipSection(Section section, int isEmptyElement) {
+    if (sections & section) return false;
+    if (isEmptyElement) return true;
+    // read up to the end of the current element, without reading the elements in between
+    xmlReader->skipElement();
+    return true;
 }
 
 bool XmlParser::readNextInXml() {
-    int ret;
-    do {
-        ret = xmlTextReaderRead(xmlReader);
-    } while (ret == 1 && xmlTextReaderNodeType(xmlReader) == XML_READER_TYPE_COMMENT);
+    return xmlReader->read();
+}
+
+// The ScalarVariables of a ModelVariables section, split into chunks that are
+// parsed into model descriptions of their own by several threads.
+struct XmlParser::VariablesJob {
+    XmlParser *parser;                        // of the document
+    std::vector<const char *> starts;         // of the ScalarVariables, then of the end tag
+    size_t chunks;
+    std::atomic<size_t> next;                 // first chunk not yet taken by a thread
+    std::vector<ModelDescription *> results;  // per chunk
+    std::vector<char> failed;                 // per chunk
+
+    ~VariablesJob() {
+        for (std::vector<ModelDescription *>::const_iterator it = results.begin(); it != results.end(); ++it) {
+            delete *it;
+        }
+    }
+};
+
+void XmlParser::runVariablesJob(VariablesJob *job) {
+    size_t variables = job->starts.size() - 1;
+    for (size_t k = job->next++; k < job->chunks; k = job->next++) {
+        try {
+            job->results[k] = new ModelDescription;
+            XmlParser parser(job->parser->xmlPath);
+            parser.sections = job->parser->sections;
+            parser.parseVariables(*job->parser->xmlReader, job->starts[k * variables / job->chunks],
+                job->starts[(k + 1) * variables / job->chunks], job->results[k]);
+        } catch (XmlParserException &) {
+            job->failed[k] = 1;
+        } catch (std::bad_alloc &) {
+            job->failed[k] = 1;
+        }
+    }
+}
 
-    if (ret != 1) {
+void XmlParser::parseVariables(const XmlReader &document, const char *begin, const char *end,
+                               ModelDescription *chunk) {
+    XmlReader reader(document, begin, end - begin);
+    xmlReader = &reader;
+    arena = &chunk->arena;
+    while (readNextInXml()) {
+        const char *localName = reader.getLocalName();
+        if (checkElement(localName) != elm_ScalarVariable) {
+            throw XmlParserException("Element '%s' is not expected inside of '%s'.",
+                localName, elmNames[elm_ModelVariables]);
+        }
+        chunk->handleElement(this, localName, reader.isEmptyElement());
+    }
+    xmlReader = NULL;
+    arena = NULL;
+}
+
+bool XmlParser::parseModelVariables(ModelDescription *md) {
+    int n = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+    if (n <= 1) return false;
+
+    // find the ScalarVariables, reading up to the end of the section. On errors,
+    // the section is parsed again on this thread to report them as without threads.
+    XmlReader saved(*xmlReader);
+    VariablesJob job;
+    job.parser = this;
+    try {
+        xmlReader->skipElement(&job.starts);
+    } catch (XmlParserException &) {
+        *xmlReader = saved;
         return false;
     }
+    size_t variables = job.starts.size() - 1;
+    if (variables == 0) return true;
+    size_t size = job.starts.back() - job.starts.front();
+    job.chunks = size < PARALLEL_MIN_SIZE ? 1 : std::min(variables, (size_t)n * CHUNKS_PER_THREAD);
+    job.next = 0;
+    job.results.assign(job.chunks, NULL);
+    job.failed.assign(job.chunks, 0);
+
+    // this thread parses chunks too, and all chunks if no thread can be started
+    std::vector<std::thread> workers;
+    try {
+        for (int i = 1; i < n && (size_t)i < job.chunks; i++) {
+            workers.push_back(std::thread(runVariablesJob, &job));
+        }
+    } catch (std::system_error &) {
+    } catch (std::bad_alloc &) {
+    }
+    runVariablesJob(&job);
+    for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+    if (std::find(job.failed.begin(), job.failed.end(), 1) != job.failed.end()) {
+        *xmlReader = saved;
+        return false;
+    }
+
+    // append the variables in document order. The chunks are freed with the job.
+    md->modelVariables.reserve(md->modelVariables.size() + variables);
+    for (size_t k = 0; k < job.chunks; k++) {
+        ModelDescription *chunk = job.results[k];
+        md->arena.merge(chunk->arena);
+        md->modelVariables.insert(md->modelVariables.end(), chunk->modelVariables.begin(),
+            chunk->modelVariables.end());
+        chunk->modelVariables.clear();
+    }
     return true;
 }
 
@@ -208,27 +383,80 @@ bool XmlParser::readNextInXml() {
  * Helper functions to check validity of xml.
  * -------------------------------------------------------------------------*/
 
-// Returns the index of name in the array.
-// Throw exception if name not found (invalid).
-static int checkName(const char *name, const char *kind, const char *array[], int n) {
-    for (int i = 0; i < n; i++) {
-        if (!strcmp(name, array[i])) {
-            return i;
+// Perfect hash table of the names in one of the arrays elmNames, attNames and
+// enuNames. The constructor searches a seed for which every name hashes to a
+// different slot, so that a lookup costs one hash and one strcmp instead of a
+// strcmp per name. The tables are built from the arrays on first use and can
+// therefore not get out of sync with them.
+class NameTable {
+ private:
+    const char **names;
+    unsigned int seed;
+    int bits;
+    std::vector<unsigned char> slots;  // 1 + index of the name hashed to the slot, 0 if none
+
+ public:
+    NameTable(const char *array[], int n) {
+        names = array;
+        // with n*n/2 slots, a random seed is collision free with probability 1/e
+        for (bits = 1; (1 << bits) < n * n / 2; bits++);
+        for (seed = 1; !fill(n); seed++) {
+            if (seed % 64 == 0) bits++;
+        }
+    }
+    // return the index of name of given length in the array, -1 if not found.
+    int find(const char *name, size_t length) const {
+        int i = slots[slot(name, length)] - 1;
+        return (i >= 0 && !strncmp(name, names[i], length) && !names[i][length]) ? i : -1;
+    }
+
+ private:
+    unsigned int slot(const char *name, size_t length) const {
+        unsigned int h = seed;
+        for (size_t i = 0; i < length; i++) {
+            h = (h ^ (unsigned char)name[i]) * 16777619u;
+        }
+        return (h * 2654435769u) >> (32 - bits);
+    }
+    bool fill(int n) {
+        slots.assign((size_t)1 << bits, 0);
+        for (int i = 0; i < n; i++) {
+            unsigned char &s = slots[slot(names[i], strlen(names[i]))];
+            if (s) return false;
+            s = (unsigned char)(i + 1);
         }
+        return true;
     }
-    throw XmlParserException("Illegal %s %s", kind, name);
+};
+
+// Returns the index of name of given length in the table.
+// Throw exception if name not found (invalid).
+static int checkName(const char *name, size_t length, const char *kind, const NameTable &table) {
+    int i = table.find(name, length);
+    if (i < 0) {
+        std::string illegal(name, length);
+        throw XmlParserException("Illegal %s %s", kind, illegal.c_str());
+    }
+    return i;
 }
 
 XmlParser::Att XmlParser::checkAttribute(const char *att) {
-    return (XmlParser::Att)checkName(att, "attribute", XmlParser::attNames, XmlParser::SIZEOF_ATT);
+    return checkAttribute(att, strlen(att));
+}
+
+XmlParser::Att XmlParser::checkAttribute(const char *att, size_t length) {
+    static const NameTable table(XmlParser::attNames, XmlParser::SIZEOF_ATT);
+    return (XmlParser::Att)checkName(att, length, "attribute", table);
 }
 
 XmlParser::Elm XmlParser::checkElement(const char *elm) {
-    return (XmlParser::Elm)checkName(elm, "element", XmlParser::elmNames, XmlParser::SIZEOF_ELM);
+    static const NameTable table(XmlParser::elmNames, XmlParser::SIZEOF_ELM);
+    return (XmlParser::Elm)checkName(elm, strlen(elm), "element", table);
 }
 
 XmlParser::Enu XmlParser::checkEnumValue(const char *enu) {
-    return (XmlParser::Enu)checkName(enu, "enum value", XmlParser::enuNames, XmlParser::SIZEOF_ENU);
+    static const NameTable table(XmlParser::enuNames, XmlParser::SIZEOF_ENU);
+    return (XmlParser::Enu)checkName(enu, strlen(enu), "enum value", table);
 }
 
 ModelDescription *XmlParser::validate(ModelDescription *md) {
@@ -239,12 +467,14 @@ ModelDescription *XmlParser::validate(ModelDescription *md) {
         && md->getAttributeValue(XmlParser::att_modelName)
         && md->getAttributeValue(XmlParser::att_guid))) {
             logThis(ERROR_ERROR, "Model description miss required attributes in file %s", xmlPath);
+            delete md;
             return NULL;
     }
 
     if (!(md->coSimulation || md->modelExchange)) {
         logThis(ERROR_ERROR, "Model description must have a co-simulation or model exchange component in file %s",
             xmlPath);
+            delete md;
             return NULL;
     }
 
@@ -287,7 +517,7 @@ ModelDescription *XmlParser::validate(ModelDescription *md) {
                 errors++;
                 continue;
             }
-            if (!md->getSimpleType(typeName)) {
+            if ((sections & sec_TypeDefinitions) && !md->getSimpleType(typeName)) {
                 logThis(ERROR_ERROR, "Declared type %s of variable %s not found in modelDescription.xml",
                      typeName, varName);
                 errors++;
@@ -297,14 +527,16 @@ ModelDescription *XmlParser::validate(ModelDescription *md) {
     }
 
     // check existence of model structure
-    if (!(md->modelStructure)) {
+    if ((sections & sec_ModelStructure) && !(md->modelStructure)) {
         logThis(ERROR_ERROR, "Model description must contain model structure in file %s",
             xmlPath);
+        delete md;
         return NULL;
     }
 
     if (errors > 0) {
         logThis(ERROR_ERROR, "Found %d error in file %s", errors, xmlPath);
+        delete md;
         return NULL;
     }
     return md;
@@ -9,8 +9,15 @@
  * ---------------------------------------------------------------------------*/
 
 #include "XmlParserCApi.h"
+#include <new>
+#include <stdio.h>
 #include "fmu20/XmlParser.h"
+#include "fmu20/XmlDependencyMatrix.h"
 #include "fmu20/XmlElement.h"
+#include "fmu20/XmlModelCache.h"
+#include "fmu20/XmlParserException.h"
+#include "fmu20/XmlReader.h"
+#include "fmu20/XmlVariableTable.h"
 
 #ifdef STANDALONE_XML_PARSER
 #define logThis(n, ...) printf(__VA_ARGS__); printf("\n")
@@ -19,13 +26,76 @@
 #include "logging.h"  // logThis
 #endif  // STANDALONE_XML_PARSER
 
+// see setParserThreads
+static int parserThreads = 1;
+
 ModelDescription* parse(char* xmlPath) {
     XmlParser parser(xmlPath);
+    parser.setThreads(parserThreads);
+    return parser.parse();
+}
+ModelDescription* parseFromMemory(char* xmlName, const char *xml, int size) {
+    XmlParser parser(xmlName, xml, size);
+    parser.setThreads(parserThreads);
     return parser.parse();
 }
+ModelDescription* parseSections(char* xmlPath, int sections) {
+    XmlParser parser(xmlPath);
+    parser.setSections(sections);
+    parser.setThreads(parserThreads);
+    return parser.parse();
+}
+ModelDescription* parseSectionsFromMemory(char* xmlName, const char *xml, int size, int sections) {
+    XmlParser parser(xmlName, xml, size);
+    parser.setSections(sections);
+    parser.setThreads(parserThreads);
+    return parser.parse();
+}
+ModelDescription* parseWithCache(char* xmlPath, const char *cachePath, int sections) {
+    XmlMappedFile file;
+    if (!file.open(xmlPath)) {
+        logThis(ERROR_ERROR, "Unable to open '%s'", xmlPath);
+        return NULL;
+    }
+    const char *xml = file.getData();
+    int size = (int)file.getSize();
+    ModelDescription *md = XmlModelCache::load(cachePath, xml, size, sections);
+    if (!md) {
+        md = parseSectionsFromMemory(xmlPath, xml, size, sections);
+        if (md) XmlModelCache::store(cachePath, md, xml, size, sections);
+    }
+    return md;
+}
+void setParserThreads(int threads) {
+    parserThreads = threads;
+}
 void freeModelDescription(ModelDescription *md) {
     if (md) delete md;
 }
+VariableTable *buildVariableTable(ModelDescription *md) {
+    try {
+        return new VariableTable(md);
+    } catch (std::bad_alloc& ) {
+        return NULL;
+    }
+}
+void freeVariableTable(VariableTable *vt) {
+    if (vt) delete vt;
+}
+DependencyMatrix *buildDependencyMatrix(ModelDescription *md, Elm list) {
+    try {
+        return new DependencyMatrix(md, (XmlParser::Elm)list);
+    } catch (XmlParserException& e) {
+        logThis(ERROR_ERROR, "%s", e.what());
+        return NULL;
+    } catch (std::bad_alloc& ) {
+        logThis(ERROR_FATAL, "Out of memory");
+        return NULL;
+    }
+}
+void freeDependencyMatrix(DependencyMatrix *dm) {
+    if (dm) delete dm;
+}
 
 /* ModelDescription fields access*/
 int getUnitDefinitionsSize(ModelDescription *md) {
@@ -92,6 +162,14 @@ ScalarVariable *getVariable(ModelDescription *md, const char *name) {
     return md->getVariable(name);
 }
 
+ScalarVariable *getVariableByValueReference(ModelDescription *md, fmi2ValueReference vr, Elm type) {
+    return md->getVariable(vr, (XmlParser::Elm)type);
+}
+
+Unit *getUnit(ModelDescription *md, const char *name) {
+    return md->getUnit(name);
+}
+
 const char *getDescriptionForVariable(ModelDescription *md, ScalarVariable *sv) {
     return md->getDescriptionForVariable(sv);
 }
@@ -158,6 +236,91 @@ Enu getCausality(ScalarVariable *sv) {
     return (Enu)sv->getCausality();
 }
 
+/* VariableTable field access */
+int getVariableCount(VariableTable *vt) {
+    return vt->size;
+}
+
+int findVariableRow(VariableTable *vt, fmi2ValueReference vr, Elm type) {
+    return vt->find(vr, (XmlParser::Elm)type);
+}
+
+const char *getVariableName(VariableTable *vt, int row) {
+    return vt->getName(row);
+}
+
+const char *getVariableDescription(VariableTable *vt, int row) {
+    return vt->getDescription(row);
+}
+
+fmi2ValueReference getVariableValueReference(VariableTable *vt, int row) {
+    return vt->valueReferences[row];
+}
+
+Elm getVariableBaseType(VariableTable *vt, int row) {
+    return (Elm)vt->baseTypes[row];
+}
+
+Enu getVariableCausality(VariableTable *vt, int row) {
+    return (Enu)vt->causalities[row];
+}
+
+Enu getVariableVariability(VariableTable *vt, int row) {
+    return (Enu)vt->variabilities[row];
+}
+
+// value of the numeric column values at row, defined if flag is set
+static double getVariableValue(VariableTable *vt, const std::vector<double> &values, int row, int flag,
+                               ValueStatus *vs) {
+    *vs = (vt->flags[row] & flag) ? valueDefined : valueMissing;
+    return values[row];
+}
+
+double getVariableStart(VariableTable *vt, int row, ValueStatus *vs) {
+    return getVariableValue(vt, vt->starts, row, VariableTable::hasStart, vs);
+}
+
+double getVariableNominal(VariableTable *vt, int row, ValueStatus *vs) {
+    return getVariableValue(vt, vt->nominals, row, VariableTable::hasNominal, vs);
+}
+
+double getVariableMin(VariableTable *vt, int row, ValueStatus *vs) {
+    return getVariableValue(vt, vt->mins, row, VariableTable::hasMin, vs);
+}
+
+double getVariableMax(VariableTable *vt, int row, ValueStatus *vs) {
+    return getVariableValue(vt, vt->maxs, row, VariableTable::hasMax, vs);
+}
+
+/* DependencyMatrix field access */
+int getDependencyRowCount(DependencyMatrix *dm) {
+    return dm->rows;
+}
+
+int getDependencyUnknown(DependencyMatrix *dm, int row) {
+    return dm->unknowns[row];
+}
+
+int getDependsOnAll(DependencyMatrix *dm, int row) {
+    return dm->dependsOnAll[row];
+}
+
+const int *getDependencyRowStarts(DependencyMatrix *dm) {
+    return &dm->rowStarts[0];
+}
+
+const int *getDependencyColumns(DependencyMatrix *dm) {
+    return dm->columns.empty() ? NULL : &dm->columns[0];
+}
+
+Enu getDependencyKind(DependencyMatrix *dm, int entry) {
+    return (Enu)dm->kinds[entry];
+}
+
+fmi2ValueReference getDependencyValueReference(DependencyMatrix *dm, int index) {
+    return dm->valueReferences[index];
+}
+
 /* Component field access */
 int getFilesSize(Component *c) {
     return c->files.size();
@@ -204,18 +367,16 @@ const char *getElementTypeName(Element *el) {
 }
 
 const char **getAttributesAsArray(Element *el, int *n) {
-    *n = el->attributes.size();
+    *n = el->nAttributes;
     const char **result = (const char **)calloc(2 * (*n), sizeof(char *));
     if (!result) {
         logThis(ERROR_FATAL, "Out of memory");
         n = 0;
         return NULL;
     }
-    int i = 0;
-    for (std::map<XmlParser::Att, char *>::iterator it = el->attributes.begin(); it != el->attributes.end(); ++it ) {
-        result[i] = (const char*)XmlParser::attNames[it->first];
-        result[i + 1] = it->second;
-        i = i + 2;
+    for (int i = 0; i < el->nAttributes; i++) {
+        result[2 * i] = (const char*)XmlParser::attNames[el->attributes[i].att];
+        result[2 * i + 1] = el->attributes[i].value;
     }
     return result;
 }
@@ -28,6 +28,10 @@ typedef struct SimpleType SimpleType;
 typedef struct Unit Unit;
 typedef struct ListElement ListElement;
 typedef struct Element Element;
+// columnar table of the variables, built from ModelDescription
+typedef struct VariableTable VariableTable;
+// dependencies of the unknowns of a list of ModelStructure, built from ModelDescription
+typedef struct DependencyMatrix DependencyMatrix;
 
 // Elements names used in ModelDescription.xml
 typedef enum {
@@ -68,6 +72,20 @@ typedef enum {
     enu_approx, enu_calculated
 } Enu;
 
+// Sections of ModelDescription.xml, combined to a mask for parseSections().
+// ModelExchange and CoSimulation are always parsed.
+typedef enum {
+    sec_UnitDefinitions   = 1 << 0,
+    sec_TypeDefinitions   = 1 << 1,
+    sec_LogCategories     = 1 << 2,
+    sec_DefaultExperiment = 1 << 3,
+    sec_VendorAnnotations = 1 << 4,
+    sec_ModelVariables    = 1 << 5,
+    sec_Annotations       = 1 << 6,  // Annotations of the ScalarVariables
+    sec_ModelStructure    = 1 << 7,
+    sec_ALL               = (1 << 8) - 1
+} Section;
+
 typedef enum {
     valueMissing,
     valueDefined,
@@ -79,7 +97,35 @@ typedef enum {
 // function user can access all other elements from ModelDescription.xml.
 // The receiver must call freeModelDescription(md) to release AST memory.
 ModelDescription* parse(char* xmlPath);
+// Same as parse() for a model description read into memory, e.g. from the FMU archive.
+// xmlName is used in error messages only.
+ModelDescription* parseFromMemory(char* xmlName, const char *xml, int size);
+// Same as parse() and parseFromMemory(), but builds only the sections in the mask
+// sections, a combination of Section values. The other sections are skipped
+// without building their elements and are empty in the result, e.g. lookups of
+// types return NULL when sec_TypeDefinitions is not in the mask.
+ModelDescription* parseSections(char* xmlPath, int sections);
+ModelDescription* parseSectionsFromMemory(char* xmlName, const char *xml, int size, int sections);
+// Same as parseSections(), but reuses the AST stored in the binary file cachePath
+// by an earlier call for the same xml content and sections. The file is
+// (re)written when it is missing or was written for other xml or sections.
+ModelDescription* parseWithCache(char* xmlPath, const char *cachePath, int sections);
+// Number of threads the parse functions use for the ScalarVariables of large
+// ModelVariables sections, 0 for one per core. Default 1.
+void setParserThreads(int threads);
 void freeModelDescription(ModelDescription *md);
+// Returns the table of the variables of md with their attributes decoded, see
+// fmu20/XmlVariableTable.h, NULL if out of memory. The table stays valid after
+// freeModelDescription(md). The receiver must call freeVariableTable(vt).
+VariableTable *buildVariableTable(ModelDescription *md);
+void freeVariableTable(VariableTable *vt);
+// Returns the dependencies of the Unknowns in list, one of elm_Outputs, elm_Derivatives,
+// elm_DiscreteStates and elm_InitialUnknowns, as a sparse matrix in compressed sparse
+// row format, see fmu20/XmlDependencyMatrix.h. NULL if out of memory or an Unknown of
+// the list is invalid. The matrix stays valid after freeModelDescription(md).
+// The receiver must call freeDependencyMatrix(dm).
+DependencyMatrix *buildDependencyMatrix(ModelDescription *md, Elm list);
+void freeDependencyMatrix(DependencyMatrix *dm);
 
 
 /* ModelDescription functions */
@@ -116,6 +162,12 @@ ModelStructure  *getModelStructure (ModelDescription *md);
 SimpleType *getSimpleType(ModelDescription *md, const char *name);
 // get the ScalarVariable by name, if any. NULL if not found.
 ScalarVariable *getVariable(ModelDescription *md, const char *name);
+// get the ScalarVariable by vr and type, one of elm_Real, elm_Integer, elm_Boolean,
+// elm_String or elm_Enumeration. Integer and Enumeration variables share their
+// value references. NULL if not found.
+ScalarVariable *getVariableByValueReference(ModelDescription *md, fmi2ValueReference vr, Elm type);
+// get the Unit as defined in UnitDefinitions. NULL if not found.
+Unit *getUnit(ModelDescription *md, const char *name);
 // get description from variable, if not present look for type definition description.
 const char *getDescriptionForVariable(ModelDescription *md, ScalarVariable *sv);
 
@@ -156,6 +208,48 @@ Enu getVariability(ScalarVariable *sv);
 // If unknown value, return enu_BAD_DEFINED.
 Enu getCausality(ScalarVariable *sv);
 
+/* VariableTable functions, row i is the i-th ScalarVariable of the model description */
+// get number of rows
+int getVariableCount(VariableTable *vt);
+// get the row of the variable by vr and type, as getVariableByValueReference. -1 if not found.
+int findVariableRow(VariableTable *vt, fmi2ValueReference vr, Elm type);
+const char *getVariableName(VariableTable *vt, int row);
+// "" if the variable has no description
+const char *getVariableDescription(VariableTable *vt, int row);
+fmi2ValueReference getVariableValueReference(VariableTable *vt, int row);
+// one of elm_Real, elm_Integer, elm_Boolean, elm_String, elm_Enumeration
+Elm getVariableBaseType(VariableTable *vt, int row);
+// as getCausality and getVariability of the ScalarVariable
+Enu getVariableCausality(VariableTable *vt, int row);
+Enu getVariableVariability(VariableTable *vt, int row);
+// numeric attribute values, vs is valueMissing if not defined or invalid. Boolean
+// start values are 0 or 1, String start values are always missing. nominal, min
+// and max are taken from the declared type if the variable does not define them.
+double getVariableStart(VariableTable *vt, int row, ValueStatus *vs);
+double getVariableNominal(VariableTable *vt, int row, ValueStatus *vs);
+double getVariableMin(VariableTable *vt, int row, ValueStatus *vs);
+double getVariableMax(VariableTable *vt, int row, ValueStatus *vs);
+
+/* DependencyMatrix functions, row r is the r-th Unknown of the list. Variables are
+   given by their 0 based index in ModelVariables. */
+// get number of rows
+int getDependencyRowCount(DependencyMatrix *dm);
+// get the index of the unknown of row
+int getDependencyUnknown(DependencyMatrix *dm, int row);
+// 1 if the unknown of row may depend on all knowns, because it has no dependencies
+// attribute. The row has no entries then. Otherwise 0.
+int getDependsOnAll(DependencyMatrix *dm, int row);
+// get the row count + 1 offsets of the rows into the entries. The entries of row r
+// are rowStarts[r] to rowStarts[r + 1] - 1.
+const int *getDependencyRowStarts(DependencyMatrix *dm);
+// get the index of the known of each entry
+const int *getDependencyColumns(DependencyMatrix *dm);
+// get the dependenciesKind of entry, one of enu_dependent, enu_constant, enu_fixed,
+// enu_tunable, enu_discrete
+Enu getDependencyKind(DependencyMatrix *dm, int entry);
+// get the value reference of the variable at index
+fmi2ValueReference getDependencyValueReference(DependencyMatrix *dm, int index);
+
 /* Component functions */
 // get number of files
 int getFilesSize(Component *c);
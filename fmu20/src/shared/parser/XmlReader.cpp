@@ -0,0 +1,493 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlReader.cpp
+ * Pull parser for the xml model description of a FMI 2.0 model, reading
+ * from a document mapped into memory.
+ * ---------------------------------------------------------------------------*/
+
+#include "fmu20/XmlReader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fmu20/XmlParserException.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* -------------------------------------------------------------------------*
+ * XmlMappedFile
+ * -------------------------------------------------------------------------*/
+
+XmlMappedFile::XmlMappedFile() {
+    data = NULL;
+    size = 0;
+}
+
+XmlMappedFile::~XmlMappedFile() {
+    if (size == 0) return;
+#ifdef _WIN32
+    free((char *)data);
+#else
+    munmap((void *)data, size);
+#endif
+}
+
+bool XmlMappedFile::open(const char *path) {
+#ifdef _WIN32
+    FILE *file = fopen(path, "rb");
+    long length;
+    if (!file) return false;
+    if (0 == fseek(file, 0, SEEK_END) && (length = ftell(file)) >= 0 && 0 == fseek(file, 0, SEEK_SET)) {
+        char *content = length > 0 ? (char *)malloc(length) : NULL;
+        if (content && fread(content, 1, length, file) == (size_t)length) {
+            data = content;
+            size = length;
+        } else {
+            free(content);
+        }
+        if (length == 0) data = "";
+    }
+    fclose(file);
+#else
+    struct stat st;
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    if (0 == fstat(fd, &st)) {
+        if (st.st_size == 0) {
+            data = "";
+        } else {
+            void *content = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (content != MAP_FAILED) {
+                data = (const char *)content;
+                size = st.st_size;
+            }
+        }
+    }
+    close(fd);
+#endif
+    return data != NULL;
+}
+
+/* -------------------------------------------------------------------------*
+ * XmlReader
+ * -------------------------------------------------------------------------*/
+
+// classes of characters in a document
+#define CHAR_NAME   1   // part of an element or attribute name
+#define CHAR_SPACE  2   // white space
+#define CHAR_DECODE 4   // to be decoded in an attribute value
+#define CHAR_HIGH   8   // not ASCII, to be decoded in ISO-8859-1 documents
+#define CHAR_LT     16  // not allowed in an attribute value
+
+class CharClasses {
+ private:
+    unsigned char classes[256];
+
+ public:
+    CharClasses() {
+        for (int c = 0; c < 256; c++) {
+            unsigned char cls = 0;
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                    || c == '_' || c == ':' || c == '-' || c == '.' || c >= 0x80) {
+                cls |= CHAR_NAME;
+            }
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') cls |= CHAR_SPACE;
+            if (c == '&' || c == '\t' || c == '\n' || c == '\r') cls |= CHAR_DECODE;
+            if (c >= 0x80) cls |= CHAR_HIGH;
+            if (c == '<') cls |= CHAR_LT;
+            classes[c] = cls;
+        }
+    }
+    unsigned char operator[](char c) const {
+        return classes[(unsigned char)c];
+    }
+};
+
+static const CharClasses &charClasses() {
+    static const CharClasses classes;
+    return classes;
+}
+
+// true if the s of given length equals the 0 terminated string ignoring case of ASCII letters
+static bool equalIgnoreCase(const char *s, size_t length, const char *name) {
+    for (size_t i = 0; i < length; i++) {
+        char c = s[i];
+        if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+        if (c != name[i]) return false;  // also if name ends first
+    }
+    return name[length] == 0;
+}
+
+// append the UTF-8 encoding of the code point c to s
+static void appendUtf8(std::string &s, unsigned long c) {
+    if (c < 0x80) {
+        s += (char)c;
+    } else if (c < 0x800) {
+        s += (char)(0xC0 | (c >> 6));
+        s += (char)(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        s += (char)(0xE0 | (c >> 12));
+        s += (char)(0x80 | ((c >> 6) & 0x3F));
+        s += (char)(0x80 | (c & 0x3F));
+    } else {
+        s += (char)(0xF0 | (c >> 18));
+        s += (char)(0x80 | ((c >> 12) & 0x3F));
+        s += (char)(0x80 | ((c >> 6) & 0x3F));
+        s += (char)(0x80 | (c & 0x3F));
+    }
+}
+
+XmlReader::XmlReader(const char *xml, size_t size, const char *xmlName) {
+    this->xmlName = xmlName;
+    begin = xml;
+    end = xml + size;
+    pos = xml;
+    latin1 = false;
+    nodeType = nodeNone;
+    depth = 0;
+    emptyElement = false;
+    if (size >= 3 && !memcmp(xml, "\xEF\xBB\xBF", 3)) {
+        pos += 3;
+    } else if (size >= 2 && (!memcmp(xml, "\xFE\xFF", 2) || !memcmp(xml, "\xFF\xFE", 2))) {
+        throwError("Unsupported encoding UTF-16");
+    }
+    readXmlDeclaration();
+}
+
+XmlReader::XmlReader(const XmlReader &reader, const char *fragment, size_t size) {
+    xmlName = reader.xmlName;
+    begin = reader.begin;
+    end = fragment + size;
+    pos = fragment;
+    latin1 = reader.latin1;
+    nodeType = nodeNone;
+    depth = 0;
+    emptyElement = false;
+}
+
+void XmlReader::readXmlDeclaration() {
+    if (end - pos < 6 || memcmp(pos, "<?xml", 5) || !(charClasses()[pos[5]] & CHAR_SPACE)) return;
+    const char *start = pos;
+    skipPast("?>");
+    // the encoding pseudo attribute, if any
+    static const char encoding[] = "encoding";
+    const char *p = start;
+    for (; p + sizeof(encoding) < pos; p++) {
+        if (!memcmp(p, encoding, sizeof(encoding) - 1)) break;
+    }
+    if (p + sizeof(encoding) >= pos) return;
+    p += sizeof(encoding) - 1;
+    while (p < pos && (charClasses()[*p] & CHAR_SPACE || *p == '=')) p++;
+    if (p >= pos || (*p != '"' && *p != '\'')) return;
+    const char *value = p + 1;
+    const char *valueEnd = (const char *)memchr(value, *p, pos - value);
+    if (!valueEnd) return;
+    size_t length = valueEnd - value;
+    if (equalIgnoreCase(value, length, "ISO-8859-1") || equalIgnoreCase(value, length, "LATIN1")) {
+        latin1 = true;
+    } else if (!(equalIgnoreCase(value, length, "UTF-8") || equalIgnoreCase(value, length, "UTF8")
+            || equalIgnoreCase(value, length, "US-ASCII") || equalIgnoreCase(value, length, "ASCII"))) {
+        std::string name(value, length);
+        throw XmlParserException("Unsupported encoding %s of xml file '%s'", name.c_str(), xmlName);
+    }
+}
+
+bool XmlReader::read() {
+    const CharClasses &classes = charClasses();
+    for (;;) {
+        // skip text up to the next tag
+        const char *lt = (const char *)memchr(pos, '<', end - pos);
+        if (openElements.empty()) {
+            for (const char *p = pos; p < (lt ? lt : end); p++) {
+                if (!(classes[*p] & CHAR_SPACE)) {
+                    pos = p;
+                    throwError("Content outside of the root element");
+                }
+            }
+        }
+        if (!lt) {
+            pos = end;
+            if (!openElements.empty()) throwError("Premature end of data");
+            nodeType = nodeNone;
+            return false;
+        }
+        pos = lt;
+        if (pos + 1 >= end) throwError("Premature end of data");
+        switch (pos[1]) {
+            case '/':
+                readEndTag();
+                return true;
+            case '?':
+                skipPast("?>");
+                break;
+            case '!':
+                skipMarkupDeclaration();
+                break;
+            default:
+                readStartTag();
+                return true;
+        }
+    }
+}
+
+void XmlReader::readStartTag() {
+    const CharClasses &classes = charClasses();
+    pos++;
+    const char *name = readName();
+    size_t nameLength = pos - name;
+    const char *colon = (const char *)memchr(name, ':', nameLength);
+    if (colon) {
+        localName.assign(colon + 1, name + nameLength - colon - 1);
+    } else {
+        localName.assign(name, nameLength);
+    }
+    attributes.clear();
+    for (;;) {
+        const char *before = pos;
+        skipSpace();
+        if (pos >= end) throwError("Premature end of data in tag");
+        if (*pos == '>') {
+            pos++;
+            emptyElement = false;
+            break;
+        }
+        if (*pos == '/') {
+            if (pos + 1 >= end || pos[1] != '>') throwError("Expected '>' after '/'");
+            pos += 2;
+            emptyElement = true;
+            break;
+        }
+        if (pos == before) throwError("Expected white space before attribute");
+        Attribute att;
+        att.name = readName();
+        att.nameLength = pos - att.name;
+        skipSpace();
+        if (pos >= end || *pos != '=') throwError("Expected '=' after attribute name");
+        pos++;
+        skipSpace();
+        if (pos >= end || (*pos != '"' && *pos != '\'')) throwError("Expected quoted attribute value");
+        att.value = pos + 1;
+        const char *quote = (const char *)memchr(att.value, *pos, end - att.value);
+        if (!quote) throwError("Unterminated attribute value");
+        att.valueLength = quote - att.value;
+        unsigned char cls = 0;
+        for (const char *p = att.value; p < quote; p++) {
+            cls |= classes[*p];
+        }
+        if (cls & CHAR_LT) throwError("Unescaped '<' not allowed in attribute value");
+        att.decode = (cls & CHAR_DECODE) || (latin1 && (cls & CHAR_HIGH));
+        attributes.push_back(att);
+        pos = quote + 1;
+    }
+    nodeType = nodeElement;
+    depth = (int)openElements.size();
+    if (!emptyElement) {
+        openElements.push_back(std::make_pair(name, nameLength));
+    }
+}
+
+void XmlReader::readEndTag() {
+    pos += 2;
+    const char *name = readName();
+    size_t nameLength = pos - name;
+    skipSpace();
+    if (pos >= end || *pos != '>') throwError("Expected '>' at end of tag");
+    if (openElements.empty() || openElements.back().second != nameLength
+            || memcmp(openElements.back().first, name, nameLength)) {
+        pos = name;
+        throwError("Opening and ending tag mismatch");
+    }
+    pos++;
+    openElements.pop_back();
+    const char *colon = (const char *)memchr(name, ':', nameLength);
+    if (colon) {
+        localName.assign(colon + 1, name + nameLength - colon - 1);
+    } else {
+        localName.assign(name, nameLength);
+    }
+    attributes.clear();
+    nodeType = nodeEndElement;
+    depth = (int)openElements.size();
+    emptyElement = false;
+}
+
+void XmlReader::skipMarkupDeclaration() {
+    size_t left = end - pos;
+    if (left >= 4 && !memcmp(pos, "<!--", 4)) {
+        pos += 4;
+        skipPast("-->");
+    } else if (left >= 9 && !memcmp(pos, "<![CDATA[", 9)) {
+        pos += 9;
+        skipPast("]]>");
+    } else if (left >= 9 && !memcmp(pos, "<!DOCTYPE", 9)) {
+        // up to the '>' that is not in the internal subset or quoted
+        int brackets = 0;
+        for (pos += 9; pos < end; pos++) {
+            char c = *pos;
+            if (c == '"' || c == '\'') {
+                const char *quote = (const char *)memchr(pos + 1, c, end - pos - 1);
+                if (!quote) break;
+                pos = quote;
+            } else if (c == '[') {
+                brackets++;
+            } else if (c == ']') {
+                brackets--;
+            } else if (c == '>' && brackets <= 0) {
+                pos++;
+                return;
+            }
+        }
+        throwError("Unterminated document type declaration");
+    } else {
+        throwError("Unexpected markup declaration");
+    }
+}
+
+void XmlReader::skipPast(const char *terminator) {
+    size_t length = strlen(terminator);
+    const char *start = pos;
+    for (const char *p = pos; p + length <= end; p++) {
+        p = (const char *)memchr(p, terminator[0], end - p);
+        if (!p || p + length > end) break;
+        if (!memcmp(p, terminator, length)) {
+            pos = p + length;
+            return;
+        }
+    }
+    pos = start;
+    throwError("Unterminated comment, CDATA section or processing instruction");
+}
+
+void XmlReader::skipSpace() {
+    const CharClasses &classes = charClasses();
+    while (pos < end && (classes[*pos] & CHAR_SPACE)) pos++;
+}
+
+const char *XmlReader::readName() {
+    const CharClasses &classes = charClasses();
+    const char *name = pos;
+    while (pos < end && (classes[*pos] & CHAR_NAME)) pos++;
+    if (pos == name) throwError("Expected a name");
+    return name;
+}
+
+void XmlReader::skipElement(std::vector<const char *> *children) {
+    size_t level = 1;  // of elements open since the current one
+    for (;;) {
+        const char *lt = (const char *)memchr(pos, '<', end - pos);
+        if (!lt || lt + 1 >= end) {
+            pos = end;
+            throwError("Premature end of data");
+        }
+        pos = lt;
+        switch (pos[1]) {
+            case '/': {
+                if (--level == 0) {
+                    if (children) children->push_back(pos);
+                    readEndTag();
+                    return;
+                }
+                const char *gt = (const char *)memchr(pos, '>', end - pos);
+                if (!gt) throwError("Premature end of data in tag");
+                pos = gt + 1;
+                break;
+            }
+            case '?':
+                skipPast("?>");
+                break;
+            case '!':
+                skipMarkupDeclaration();
+                break;
+            default: {
+                // up to the '>' that is not quoted
+                const char *p = pos + 1;
+                for (; p < end && *p != '>'; p++) {
+                    if (*p == '"' || *p == '\'') {
+                        p = (const char *)memchr(p + 1, *p, end - p - 1);
+                        if (!p) break;
+                    }
+                }
+                if (!p || p >= end) throwError("Premature end of data in tag");
+                if (children && level == 1) children->push_back(pos);
+                if (p[-1] != '/') level++;
+                pos = p + 1;
+            }
+        }
+    }
+}
+
+int XmlReader::findAttribute(const char *name) const {
+    size_t length = strlen(name);
+    for (size_t i = 0; i < attributes.size(); i++) {
+        if (attributes[i].nameLength == length && !memcmp(attributes[i].name, name, length)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+const char *XmlReader::getAttributeValue(int i, size_t *length) {
+    const Attribute &att = attributes[i];
+    if (!att.decode) {
+        *length = att.valueLength;
+        return att.value;
+    }
+    decoded.clear();
+    const char *valueEnd = att.value + att.valueLength;
+    for (const char *p = att.value; p < valueEnd; p++) {
+        char c = *p;
+        if (c == '&') {
+            const char *semicolon = (const char *)memchr(p, ';', valueEnd - p);
+            if (!semicolon) throwError("Unterminated entity reference in attribute value");
+            const char *ref = p + 1;
+            size_t refLength = semicolon - ref;
+            if (refLength > 1 && ref[0] == '#') {
+                char *digitsEnd;
+                unsigned long code = ref[1] == 'x' ? strtoul(ref + 2, &digitsEnd, 16) : strtoul(ref + 1, &digitsEnd, 10);
+                if (digitsEnd != semicolon || code == 0 || code > 0x10FFFF) throwError("Invalid character reference");
+                appendUtf8(decoded, code);
+            } else if (refLength == 2 && !memcmp(ref, "lt", 2)) {
+                decoded += '<';
+            } else if (refLength == 2 && !memcmp(ref, "gt", 2)) {
+                decoded += '>';
+            } else if (refLength == 3 && !memcmp(ref, "amp", 3)) {
+                decoded += '&';
+            } else if (refLength == 4 && !memcmp(ref, "apos", 4)) {
+                decoded += '\'';
+            } else if (refLength == 4 && !memcmp(ref, "quot", 4)) {
+                decoded += '"';
+            } else {
+                std::string name(ref, refLength);
+                throw XmlParserException("Entity '%s' not defined in xml file '%s'", name.c_str(), xmlName);
+            }
+            p = semicolon;
+        } else if (c == '\r') {
+            // a line break \r\n, or a single \r, is normalized to one space
+            if (p + 1 < valueEnd && p[1] == '\n') p++;
+            decoded += ' ';
+        } else if (c == '\n' || c == '\t') {
+            decoded += ' ';
+        } else if (latin1 && (unsigned char)c >= 0x80) {
+            appendUtf8(decoded, (unsigned char)c);
+        } else {
+            decoded += c;
+        }
+    }
+    *length = decoded.size();
+    return decoded.data();
+}
+
+void XmlReader::throwError(const char *message) const {
+    int line = 1;
+    for (const char *p = begin; p < pos && p < end; p++) {
+        if (*p == '\n') line++;
+    }
+    throw XmlParserException("Error parsing xml file '%s' at line %d: %s", xmlName, line, message);
+}
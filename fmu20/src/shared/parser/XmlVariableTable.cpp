@@ -0,0 +1,103 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlVariableTable.cpp
+ * Columnar table of the ScalarVariables of a FMI 2.0 model description,
+ * decoded once from the AST.
+ * ---------------------------------------------------------------------------*/
+
+#include "fmu20/XmlVariableTable.h"
+#include <utility>
+#include <stdlib.h>
+#include <string.h>
+#include "fmu20/XmlElement.h"
+
+static unsigned long long refKey(fmi2ValueReference vr, XmlParser::Elm type) {
+    if (type == XmlParser::elm_Enumeration) type = XmlParser::elm_Integer;
+    return (unsigned long long)vr << 8 | (unsigned char)type;
+}
+
+// decode value, if not NULL, accepting what Element::getAttributeDouble accepts.
+// return true if defined and valid.
+static bool decodeDouble(const char *value, double *d) {
+    char *end;
+    if (!value) return false;
+    *d = strtod(value, &end);
+    return end != value;
+}
+
+// decode the start value of a variable of given base type
+static bool decodeStart(const char *value, XmlParser::Elm type, double *d) {
+    if (!value) return false;
+    switch (type) {
+        case XmlParser::elm_Real:
+            return decodeDouble(value, d);
+        case XmlParser::elm_Integer:
+        case XmlParser::elm_Enumeration: {
+            char *end;
+            *d = (int)strtol(value, &end, 10);
+            return end != value;
+        }
+        case XmlParser::elm_Boolean:
+            if (!strcmp(value, "true")) *d = 1;
+            else if (!strcmp(value, "false")) *d = 0;
+            else return false;
+            return true;
+        default:
+            return false;
+    }
+}
+
+VariableTable::VariableTable(ModelDescription *md) {
+    size = (int)md->modelVariables.size();
+    valueReferences.resize(size);
+    baseTypes.resize(size);
+    causalities.resize(size);
+    variabilities.resize(size);
+    flags.resize(size);
+    starts.resize(size);
+    nominals.resize(size);
+    mins.resize(size);
+    maxs.resize(size);
+    nameOffsets.resize(size);
+    descriptionOffsets.resize(size);
+    rowsByRef.reserve(size);
+    for (int i = 0; i < size; i++) {
+        ScalarVariable *sv = md->modelVariables[i];
+        XmlParser::Elm type = sv->typeSpec->type;
+        const char *name = sv->getAttributeValue(XmlParser::att_name);
+        const char *description = sv->getAttributeValue(XmlParser::att_description);
+        unsigned char f = 0;
+        valueReferences[i] = sv->getValueReference();
+        baseTypes[i] = (signed char)type;
+        causalities[i] = (signed char)sv->getCausality();
+        variabilities[i] = (signed char)sv->getVariability();
+        if (decodeStart(sv->typeSpec->getAttributeValue(XmlParser::att_start), type, &starts[i])) {
+            f |= hasStart;
+        }
+        if (decodeDouble(md->getAttributeFromTypeOrDeclaredType(sv, XmlParser::att_nominal), &nominals[i])) {
+            f |= hasNominal;
+        }
+        if (decodeDouble(md->getAttributeFromTypeOrDeclaredType(sv, XmlParser::att_min), &mins[i])) {
+            f |= hasMin;
+        }
+        if (decodeDouble(md->getAttributeFromTypeOrDeclaredType(sv, XmlParser::att_max), &maxs[i])) {
+            f |= hasMax;
+        }
+        flags[i] = f;
+        nameOffsets[i] = (unsigned int)names.size();
+        if (name) names.insert(names.end(), name, name + strlen(name));
+        names.push_back('\0');
+        descriptionOffsets[i] = (unsigned int)names.size();
+        if (description) names.insert(names.end(), description, description + strlen(description));
+        names.push_back('\0');
+        rowsByRef.insert(std::make_pair(refKey(valueReferences[i], type), i));
+    }
+}
+
+int VariableTable::find(fmi2ValueReference vr, XmlParser::Elm type) const {
+    std::unordered_map<unsigned long long, int>::const_iterator it = rowsByRef.find(refKey(vr, type));
+    return it != rowsByRef.end() ? it->second : -1;
+}
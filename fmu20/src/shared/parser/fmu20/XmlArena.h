@@ -0,0 +1,53 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlArena.h
+ * Memory of a model description of a FMI 2.0 model. Elements and attribute
+ * arrays are allocated from large blocks and released all at once with the
+ * arena. Attribute values are interned in a string pool, so that equal
+ * values such as "local" or "continuous" are stored only once.
+ * ---------------------------------------------------------------------------*/
+
+#ifndef FMU20_XML_ARENA_H
+#define FMU20_XML_ARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+class XmlArena {
+ private:
+    std::vector<char *> blocks;  // allocated blocks, freed in the destructor
+    char *next;                  // free memory in the current block
+    size_t left;                 // bytes left at next
+    std::vector<const char *> pool;  // open addressing hash set of interned strings, NULL if empty
+    size_t pooled;                   // number of strings in pool
+
+ public:
+    XmlArena();
+    ~XmlArena();
+    // return size bytes, aligned for any member of the elements.
+    // throw std::bad_alloc if out of memory.
+    void *allocate(size_t size);
+    // return a 0 terminated copy of the string s of given length, for strings
+    // unlikely to occur twice. throw std::bad_alloc if out of memory.
+    const char *copy(const char *s, size_t length);
+    // return the interned copy of the string s of given length, which needs
+    // not be 0 terminated. Equal strings return the same copy.
+    // throw std::bad_alloc if out of memory.
+    const char *intern(const char *s, size_t length);
+    // take over the memory of other, e.g. of elements parsed on another thread.
+    // other must not be used afterwards, except for destroying it.
+    // throw std::bad_alloc if out of memory, other is then unchanged.
+    void merge(XmlArena &other);
+
+ private:
+    char *allocateBlock(size_t size);
+    void growPool();
+    // not copyable
+    XmlArena(const XmlArena &);
+    XmlArena &operator=(const XmlArena &);
+};
+
+#endif // FMU20_XML_ARENA_H
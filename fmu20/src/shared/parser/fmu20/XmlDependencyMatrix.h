@@ -0,0 +1,45 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlDependencyMatrix.h
+ * Dependencies of the unknowns of a FMI 2.0 model, decoded from one list of
+ * the ModelStructure (Outputs, Derivatives, DiscreteStates or
+ * InitialUnknowns) into a sparse matrix in compressed sparse row format.
+ * Row r is the r-th Unknown of the list. Its entries are
+ * columns[rowStarts[r]] to columns[rowStarts[r + 1] - 1], the knowns it
+ * depends on in document order. Unknowns and knowns are given as 0 based
+ * indexes into ModelVariables, valueReferences maps them to value references.
+ * The matrix keeps no reference to the AST.
+ * ---------------------------------------------------------------------------*/
+
+#ifndef FMU20_XML_DEPENDENCY_MATRIX_H
+#define FMU20_XML_DEPENDENCY_MATRIX_H
+
+#include <vector>
+#include "fmu20/XmlParser.h"
+
+class ModelDescription;
+
+class DependencyMatrix {
+ public:
+    int rows;
+    std::vector<int> unknowns;                 // per row, index of the unknown
+    // per row, 1 if the Unknown has no dependencies attribute: it may depend on all
+    // knowns. Such rows have no entries.
+    std::vector<unsigned char> dependsOnAll;
+    std::vector<int> rowStarts;                // rows + 1 offsets into columns and kinds
+    std::vector<int> columns;                  // per entry, index of the known
+    std::vector<signed char> kinds;            // per entry, XmlParser::Enu of dependenciesKind
+    std::vector<fmi2ValueReference> valueReferences;  // of the variables, by index
+
+ public:
+    // decode the Unknowns of list, one of elm_Outputs, elm_Derivatives, elm_DiscreteStates
+    // and elm_InitialUnknowns, of md, which must have passed XmlParser::validate. The
+    // matrix is empty if the ModelStructure was not parsed.
+    // throw XmlParserException if an index or kind is invalid, std::bad_alloc if out of memory.
+    DependencyMatrix(ModelDescription *md, XmlParser::Elm list);
+};
+
+#endif // FMU20_XML_DEPENDENCY_MATRIX_H
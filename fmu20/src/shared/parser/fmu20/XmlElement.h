@@ -14,17 +14,45 @@
 #ifndef FMU20_XML_ELEMENT_H
 #define FMU20_XML_ELEMENT_H
 
-#include <map>
+#include <unordered_map>
 #include <vector>
+#include "fmu20/XmlArena.h"
 #include "fmu20/XmlParser.h"
 
+class XmlMappedFile;
+
+// hash and equality of 0 terminated strings, used to index elements by name
+struct StringHash {
+    size_t operator()(const char *s) const;
+};
+struct StringEqual {
+    bool operator()(const char *s1, const char *s2) const;
+};
+
+// attribute of an element. The value is held in the arena of the model description,
+// or in the cache file it was loaded from, see XmlModelCache.
+struct Attribute {
+    XmlParser::Att att;
+    const char *value;
+};
+
+// Elements are allocated in the arena of their model description, e.g. new (arena) Element.
 class Element {
  public:
     XmlParser::Elm type;  // element type
-    std::map<XmlParser::Att, char*> attributes;  // map with key one of XmlParser::Att
+    Attribute *attributes;  // array sorted by att, allocated in the arena
+    int nAttributes;
 
  public:
+    Element();
     virtual ~Element();
+    static void *operator new(size_t size, XmlArena *arena);
+    static void operator delete(void *p, XmlArena *arena);
+    // memory is released with the arena, delete only runs the destructor
+    static void operator delete(void *p);
+    // copy the n attributes of atts to the arena, sorted by att. If an att occurs more
+    // than once, the first value is kept.
+    void setAttributes(XmlArena *arena, Attribute *atts, int n);
     virtual void handleElement(XmlParser *parser, const char *childName, int isEmptyElement);
     virtual void printElement(int indent);
     const char *getAttributeValue(XmlParser::Att att);  // value or NULL if not present
@@ -128,6 +156,20 @@ class ModelStructure : public Element {
 };
 
 class ModelDescription : public Element {
+ public:
+    XmlArena arena;  // memory of all other elements and of the attribute values
+    XmlMappedFile *cacheFile;  // NULL or the mapped cache holding the attribute values
+
+ private:
+    // indexes used by the lookup functions below. Keys point to attribute values
+    // of the indexed elements. When several elements have the same key, the
+    // first one in document order is indexed.
+    bool indexed;
+    std::unordered_map<const char *, ScalarVariable *, StringHash, StringEqual> variablesByName;
+    std::unordered_map<unsigned long long, ScalarVariable *> variablesByRef;  // key from vr and base type
+    std::unordered_map<const char *, SimpleType *, StringHash, StringEqual> typesByName;
+    std::unordered_map<const char *, Unit *, StringHash, StringEqual> unitsByName;
+
  public:
     std::vector<Unit *> unitDefinitions;        // list of Units
     std::vector<SimpleType *> typeDefinitions;  // list of Types
@@ -143,8 +185,14 @@ class ModelDescription : public Element {
  public:
     ModelDescription();
     ~ModelDescription();
+    // the model description itself is allocated on the heap, it holds the arena
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
     void handleElement(XmlParser *parser, const char *childName, int isEmptyElement);
     void printElement(int indent);
+    // build the indexes of variables, types and units. Call once after all
+    // children are added, else the first lookup builds them.
+    void buildIndexes();
     // get the SimpleType definition by name, if any. NULL if not found.
     SimpleType *getSimpleType(const char *name);
     // get the ScalarVariable by name, if any. NULL if not found.
@@ -0,0 +1,32 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlModelCache.h
+ * Binary cache of a parsed model description of a FMI 2.0 model.
+ * The ModelDescription AST is serialized to a compact file, keyed by a hash
+ * of the xml content, that is mapped into memory and turned back into the
+ * AST on later loads without parsing the xml again.
+ * ---------------------------------------------------------------------------*/
+
+#ifndef FMU20_XML_MODEL_CACHE_H
+#define FMU20_XML_MODEL_CACHE_H
+
+class ModelDescription;
+
+class XmlModelCache {
+ public:
+    // return the model description stored in cachePath, or NULL if the file is
+    // missing, corrupt or was written for other xml content than xml or for
+    // other sections, see XmlParser::setSections. The attribute values of the
+    // result point into the mapped file, which stays mapped until it is freed.
+    // Caller must free the result if not NULL.
+    static ModelDescription *load(const char *cachePath, const char *xml, int size, int sections);
+    // write md, the result of parsing the given sections of xml, to cachePath.
+    // The file is replaced atomically, so concurrent readers see either the
+    // old or the new file. return false on errors.
+    static bool store(const char *cachePath, ModelDescription *md, const char *xml, int size, int sections);
+};
+
+#endif // FMU20_XML_MODEL_CACHE_H
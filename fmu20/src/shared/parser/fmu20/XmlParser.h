@@ -6,7 +6,7 @@
  * XmlParser.h
  * Parser for xml model description file of a FMI 2.0 model.
  * The result of parsing is a ModelDescription object that can be queried to
- * get necessary information. The parsing is based on libxml2.lib.
+ * get necessary information. The xml is read with XmlReader.
  *
  * Author: Adrian Tirea
  * ---------------------------------------------------------------------------*/
@@ -14,12 +14,7 @@
 #ifndef FMU20_XML_PARSER_H
 #define FMU20_XML_PARSER_H
 
-#include <libxml/xmlreader.h>
-
-#ifdef _MSC_VER
-#pragma comment(lib, "libxml2.lib")
-#pragma comment(lib, "wsock32.lib")
-#endif
+#include <stddef.h>
 
 #ifndef fmi2TypesPlatform_h
 // same as in FMI 2.0 specification
@@ -28,6 +23,8 @@ typedef unsigned int fmi2ValueReference;
 
 class Element;
 class ModelDescription;
+class XmlArena;
+class XmlReader;
 
 class XmlParser {
  public:
@@ -80,6 +77,20 @@ class XmlParser {
         enu_approx, enu_calculated
     };
 
+    // Sections of the model description, combined to a mask for setSections.
+    // ModelExchange and CoSimulation are always parsed.
+    enum Section {
+        sec_UnitDefinitions   = 1 << 0,
+        sec_TypeDefinitions   = 1 << 1,
+        sec_LogCategories     = 1 << 2,
+        sec_DefaultExperiment = 1 << 3,
+        sec_VendorAnnotations = 1 << 4,
+        sec_ModelVariables    = 1 << 5,
+        sec_Annotations       = 1 << 6,  // Annotations of the ScalarVariables
+        sec_ModelStructure    = 1 << 7,
+        sec_ALL               = (1 << 8) - 1
+    };
+
     // Possible results when retrieving an attribute value from an element
     enum ValueStatus {
         valueMissing,
@@ -89,7 +100,13 @@ class XmlParser {
 
  private:
     char *xmlPath;
-    xmlTextReaderPtr xmlReader;
+    const char *xmlBuffer;  // NULL if parsing the file at xmlPath
+    int xmlSize;
+    XmlReader *xmlReader;
+    XmlArena *arena;  // of the model description being parsed
+    int sections;     // mask of the sections to parse
+    int threads;      // to parse the ModelVariables on, 0 for one per core
+    struct VariablesJob;
 
  public:
     // return the type of this element. Int value match the index in elmNames.
@@ -98,16 +115,27 @@ class XmlParser {
     // return the type of this attribute. Int value match the index in attNames.
     // throw XmlParserException if attribute is invalid.
     static XmlParser::Att checkAttribute(const char* att);
+    // same for the attribute name att of given length, which needs not be 0 terminated.
+    static XmlParser::Att checkAttribute(const char* att, size_t length);
     // return the type of this enum value. Int value match the index in enuNames.
     // throw XmlParserException if enu is invalid.
     static XmlParser::Enu checkEnumValue(const char* enu);
 
-    // Obs. the destructor calls xmlCleanupParser(). This is a single call for all parsers instantiated.
-    // Be carefully how you link XmlParser (i.e. multithreading, more parsers started at once).
+    // parse the xml file at xmlPath, which is mapped into memory while parsing
     explicit XmlParser(char *xmlPath);
+    // parse xml held in memory, xmlName is used in error messages only
+    XmlParser(char *xmlName, const char *xml, int size);
     ~XmlParser();
+    // parse only the sections in the mask, a combination of Section values.
+    // The other sections are skipped and stay empty in the result. Default sec_ALL.
+    void setSections(int sections);
+    // parse the ScalarVariables of large ModelVariables sections in chunks on
+    // the given number of threads, 0 for one per core. Default 1.
+    void setThreads(int threads);
     // return NULL on errors. Caller must free the result if not NULL.
     ModelDescription *parse();
+    // the arena to allocate elements of the model description being parsed in
+    XmlArena *getArena() { return arena; }
 
     // throw XmlParserException if attribute invalid.
     void parseElementAttributes(Element *element);
@@ -116,13 +144,25 @@ class XmlParser {
     // Consume the end of an element that has no child, but is not empty. i.e. <a name="name"></a>
     void parseEndElement();
     void parseSkipChildElement();
+    // If section is not to be parsed, consume the current element including its
+    // children without building them and return true. Else return false.
+    bool parseSkipSection(Section section, int isEmptyElement);
+    // If parsing on several threads, parse the children of the current ModelVariables
+    // element, which must not be empty, into md and return true. Else, or if that
+    // fails, return false with nothing read, to parse the children on this thread.
+    bool parseModelVariables(ModelDescription *md);
 
  private:
-    // advance reading in xml and skip comments if present.
+    // advance reading in xml to the next start or end tag.
     bool readNextInXml();
+    // parse the ScalarVariables in the fragment [begin, end) of the document read
+    // by document into chunk.
+    void parseVariables(const XmlReader &document, const char *begin, const char *end, ModelDescription *chunk);
+    // parse the chunks of job not yet taken by other threads
+    static void runVariablesJob(VariablesJob *job);
 
     // check some properties of model description (i.e. each variable has valueReference, ...)
-    // if valid return the input model description, else return NULL.
+    // if valid return the input model description, else free it and return NULL.
     ModelDescription *validate(ModelDescription *md);
 };
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlReader.h
+ * Pull parser for the xml model description of a FMI 2.0 model.
+ * The reader steps through the start and end tags of a document held in
+ * memory, typically a file mapped with XmlMappedFile. Names and attribute
+ * values are returned as views into the document; only values with entity
+ * references, line breaks or non UTF-8 characters are decoded into a
+ * buffer. Text, comments, processing instructions, CDATA sections and the
+ * document type declaration are skipped. Supported encodings are UTF-8,
+ * US-ASCII and ISO-8859-1.
+ * ---------------------------------------------------------------------------*/
+
+#ifndef FMU20_XML_READER_H
+#define FMU20_XML_READER_H
+
+#include <stddef.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Content of a file mapped read only into memory, released in the destructor.
+class XmlMappedFile {
+ private:
+    const char *data;
+    size_t size;
+
+ public:
+    XmlMappedFile();
+    ~XmlMappedFile();
+    // map the file at path. return false if it cannot be opened or read.
+    bool open(const char *path);
+    // the content of the file, not 0 terminated
+    const char *getData() const { return data; }
+    size_t getSize() const { return size; }
+
+ private:
+    // not copyable
+    XmlMappedFile(const XmlMappedFile &);
+    XmlMappedFile &operator=(const XmlMappedFile &);
+};
+
+// Copies of a reader save its state, to read again from there.
+class XmlReader {
+ public:
+    enum NodeType {
+        nodeNone,
+        nodeElement,
+        nodeEndElement
+    };
+
+    // An attribute of the current element. name and raw value are views into the document.
+    struct Attribute {
+        const char *name;
+        size_t nameLength;
+        const char *value;   // as written between the quotes
+        size_t valueLength;
+        bool decode;         // true if value must be decoded, see getAttributeValue
+    };
+
+ private:
+    const char *xmlName;  // used in error messages only
+    const char *begin;    // the document, used to count lines in error messages
+    const char *end;
+    const char *pos;      // next character to read
+    bool latin1;          // document encoded in ISO-8859-1
+    NodeType nodeType;
+    int depth;
+    bool emptyElement;
+    std::string localName;                      // of the current element
+    std::vector<Attribute> attributes;          // of the current element
+    std::vector<std::pair<const char *, size_t> > openElements;  // qualified names of the enclosing elements
+    std::string decoded;                        // buffer for decoded attribute values
+
+ public:
+    // read the document of given size. xmlName is used in error messages only.
+    // throw XmlParserException if the encoding is not supported.
+    XmlReader(const char *xml, size_t size, const char *xmlName);
+    // read the fragment of given size of the document read by reader, e.g. a
+    // sequence of elements found by skipElement. Depths count from the fragment,
+    // line numbers in error messages from the document.
+    XmlReader(const XmlReader &reader, const char *fragment, size_t size);
+    // advance to the next start or end tag. return false at the end of the document.
+    // throw XmlParserException if the xml is not well formed.
+    bool read();
+    NodeType getNodeType() const { return nodeType; }
+    // 0 for the root element. An end tag has the depth of its start tag.
+    int getDepth() const { return depth; }
+    // true for an element written as <a/>, which has no end tag
+    bool isEmptyElement() const { return emptyElement; }
+    // name of the current element without namespace prefix, 0 terminated
+    const char *getLocalName() const { return localName.c_str(); }
+    int getAttributeCount() const { return (int)attributes.size(); }
+    const Attribute &getAttribute(int i) const { return attributes[i]; }
+    // return the index of the attribute of the current element with given
+    // qualified name, -1 if not found.
+    int findAttribute(const char *name) const;
+    // return the value of attribute i, not 0 terminated. Entity and character
+    // references are replaced, white space normalized and characters converted to
+    // UTF-8. The result is a view into the document if nothing had to be decoded,
+    // else into a buffer valid up to the next call.
+    // throw XmlParserException if the value has an unknown entity reference.
+    const char *getAttributeValue(int i, size_t *length);
+    // consume the content of the current element, which must not be empty, up to
+    // and including its end tag, without reading the attributes of the elements
+    // in between. The reader is then positioned on the end tag.
+    // If children is not NULL, the start of each child element is appended to it,
+    // followed by the start of the end tag.
+    void skipElement(std::vector<const char *> *children = NULL);
+
+ private:
+    void readXmlDeclaration();
+    void readStartTag();
+    void readEndTag();
+    // skip a comment, CDATA section or document type declaration at pos
+    void skipMarkupDeclaration();
+    void skipPast(const char *terminator);
+    void skipSpace();
+    const char *readName();
+    void throwError(const char *message) const;
+};
+
+#endif // FMU20_XML_READER_H
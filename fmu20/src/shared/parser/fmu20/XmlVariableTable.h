@@ -0,0 +1,65 @@
+/*
+ * Copyright QTronic GmbH. All rights reserved.
+ */
+
+/* ---------------------------------------------------------------------------*
+ * XmlVariableTable.h
+ * Columnar table of the ScalarVariables of a FMI 2.0 model description.
+ * The attributes used while simulating are decoded once, when the table is
+ * built from the AST, into one array per attribute. Row i describes the i-th
+ * ScalarVariable in document order. The table keeps no reference to the AST,
+ * which may be freed once the table is built.
+ * ---------------------------------------------------------------------------*/
+
+#ifndef FMU20_XML_VARIABLE_TABLE_H
+#define FMU20_XML_VARIABLE_TABLE_H
+
+#include <unordered_map>
+#include <vector>
+#include "fmu20/XmlParser.h"
+
+class ModelDescription;
+
+class VariableTable {
+ public:
+    // bits of flags, set if the attribute is defined and valid
+    enum Flag {
+        hasStart   = 1 << 0,  // not set for String variables, their start is not decoded
+        hasNominal = 1 << 1,
+        hasMin     = 1 << 2,
+        hasMax     = 1 << 3
+    };
+
+    int size;  // number of rows
+    std::vector<fmi2ValueReference> valueReferences;
+    std::vector<signed char> baseTypes;      // XmlParser::Elm of the type, e.g. elm_Real
+    std::vector<signed char> causalities;    // XmlParser::Enu, default enu_local
+    std::vector<signed char> variabilities;  // XmlParser::Enu, default enu_continuous
+    std::vector<unsigned char> flags;        // combination of Flag values
+    // numeric values, 0 if not defined. Boolean start values are 0 or 1.
+    // nominal, min and max are taken from the declared type if not given
+    // by the variable and TypeDefinitions were parsed.
+    std::vector<double> starts;
+    std::vector<double> nominals;
+    std::vector<double> mins;
+    std::vector<double> maxs;
+    std::vector<unsigned int> nameOffsets;  // into names
+    std::vector<unsigned int> descriptionOffsets;  // into names, to "" if there is no description
+    std::vector<char> names;                // the 0 terminated names and descriptions of all rows
+
+ private:
+    // row by value reference and base type, Enumeration counted as Integer. When
+    // several variables have the same key, the first one in document order is indexed.
+    std::unordered_map<unsigned long long, int> rowsByRef;
+
+ public:
+    // decode the variables of md, which must have passed XmlParser::validate.
+    // throw std::bad_alloc if out of memory.
+    explicit VariableTable(ModelDescription *md);
+    const char *getName(int row) const { return &names[nameOffsets[row]]; }
+    const char *getDescription(int row) const { return &names[descriptionOffsets[row]]; }
+    // return the row of the variable with given vr and base type, -1 if not found
+    int find(fmi2ValueReference vr, XmlParser::Elm type) const;
+};
+
+#endif // FMU20_XML_VARIABLE_TABLE_H
@@ -0,0 +1,568 @@
+/* -------------------------------------------------------------------------
+ * result_pyramid.cpp
+ * Writer and reader of the multi-resolution summary of a result, see
+ * result_pyramid.h. The writer keeps per level the bin being filled and
+ * the page of complete bins being filled. A complete bin is added to the
+ * bin being filled of the level above, so that each row is added to level
+ * 0 only. Pages hold as many bins as fit into PAGE_VALUES values, within
+ * 1 and MAX_PAGE_BINS bins.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include "result_pyramid.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+
+#define PYRAMID_MAGIC "FMRP"
+#define PYRAMID_VERSION 1
+#define HEADER_SIZE 32        // magic to nSignals
+#define TRAILER_SIZE 16       // offset of the index and rows
+#define PAGE_INDEX_SIZE 28    // offset, bins, time of first and last row
+#define BIN_SHIFT 6           // 64 rows per bin of level 0
+#define LEVEL_SHIFT 2         // 4 bins per bin of the level above
+#define MAX_LEVELS 29         // bins of 2^62 rows
+#define BIN_VALUES 3          // min, max and mean
+#define PAGE_VALUES (1 << 18)
+#define MAX_PAGE_BINS 1024
+
+static void putU32(std::vector<unsigned char> &out, uint32_t u) {
+    for (int i = 0; i < 4; i++) out.push_back((unsigned char)(u >> (8 * i)));
+}
+
+static void putU64(std::vector<unsigned char> &out, uint64_t u) {
+    for (int i = 0; i < 8; i++) out.push_back((unsigned char)(u >> (8 * i)));
+}
+
+static void putF64(std::vector<unsigned char> &out, double d) {
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    putU64(out, u);
+}
+
+static void putString(std::vector<unsigned char> &out, const char *s) {
+    size_t n = s ? strlen(s) : 0;
+    putU32(out, (uint32_t)n);
+    out.insert(out.end(), (const unsigned char *)s, (const unsigned char *)s + n);
+}
+
+static uint32_t getU32(const unsigned char *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t getU64(const unsigned char *p) {
+    return getU32(p) | (uint64_t)getU32(p + 4) << 32;
+}
+
+static double getF64(const unsigned char *p) {
+    uint64_t u = getU64(p);
+    double d;
+    memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+struct PageIndex {
+    uint64_t offset;
+    uint32_t bins;
+    double firstTime;
+    double lastTime;
+};
+
+struct PyramidLevel {
+    // the bin being filled, per column
+    std::vector<double> min;
+    std::vector<double> max;
+    std::vector<double> sum;
+    std::vector<uint64_t> count;         // values that are not NaN
+    uint64_t rows;
+    // the page being filled, per column pageBins bins of min, max and mean
+    std::vector<double> page;
+    uint32_t bins;                       // complete bins in page
+    uint64_t totalBins;                  // complete bins, incl. those in page
+    std::vector<PageIndex> pages;        // written
+};
+
+struct PyramidWriter {
+    FILE *file;
+    int nReals;
+    int nIntegers;
+    int nBooleans;
+    int nColumns;
+    uint32_t nSignals;
+    std::vector<unsigned char> signals;  // encoded signals, until the header is written
+    bool started;                        // true once the header is written
+    bool failed;
+    uint64_t written;                    // bytes written to file
+    uint64_t rows;
+    uint32_t pageBins;                   // bins per page
+    std::vector<PyramidLevel> levels;
+    std::vector<unsigned char> out;
+};
+
+static uint64_t binRows(size_t level) {
+    return (uint64_t)1 << (BIN_SHIFT + LEVEL_SHIFT * level);
+}
+
+static void resetBin(PyramidLevel &level) {
+    std::fill(level.min.begin(), level.min.end(), HUGE_VAL);
+    std::fill(level.max.begin(), level.max.end(), -HUGE_VAL);
+    std::fill(level.sum.begin(), level.sum.end(), 0.0);
+    std::fill(level.count.begin(), level.count.end(), 0);
+    level.rows = 0;
+}
+
+static void addLevel(PyramidWriter *w) {
+    w->levels.push_back(PyramidLevel());
+    PyramidLevel &level = w->levels.back();
+    level.min.resize(w->nColumns);
+    level.max.resize(w->nColumns);
+    level.sum.resize(w->nColumns);
+    level.count.resize(w->nColumns);
+    level.page.resize((size_t)w->pageBins * w->nColumns * BIN_VALUES);
+    level.bins = 0;
+    level.totalBins = 0;
+    resetBin(level);
+}
+
+static void writeBytes(PyramidWriter *w, const std::vector<unsigned char> &bytes) {
+    if (!bytes.empty() && fwrite(&bytes[0], 1, bytes.size(), w->file) != bytes.size()) w->failed = true;
+    w->written += bytes.size();
+}
+
+static void writeHeader(PyramidWriter *w) {
+    w->out.resize(4);
+    memcpy(&w->out[0], PYRAMID_MAGIC, 4);
+    putU32(w->out, PYRAMID_VERSION);
+    putU32(w->out, (uint32_t)w->nReals);
+    putU32(w->out, (uint32_t)w->nIntegers);
+    putU32(w->out, (uint32_t)w->nBooleans);
+    putU32(w->out, BIN_SHIFT);
+    putU32(w->out, LEVEL_SHIFT);
+    putU32(w->out, w->nSignals);
+    writeBytes(w, w->out);
+    writeBytes(w, w->signals);
+    std::vector<unsigned char>().swap(w->signals);
+    w->started = true;
+}
+
+static void writePage(PyramidWriter *w, PyramidLevel &level) {
+    size_t n = (size_t)level.bins * BIN_VALUES;
+    PageIndex page;
+    if (!level.bins) return;
+    page.offset = w->written;
+    page.bins = level.bins;
+    page.firstTime = level.page[0];                 // min of time in the first bin
+    page.lastTime = level.page[n - BIN_VALUES + 1]; // max of time in the last bin
+    level.pages.push_back(page);
+    w->out.clear();
+    for (int c = 0; c < w->nColumns; c++) {
+        const double *values = &level.page[(size_t)c * w->pageBins * BIN_VALUES];
+        for (size_t i = 0; i < n; i++) putF64(w->out, values[i]);
+    }
+    writeBytes(w, w->out);
+    level.bins = 0;
+}
+
+// Completes the bin being filled of level l and adds it to the bin of the
+// level above, which is added unless closing
+static void finishBin(PyramidWriter *w, size_t l, bool closing) {
+    if (!closing && l + 1 == w->levels.size()) addLevel(w);
+    PyramidLevel &level = w->levels[l];
+    PyramidLevel *above = l + 1 < w->levels.size() ? &w->levels[l + 1] : NULL;
+    for (int c = 0; c < w->nColumns; c++) {
+        double *bin = &level.page[((size_t)c * w->pageBins + level.bins) * BIN_VALUES];
+        bin[0] = level.min[c];
+        bin[1] = level.max[c];
+        bin[2] = level.count[c] ? level.sum[c] / level.count[c] : NAN;
+        if (above) {
+            if (level.min[c] < above->min[c]) above->min[c] = level.min[c];
+            if (level.max[c] > above->max[c]) above->max[c] = level.max[c];
+            above->sum[c] += level.sum[c];
+            above->count[c] += level.count[c];
+        }
+    }
+    if (above) above->rows += level.rows;
+    level.bins++;
+    level.totalBins++;
+    resetBin(level);
+    if (level.bins == w->pageBins) writePage(w, level);
+}
+
+static void addValue(PyramidLevel &level, int c, double d) {
+    if (d < level.min[c]) level.min[c] = d; // NaN is neither
+    if (d > level.max[c]) level.max[c] = d;
+    if (d == d) {
+        level.sum[c] += d;
+        level.count[c]++;
+    }
+}
+
+PyramidWriter *openPyramidWriter(FILE *file, int nReals, int nIntegers, int nBooleans) {
+    PyramidWriter *w = NULL;
+    try {
+        size_t nValues;
+        w = new PyramidWriter();
+        w->file = file;
+        w->nReals = nReals;
+        w->nIntegers = nIntegers;
+        w->nBooleans = nBooleans;
+        w->nColumns = 1 + nReals + nIntegers + nBooleans;
+        w->nSignals = 0;
+        w->started = false;
+        w->failed = false;
+        w->written = 0;
+        w->rows = 0;
+        nValues = (size_t)w->nColumns * BIN_VALUES;
+        w->pageBins = (uint32_t)(PAGE_VALUES / nValues < 1 ? 1
+                                 : PAGE_VALUES / nValues > MAX_PAGE_BINS ? MAX_PAGE_BINS : PAGE_VALUES / nValues);
+        addLevel(w);
+    } catch (const std::bad_alloc &) {
+        delete w;
+        return NULL;
+    }
+    return w;
+}
+
+int addPyramidSignal(PyramidWriter *w, const char *name, int column) {
+    try {
+        putU32(w->signals, (uint32_t)column);
+        putString(w->signals, name);
+        w->nSignals++;
+    } catch (const std::bad_alloc &) {
+        return 0;
+    }
+    return 1;
+}
+
+int appendPyramidRow(PyramidWriter *w, double time, const double *reals, const int *integers, const int *booleans) {
+    int c = 0;
+    try {
+        if (!w->started) writeHeader(w);
+        PyramidLevel &level = w->levels[0];
+        addValue(level, c++, time);
+        for (int i = 0; i < w->nReals; i++) addValue(level, c++, reals[i]);
+        for (int i = 0; i < w->nIntegers; i++) addValue(level, c++, integers[i]);
+        for (int i = 0; i < w->nBooleans; i++) addValue(level, c++, booleans[i] ? 1 : 0);
+        level.rows++;
+        w->rows++;
+        for (size_t l = 0; l < w->levels.size() && w->levels[l].rows == binRows(l); l++) finishBin(w, l, false);
+    } catch (const std::bad_alloc &) {
+        w->failed = true;
+    }
+    return !w->failed;
+}
+
+int closePyramidWriter(PyramidWriter *w) {
+    int ok;
+    try {
+        uint64_t indexOffset;
+        if (!w->started) writeHeader(w);
+        for (size_t l = 0; l < w->levels.size(); l++) {
+            if (w->levels[l].rows) finishBin(w, l, true);
+            writePage(w, w->levels[l]);
+        }
+        indexOffset = w->written;
+        w->out.clear();
+        putU32(w->out, (uint32_t)w->levels.size());
+        for (size_t l = 0; l < w->levels.size(); l++) {
+            const PyramidLevel &level = w->levels[l];
+            putU64(w->out, level.totalBins);
+            putU32(w->out, (uint32_t)level.pages.size());
+            for (size_t i = 0; i < level.pages.size(); i++) {
+                putU64(w->out, level.pages[i].offset);
+                putU32(w->out, level.pages[i].bins);
+                putF64(w->out, level.pages[i].firstTime);
+                putF64(w->out, level.pages[i].lastTime);
+            }
+        }
+        putU64(w->out, indexOffset);
+        putU64(w->out, w->rows);
+        writeBytes(w, w->out);
+    } catch (const std::bad_alloc &) {
+        w->failed = true;
+    }
+    ok = !w->failed;
+    delete w;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+struct PyramidPage {
+    uint64_t offset;
+    uint32_t bins;
+    uint64_t firstBin;   // index of its first bin in the level
+    double firstTime;
+    double lastTime;
+};
+
+struct ReaderLevel {
+    uint64_t bins;
+    std::vector<PyramidPage> pages;
+};
+
+struct ResultPyramid {
+    FILE *file;
+    int nColumns;
+    uint32_t binShift;
+    uint32_t levelShift;
+    std::vector<std::string> names;
+    std::vector<int> columns;            // per signal
+    std::vector<ReaderLevel> levels;
+    uint64_t rows;
+    std::vector<unsigned char> block;    // the block read last
+    std::vector<double> times;           // the bins of time of the page read last
+    std::vector<double> values;          // the bins of the signal of the page read last
+};
+
+// Offsets are 64 bit, pyramids of long runs exceed the 2 GB of fseek
+static int seekFile(FILE *file, uint64_t offset, int origin) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, origin);
+#else
+    return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+static uint64_t tellFile(FILE *file) {
+#ifdef _WIN32
+    return (uint64_t)_ftelli64(file);
+#else
+    return (uint64_t)ftello(file);
+#endif
+}
+
+static int readString(FILE *file, std::string &s) {
+    unsigned char u[4];
+    if (fread(u, 1, 4, file) != 4) return 0;
+    s.resize(getU32(u));
+    return s.empty() || fread(&s[0], 1, s.size(), file) == s.size();
+}
+
+static int readSignals(ResultPyramid *rp, uint32_t nSignals) {
+    unsigned char u[4];
+    for (uint32_t i = 0; i < nSignals; i++) {
+        std::string name;
+        if (fread(u, 1, 4, rp->file) != 4) return 0;
+        uint32_t column = getU32(u);
+        if (column < 1 || column >= (uint32_t)rp->nColumns) return 0;
+        if (!readString(rp->file, name)) return 0;
+        rp->columns.push_back((int)column);
+        rp->names.push_back(name);
+    }
+    return 1;
+}
+
+// read the index, written after the pages, which end at signalsEnd or later
+static int readIndex(ResultPyramid *rp, uint64_t signalsEnd) {
+    unsigned char trailer[TRAILER_SIZE];
+    uint64_t size, indexOffset;
+    if (seekFile(rp->file, 0, SEEK_END)) return 0;
+    size = tellFile(rp->file);
+    if (size < signalsEnd + TRAILER_SIZE || seekFile(rp->file, size - TRAILER_SIZE, SEEK_SET)
+            || fread(trailer, 1, TRAILER_SIZE, rp->file) != TRAILER_SIZE) return 0;
+    indexOffset = getU64(trailer);
+    rp->rows = getU64(trailer + 8);
+    if (indexOffset < signalsEnd || indexOffset > size - TRAILER_SIZE) return 0;
+    std::vector<unsigned char> index((size_t)(size - TRAILER_SIZE - indexOffset));
+    if (index.size() < 4 || seekFile(rp->file, indexOffset, SEEK_SET)
+            || fread(&index[0], 1, index.size(), rp->file) != index.size()) return 0;
+    const unsigned char *p = &index[0], *end = p + index.size();
+    uint32_t nLevels = getU32(p);
+    p += 4;
+    if (nLevels < 1 || nLevels > MAX_LEVELS) return 0;
+    uint64_t pageSize = (uint64_t)rp->nColumns * BIN_VALUES * 8;
+    rp->levels.resize(nLevels);
+    for (uint32_t l = 0; l < nLevels; l++) {
+        ReaderLevel &level = rp->levels[l];
+        uint64_t bins = 0;
+        if (end - p < 12) return 0;
+        level.bins = getU64(p);
+        uint32_t nPages = getU32(p + 8);
+        p += 12;
+        if ((uint64_t)(end - p) / PAGE_INDEX_SIZE < nPages) return 0;
+        level.pages.resize(nPages);
+        for (uint32_t i = 0; i < nPages; i++) {
+            PyramidPage &page = level.pages[i];
+            page.offset = getU64(p);
+            page.bins = getU32(p + 8);
+            page.firstBin = bins;
+            page.firstTime = getF64(p + 12);
+            page.lastTime = getF64(p + 20);
+            p += PAGE_INDEX_SIZE;
+            if (page.offset < signalsEnd || !page.bins || page.offset + page.bins * pageSize > indexOffset) return 0;
+            bins += page.bins;
+        }
+        if (bins != level.bins) return 0;
+    }
+    return 1;
+}
+
+ResultPyramid *openResultPyramid(const char *path) {
+    ResultPyramid *rp = NULL;
+    try {
+        unsigned char header[HEADER_SIZE];
+        FILE *file = fopen(path, "rb");
+        if (!file) return NULL;
+        rp = new ResultPyramid();
+        rp->file = file;
+        if (fread(header, 1, HEADER_SIZE, file) != HEADER_SIZE || memcmp(header, PYRAMID_MAGIC, 4)
+                || getU32(header + 4) != PYRAMID_VERSION) {
+            closeResultPyramid(rp);
+            return NULL;
+        }
+        rp->nColumns = 1 + (int)getU32(header + 8) + (int)getU32(header + 12) + (int)getU32(header + 16);
+        rp->binShift = getU32(header + 20);
+        rp->levelShift = getU32(header + 24);
+        if (!readSignals(rp, getU32(header + 28)) || !readIndex(rp, tellFile(file))
+                || rp->binShift + (uint64_t)rp->levelShift * (rp->levels.size() - 1) > 62) {
+            closeResultPyramid(rp);
+            return NULL;
+        }
+    } catch (const std::bad_alloc &) {
+        closeResultPyramid(rp);
+        return NULL;
+    }
+    return rp;
+}
+
+void closeResultPyramid(ResultPyramid *rp) {
+    if (!rp) return;
+    fclose(rp->file);
+    delete rp;
+}
+
+int getPyramidSignalCount(ResultPyramid *rp) {
+    return (int)rp->names.size();
+}
+
+const char *getPyramidSignalName(ResultPyramid *rp, int signal) {
+    return rp->names[signal].c_str();
+}
+
+int findPyramidSignal(ResultPyramid *rp, const char *name) {
+    for (size_t i = 0; i < rp->names.size(); i++) {
+        if (rp->names[i] == name) return (int)i;
+    }
+    return -1;
+}
+
+size_t getPyramidRowCount(ResultPyramid *rp) {
+    return (size_t)rp->rows;
+}
+
+int getPyramidLevelCount(ResultPyramid *rp) {
+    return (int)rp->levels.size();
+}
+
+int getPyramidTimeRange(ResultPyramid *rp, double *start, double *end) {
+    const std::vector<PyramidPage> &pages = rp->levels[0].pages;
+    if (pages.empty()) return 0;
+    *start = pages.front().firstTime;
+    *end = pages.back().lastTime;
+    return 1;
+}
+
+// estimate of the bins of level in start to end, assuming steps of equal length
+static double countBins(const ReaderLevel &level, double start, double end) {
+    double bins = 0;
+    for (size_t i = 0; i < level.pages.size(); i++) {
+        const PyramidPage &page = level.pages[i];
+        if (page.lastTime < start || page.firstTime > end) continue;
+        double length = page.lastTime - page.firstTime;
+        double overlap = (page.lastTime < end ? page.lastTime : end) - (page.firstTime > start ? page.firstTime : start);
+        bins += length > 0 ? page.bins * overlap / length : page.bins;
+    }
+    return bins;
+}
+
+// read the bins of column in page into values
+static int readBins(ResultPyramid *rp, const PyramidPage &page, int column, std::vector<double> &values) {
+    size_t n = (size_t)page.bins * BIN_VALUES;
+    rp->block.resize(n * 8);
+    if (seekFile(rp->file, page.offset + (uint64_t)column * n * 8, SEEK_SET)
+            || fread(&rp->block[0], 1, rp->block.size(), rp->file) != rp->block.size()) return 0;
+    values.resize(n);
+    for (size_t i = 0; i < n; i++) values[i] = getF64(&rp->block[i * 8]);
+    return 1;
+}
+
+// the pixel of time, which is in start to end
+static int pixelOf(double time, double start, double width, int nPixels) {
+    int pixel = width > 0 ? (int)((time - start) / width) : 0;
+    return pixel < nPixels ? pixel : nPixels - 1;
+}
+
+int readPyramidEnvelope(ResultPyramid *rp, int signal, double start, double end, int nPixels,
+                        double *min, double *max, double *mean) {
+    size_t level = 0;
+    if (signal < 0 || signal >= (int)rp->names.size() || nPixels < 1 || !(end >= start)) return 0;
+    int column = rp->columns[signal];
+    double width = (end - start) / nPixels;
+    try {
+        // per pixel, sum of the means of the bins weighted by their rows, and the rows
+        std::vector<double> sums(nPixels), weights(nPixels);
+        for (int i = 0; i < nPixels; i++) {
+            min[i] = HUGE_VAL;
+            max[i] = -HUGE_VAL;
+        }
+        for (size_t l = rp->levels.size(); l-- > 1;) {
+            if (countBins(rp->levels[l], start, end) >= 2.0 * nPixels) {
+                level = l;
+                break;
+            }
+        }
+        const ReaderLevel &bins = rp->levels[level];
+        uint64_t rows = (uint64_t)1 << (rp->binShift + rp->levelShift * level);
+        for (size_t i = 0; i < bins.pages.size(); i++) {
+            const PyramidPage &page = bins.pages[i];
+            if (page.lastTime < start || page.firstTime > end) continue;
+            if (!readBins(rp, page, 0, rp->times) || !readBins(rp, page, column, rp->values)) return 0;
+            for (uint32_t b = 0; b < page.bins; b++) {
+                const double *t = &rp->times[b * BIN_VALUES];
+                const double *v = &rp->values[b * BIN_VALUES];
+                if (t[1] < start || t[0] > end) continue;
+                // all bins but the last are full
+                uint64_t index = page.firstBin + b;
+                double weight = (double)(index + 1 < bins.bins ? rows : rp->rows - index * rows);
+                // the time of the bin in start to end, and the pixels it overlaps
+                double first = t[0] > start ? t[0] : start;
+                double last = t[1] < end ? t[1] : end;
+                int firstPixel = pixelOf(first, start, width, nPixels);
+                int lastPixel = pixelOf(last, start, width, nPixels);
+                for (int pixel = firstPixel; pixel <= lastPixel; pixel++) {
+                    double from = pixel == firstPixel ? first : start + pixel * width;
+                    double to = pixel == lastPixel ? last : start + (pixel + 1) * width;
+                    if (v[0] < min[pixel]) min[pixel] = v[0];
+                    if (v[1] > max[pixel]) max[pixel] = v[1];
+                    if (v[2] == v[2]) {
+                        // the rows of the bin are split among its pixels by overlap, a
+                        // pixel overlapped at one time only, e.g. the last row, gets one
+                        double share = last > first ? weight * (to - from) / (last - first) : weight;
+                        if (!(share > 0)) share = 1;
+                        sums[pixel] += v[2] * share;
+                        weights[pixel] += share;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < nPixels; i++) {
+            if (min[i] > max[i]) min[i] = max[i] = NAN;
+            mean[i] = weights[i] > 0 ? sums[i] / weights[i] : NAN;
+        }
+    } catch (const std::bad_alloc &) {
+        return 0;
+    }
+    return 1;
+}
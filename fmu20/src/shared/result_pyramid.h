@@ -0,0 +1,88 @@
+/* -------------------------------------------------------------------------
+ * result_pyramid.h
+ * Multi-resolution summary of a result (.fmp), written next to the result
+ * file, so that a viewer plots long runs without reading all rows. Each
+ * level holds the min, max and mean of every signal per bin of rows: level
+ * 0 per 64 rows, each level above per 4 bins of the level below. A reader
+ * gets the envelope of a signal at a given resolution in time from the
+ * coarsest level that is fine enough, reading about as many bins as pixels,
+ * whatever the length of the run. NaN values are left out of min, max and
+ * mean. Strings are not stored.
+ *
+ * All numbers are little endian. The file is
+ *   header:  "FMRP", u32 version 1, u32 nReals, u32 nIntegers, u32 nBooleans,
+ *            u32 log2 of the rows per bin of level 0, u32 log2 of the bins
+ *            per bin of the level above, u32 nSignals, per signal:
+ *            u32 column, u32 length and name
+ *   pages:   per column a block of per bin: f64 min, f64 max, f64 mean
+ *   index:   u32 nLevels, per level: u64 bins, u32 nPages, per page:
+ *            u64 offset, u32 bins, f64 time of its first row, f64 time of
+ *            its last row
+ *   trailer: u64 offset of the index, u64 rows
+ * Columns are numbered as in result_store.h: 0 is time, followed by the
+ * Real, Integer and Boolean values. Each level is written in pages of bins
+ * while the simulation runs, the index when the writer is closed. All bins
+ * but the last of each level are full.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#ifndef RESULT_PYRAMID_H
+#define RESULT_PYRAMID_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct PyramidWriter PyramidWriter;
+
+// Returns NULL if out of memory. file must be opened in binary mode.
+// The receiver must call closePyramidWriter() to write the index and free the writer.
+PyramidWriter *openPyramidWriter(FILE *file, int nReals, int nIntegers, int nBooleans);
+
+// Adds a signal stored in the given column, before the first row is appended.
+// Returns 0 if out of memory.
+int addPyramidSignal(PyramidWriter *w, const char *name, int column);
+
+// Adds a row to the bins of all levels.
+// Returns 0 if out of memory or writing the file failed.
+int appendPyramidRow(PyramidWriter *w, double time, const double *reals, const int *integers, const int *booleans);
+
+// Writes the last bins and the index and frees w.
+// Returns 0 if writing the file failed, e.g. because the disk is full.
+int closePyramidWriter(PyramidWriter *w);
+
+typedef struct ResultPyramid ResultPyramid;
+
+// Returns NULL if path cannot be read or is not a complete pyramid.
+ResultPyramid *openResultPyramid(const char *path);
+void closeResultPyramid(ResultPyramid *rp);
+
+int getPyramidSignalCount(ResultPyramid *rp);
+const char *getPyramidSignalName(ResultPyramid *rp, int signal);
+// -1 if not found
+int findPyramidSignal(ResultPyramid *rp, const char *name);
+size_t getPyramidRowCount(ResultPyramid *rp);
+int getPyramidLevelCount(ResultPyramid *rp);
+
+// Sets the time of the first and the last row. Returns 0 if there is no row.
+int getPyramidTimeRange(ResultPyramid *rp, double *start, double *end);
+
+// Divides start to end into nPixels intervals of equal length and sets min, max
+// and mean of the values of the signal in each, or NaN for intervals without
+// values. A bin counts to each interval that the time from its first to its
+// last row overlaps, its rows split among them by overlap for the mean, so the
+// envelope is that of the rows if each interval holds many bins, and that of
+// the bins around it if an interval is shorter than a bin. The bins are read
+// from the coarsest level with at least 2 bins per interval, or from level 0.
+// Returns 0 if the arguments are not valid or the file cannot be read.
+int readPyramidEnvelope(ResultPyramid *rp, int signal, double start, double end, int nPixels,
+                        double *min, double *max, double *mean);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RESULT_PYRAMID_H
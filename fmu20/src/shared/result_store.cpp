@@ -0,0 +1,752 @@
+/* -------------------------------------------------------------------------
+ * result_store.cpp
+ * Writer and reader of the compressed columnar result file, see
+ * result_store.h. The writer encodes each value as it is appended, so
+ * that it holds one group of rows in compressed form only. Groups have
+ * as many rows as fit into GROUP_VALUES values of the columns that are
+ * not constant, e.g. 83 rows of a model with 50000 such columns, within
+ * MIN_GROUP_ROWS and MAX_GROUP_ROWS.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include "result_store.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+
+#define STORE_MAGIC "FMRS"
+#define STORE_VERSION 1
+#define HEADER_SIZE 24        // magic to nSignals
+#define GROUP_HEADER_SIZE 20  // rows, start and end time
+#define BLOCK_HEADER_SIZE 16  // min and max
+#define GROUP_VALUES (1 << 22)
+#define MIN_GROUP_ROWS 64
+#define MAX_GROUP_ROWS 8192
+
+static void putU32(std::vector<unsigned char> &out, uint32_t u) {
+    for (int i = 0; i < 4; i++) out.push_back((unsigned char)(u >> (8 * i)));
+}
+
+static void putF64(std::vector<unsigned char> &out, double d) {
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    for (int i = 0; i < 8; i++) out.push_back((unsigned char)(u >> (8 * i)));
+}
+
+static void putString(std::vector<unsigned char> &out, const char *s) {
+    size_t n = s ? strlen(s) : 0;
+    putU32(out, (uint32_t)n);
+    out.insert(out.end(), (const unsigned char *)s, (const unsigned char *)s + n);
+}
+
+static void putVarint(std::vector<unsigned char> &out, uint32_t u) {
+    while (u >= 0x80) {
+        out.push_back((unsigned char)(u | 0x80));
+        u >>= 7;
+    }
+    out.push_back((unsigned char)u);
+}
+
+static uint32_t getU32(const unsigned char *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static double getF64(const unsigned char *p) {
+    uint64_t u = 0;
+    double d;
+    for (int i = 7; i >= 0; i--) u = u << 8 | p[i];
+    memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+static int leadingZeros(uint64_t x) {
+#if defined(__GNUC__)
+    return x ? __builtin_clzll(x) : 64;
+#else
+    int n = 0;
+    if (!x) return 64;
+    while (!(x >> 63)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static int trailingZeros(uint64_t x) {
+#if defined(__GNUC__)
+    return x ? __builtin_ctzll(x) : 64;
+#else
+    int n = 0;
+    if (!x) return 64;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// type of the values of a column
+static int columnType(int column, int nReals, int nIntegers) {
+    if (column <= nReals) return STORE_REAL; // incl. time
+    return column <= nReals + nIntegers ? STORE_INTEGER : STORE_BOOLEAN;
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+// The block of a column in the group being appended to
+struct ColumnBlock {
+    std::vector<unsigned char> bytes;
+    int freeBits;        // unused low bits of the last byte
+    uint32_t count;      // values appended
+    double min;
+    double max;
+    // XOR encoding of Real values
+    uint64_t previous;   // bits of the value before
+    int leading;         // leading zeros of the meaningful bits of the XOR before
+    int trailing;        // trailing zeros of the meaningful bits of the XOR before, -1 if none
+    // run-length encoding of Integer and Boolean values
+    int value;
+    uint32_t run;
+    // discrete columns only
+    std::vector<unsigned char> changes;  // varint rows since the change before, per change
+    uint32_t changeRow;  // row of the change appended last
+};
+
+struct StoreWriter {
+    FILE *file;
+    int nReals;
+    int nIntegers;
+    int nBooleans;
+    uint32_t nSignals;
+    std::vector<unsigned char> signals;  // encoded signals, until the header is written
+    bool started;                        // true once the header is written
+    bool failed;
+    uint32_t groupRows;                  // rows per group
+    uint32_t rows;                       // rows in the group being appended to
+    double startTime;
+    double endTime;
+    std::vector<ColumnBlock> blocks;     // per column
+    std::vector<signed char> kinds;      // per column
+    std::vector<unsigned char> out;
+};
+
+static void resetBlock(ColumnBlock &b) {
+    b.bytes.clear();
+    b.freeBits = 0;
+    b.count = 0;
+    b.min = HUGE_VAL;
+    b.max = -HUGE_VAL;
+    b.previous = 0;
+    b.trailing = -1;
+    b.value = 0;
+    b.run = 0;
+    b.changes.clear();
+    b.changeRow = 0;
+}
+
+// append the n low bits of value, the highest first
+static void putBits(ColumnBlock &b, uint64_t value, int n) {
+    while (n > 0) {
+        if (!b.freeBits) {
+            b.bytes.push_back(0);
+            b.freeBits = 8;
+        }
+        int k = n < b.freeBits ? n : b.freeBits;
+        unsigned int bits = (unsigned int)(value >> (n - k)) & ((1u << k) - 1);
+        b.bytes.back() |= (unsigned char)(bits << (b.freeBits - k));
+        b.freeBits -= k;
+        n -= k;
+    }
+}
+
+// The first value is stored in full. Each further value is stored as XOR with
+// the value before: '0' if equal, '10' and the meaningful bits if these lie
+// within those of the XOR before, otherwise '11', 5 bits of leading zeros,
+// 6 bits of the number of meaningful bits (0 for 64) and the meaningful bits.
+static void encodeReal(ColumnBlock &b, double d) {
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    if (b.count++ == 0) {
+        putBits(b, v, 64);
+    } else {
+        uint64_t x = v ^ b.previous;
+        if (!x) {
+            putBits(b, 0, 1);
+        } else {
+            int leading = leadingZeros(x);
+            int trailing = trailingZeros(x);
+            if (leading > 31) leading = 31;
+            if (b.trailing >= 0 && leading >= b.leading && trailing >= b.trailing) {
+                putBits(b, 2, 2);
+                putBits(b, x >> b.trailing, 64 - b.leading - b.trailing);
+            } else {
+                int length = 64 - leading - trailing;
+                putBits(b, 3, 2);
+                putBits(b, (uint64_t)leading, 5);
+                putBits(b, (uint64_t)(length & 63), 6);
+                putBits(b, x >> trailing, length);
+                b.leading = leading;
+                b.trailing = trailing;
+            }
+        }
+    }
+    b.previous = v;
+    if (d < b.min) b.min = d; // NaN is neither
+    if (d > b.max) b.max = d;
+}
+
+// the value as zig-zag varint, then the length of its run as varint
+static void flushRun(ColumnBlock &b) {
+    if (!b.run) return;
+    putVarint(b.bytes, (uint32_t)b.value << 1 ^ (uint32_t)(b.value >> 31));
+    putVarint(b.bytes, b.run);
+    b.run = 0;
+}
+
+static void encodeInt(ColumnBlock &b, int i) {
+    if (b.run && i == b.value) {
+        b.run++;
+    } else {
+        flushRun(b);
+        b.value = i;
+        b.run = 1;
+    }
+    b.count++;
+    if (i < b.min) b.min = i;
+    if (i > b.max) b.max = i;
+}
+
+static void writeBytes(StoreWriter *w, const std::vector<unsigned char> &bytes) {
+    if (!bytes.empty() && fwrite(&bytes[0], 1, bytes.size(), w->file) != bytes.size()) w->failed = true;
+}
+
+// Writes the header with the values of the constant columns, NULL if there is no row
+static void writeHeader(StoreWriter *w, const double *reals, const int *integers, const int *booleans) {
+    size_t stored = 0;
+    size_t rows;
+    w->out.resize(4);
+    memcpy(&w->out[0], STORE_MAGIC, 4);
+    putU32(w->out, STORE_VERSION);
+    putU32(w->out, (uint32_t)w->nReals);
+    putU32(w->out, (uint32_t)w->nIntegers);
+    putU32(w->out, (uint32_t)w->nBooleans);
+    putU32(w->out, w->nSignals);
+    writeBytes(w, w->out);
+    writeBytes(w, w->signals);
+    std::vector<unsigned char>().swap(w->signals);
+    w->out.clear();
+    w->out.insert(w->out.end(), w->kinds.begin(), w->kinds.end());
+    for (size_t c = 1; c < w->kinds.size(); c++) {
+        if (w->kinds[c] != STORE_CONSTANT) {
+            stored++;
+        } else if (!reals) {
+            putF64(w->out, 0);
+        } else {
+            int i = (int)c - 1;
+            switch (columnType((int)c, w->nReals, w->nIntegers)) {
+                case STORE_REAL:    putF64(w->out, reals[i]); break;
+                case STORE_INTEGER: putF64(w->out, integers[i - w->nReals]); break;
+                default:            putF64(w->out, booleans[i - w->nReals - w->nIntegers] ? 1 : 0); break;
+            }
+        }
+    }
+    writeBytes(w, w->out);
+    rows = GROUP_VALUES / (1 + stored); // incl. time
+    w->groupRows = (uint32_t)(rows < MIN_GROUP_ROWS ? MIN_GROUP_ROWS : rows > MAX_GROUP_ROWS ? MAX_GROUP_ROWS : rows);
+    w->started = true;
+}
+
+static void writeGroup(StoreWriter *w) {
+    uint32_t end = 0;
+    if (!w->started) writeHeader(w, NULL, NULL, NULL);
+    if (!w->rows) return;
+    w->out.clear();
+    putU32(w->out, w->rows);
+    putF64(w->out, w->startTime);
+    putF64(w->out, w->endTime);
+    for (size_t c = 0; c < w->blocks.size(); c++) {
+        ColumnBlock &b = w->blocks[c];
+        if (w->kinds[c] == STORE_CONSTANT) continue;
+        if (columnType((int)c, w->nReals, w->nIntegers) != STORE_REAL) flushRun(b);
+        if (w->kinds[c] == STORE_DISCRETE) {
+            // the number of changes goes in front of them
+            size_t n = b.changes.size();
+            putVarint(b.changes, b.count);
+            std::rotate(b.changes.begin(), b.changes.begin() + n, b.changes.end());
+        }
+        end += BLOCK_HEADER_SIZE + (uint32_t)(b.changes.size() + b.bytes.size());
+        putU32(w->out, end);
+    }
+    writeBytes(w, w->out);
+    for (size_t c = 0; c < w->blocks.size(); c++) {
+        ColumnBlock &b = w->blocks[c];
+        if (w->kinds[c] == STORE_CONSTANT) continue;
+        w->out.clear();
+        putF64(w->out, b.min);
+        putF64(w->out, b.max);
+        writeBytes(w, w->out);
+        writeBytes(w, b.changes);
+        writeBytes(w, b.bytes);
+        resetBlock(b);
+    }
+    w->rows = 0;
+}
+
+// true unless the value of the discrete column c is the same as in the row before
+static bool isChange(StoreWriter *w, int c, bool changed) {
+    ColumnBlock &b = w->blocks[c];
+    if (w->kinds[c] != STORE_DISCRETE) return true;
+    if (b.count && !changed) return false; // the first row of a group is a change
+    putVarint(b.changes, w->rows - b.changeRow);
+    b.changeRow = w->rows;
+    return true;
+}
+
+static void appendReal(StoreWriter *w, int c, double d) {
+    uint64_t v;
+    if (w->kinds[c] == STORE_CONSTANT) return;
+    memcpy(&v, &d, sizeof(v));
+    if (isChange(w, c, v != w->blocks[c].previous)) encodeReal(w->blocks[c], d);
+}
+
+static void appendInt(StoreWriter *w, int c, int i) {
+    if (w->kinds[c] == STORE_CONSTANT) return;
+    if (isChange(w, c, i != w->blocks[c].value)) encodeInt(w->blocks[c], i);
+}
+
+StoreWriter *openStoreWriter(FILE *file, int nReals, int nIntegers, int nBooleans) {
+    StoreWriter *w = NULL;
+    try {
+        size_t nColumns = 1 + (size_t)nReals + nIntegers + nBooleans;
+        w = new StoreWriter();
+        w->file = file;
+        w->nReals = nReals;
+        w->nIntegers = nIntegers;
+        w->nBooleans = nBooleans;
+        w->nSignals = 0;
+        w->started = false;
+        w->failed = false;
+        w->groupRows = MAX_GROUP_ROWS; // set with the header
+        w->rows = 0;
+        w->startTime = 0;
+        w->endTime = 0;
+        w->blocks.resize(nColumns);
+        for (size_t c = 0; c < nColumns; c++) resetBlock(w->blocks[c]);
+        // time, and columns without a signal, are continuous
+        w->kinds.resize(nColumns, STORE_CONTINUOUS);
+        for (size_t c = 1; c < nColumns; c++) w->kinds[c] = -1;
+    } catch (const std::bad_alloc &) {
+        delete w;
+        return NULL;
+    }
+    return w;
+}
+
+int addStoreSignal(StoreWriter *w, const char *name, const char *description, int column, int kind) {
+    if (kind > w->kinds[column]) w->kinds[column] = (signed char)kind;
+    try {
+        putU32(w->signals, (uint32_t)column);
+        putString(w->signals, name);
+        putString(w->signals, description);
+        w->nSignals++;
+    } catch (const std::bad_alloc &) {
+        return 0;
+    }
+    return 1;
+}
+
+int appendStoreRow(StoreWriter *w, double time, const double *reals, const int *integers, const int *booleans) {
+    int c = 0;
+    try {
+        if (!w->started) {
+            // columns without a signal are not read, store them as constants
+            for (size_t k = 1; k < w->kinds.size(); k++) {
+                if (w->kinds[k] < 0) w->kinds[k] = STORE_CONSTANT;
+            }
+            writeHeader(w, reals, integers, booleans);
+        }
+        if (!w->rows) w->startTime = time;
+        w->endTime = time;
+        appendReal(w, c++, time);
+        for (int i = 0; i < w->nReals; i++) appendReal(w, c++, reals[i]);
+        for (int i = 0; i < w->nIntegers; i++) appendInt(w, c++, integers[i]);
+        for (int i = 0; i < w->nBooleans; i++) appendInt(w, c++, booleans[i] ? 1 : 0);
+        if (++w->rows == w->groupRows) writeGroup(w);
+    } catch (const std::bad_alloc &) {
+        w->failed = true;
+    }
+    return !w->failed;
+}
+
+int closeStoreWriter(StoreWriter *w) {
+    int ok;
+    try {
+        writeGroup(w);
+    } catch (const std::bad_alloc &) {
+        w->failed = true;
+    }
+    ok = !w->failed;
+    delete w;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+struct StoreGroup {
+    uint64_t offset;     // of the group header in the file
+    uint32_t rows;
+    size_t firstRow;
+};
+
+struct ResultStore {
+    FILE *file;
+    int nReals;
+    int nIntegers;
+    int nColumns;
+    int nStored;                         // columns that are not constant
+    std::vector<std::string> names;
+    std::vector<std::string> descriptions;
+    std::vector<int> columns;            // per signal
+    std::vector<int> kinds;              // per column
+    std::vector<int> stored;             // per column, index of its block, -1 if constant
+    std::vector<double> constants;       // per column, the value if constant
+    std::vector<StoreGroup> groups;
+    size_t rows;
+    std::vector<unsigned char> block;    // the block read last
+    std::vector<double> values;          // the values decoded last
+    std::vector<double> changes;         // the changes of a discrete column decoded last
+};
+
+// Offsets are 64 bit, results of long runs exceed the 2 GB of fseek
+static int seekFile(FILE *file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static int readAt(ResultStore *rs, uint64_t offset, void *buffer, size_t n) {
+    return !seekFile(rs->file, offset) && fread(buffer, 1, n, rs->file) == n;
+}
+
+static uint64_t getFileSize(FILE *file) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END)) return 0;
+    return (uint64_t)_ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END)) return 0;
+    return (uint64_t)ftello(file);
+#endif
+}
+
+static int readString(FILE *file, std::string &s) {
+    unsigned char u[4];
+    if (fread(u, 1, 4, file) != 4) return 0;
+    s.resize(getU32(u));
+    return s.empty() || fread(&s[0], 1, s.size(), file) == s.size();
+}
+
+static int readSignals(ResultStore *rs, uint32_t nSignals) {
+    unsigned char u[4];
+    for (uint32_t i = 0; i < nSignals; i++) {
+        std::string name, description;
+        if (fread(u, 1, 4, rs->file) != 4) return 0;
+        uint32_t column = getU32(u);
+        if (column < 1 || column >= (uint32_t)rs->nColumns) return 0;
+        if (!readString(rs->file, name) || !readString(rs->file, description)) return 0;
+        rs->columns.push_back((int)column);
+        rs->names.push_back(name);
+        rs->descriptions.push_back(description);
+    }
+    return 1;
+}
+
+static int readKinds(ResultStore *rs) {
+    std::vector<unsigned char> kinds(rs->nColumns);
+    unsigned char d[8];
+    if (fread(&kinds[0], 1, kinds.size(), rs->file) != kinds.size()) return 0;
+    rs->nStored = 0;
+    for (int c = 0; c < rs->nColumns; c++) {
+        int kind = kinds[c];
+        if (kind > STORE_CONTINUOUS || (c == 0 && kind != STORE_CONTINUOUS)) return 0;
+        rs->kinds.push_back(kind);
+        rs->stored.push_back(kind == STORE_CONSTANT ? -1 : rs->nStored++);
+        if (kind == STORE_CONSTANT && fread(d, 1, 8, rs->file) != 8) return 0;
+        rs->constants.push_back(kind == STORE_CONSTANT ? getF64(d) : 0);
+    }
+    return 1;
+}
+
+// find the complete groups from offset on
+static void findGroups(ResultStore *rs, uint64_t offset) {
+    uint64_t size = getFileSize(rs->file);
+    uint64_t headerSize = GROUP_HEADER_SIZE + 4 * (uint64_t)rs->nStored;
+    unsigned char header[GROUP_HEADER_SIZE];
+    unsigned char u[4];
+    rs->rows = 0;
+    while (offset + headerSize <= size) {
+        if (!readAt(rs, offset, header, GROUP_HEADER_SIZE)
+                || !readAt(rs, offset + headerSize - 4, u, 4)) break;
+        StoreGroup g;
+        g.offset = offset;
+        g.rows = getU32(header);
+        g.firstRow = rs->rows;
+        uint64_t end = offset + headerSize + getU32(u);
+        if (!g.rows || end > size) break; // cut off
+        rs->groups.push_back(g);
+        rs->rows += g.rows;
+        offset = end;
+    }
+}
+
+ResultStore *openResultStore(const char *path) {
+    ResultStore *rs = NULL;
+    try {
+        unsigned char header[HEADER_SIZE];
+        FILE *file = fopen(path, "rb");
+        if (!file) return NULL;
+        rs = new ResultStore();
+        rs->file = file;
+        if (fread(header, 1, HEADER_SIZE, file) != HEADER_SIZE || memcmp(header, STORE_MAGIC, 4)
+                || getU32(header + 4) != STORE_VERSION) {
+            closeResultStore(rs);
+            return NULL;
+        }
+        rs->nReals = (int)getU32(header + 8);
+        rs->nIntegers = (int)getU32(header + 12);
+        rs->nColumns = 1 + rs->nReals + rs->nIntegers + (int)getU32(header + 16);
+        if (!readSignals(rs, getU32(header + 20)) || !readKinds(rs)) {
+            closeResultStore(rs);
+            return NULL;
+        }
+        long headerEnd = ftell(file);
+        findGroups(rs, (uint64_t)headerEnd);
+    } catch (const std::bad_alloc &) {
+        closeResultStore(rs);
+        return NULL;
+    }
+    return rs;
+}
+
+void closeResultStore(ResultStore *rs) {
+    if (!rs) return;
+    fclose(rs->file);
+    delete rs;
+}
+
+int getStoreSignalCount(ResultStore *rs) {
+    return (int)rs->names.size();
+}
+
+const char *getStoreSignalName(ResultStore *rs, int signal) {
+    return rs->names[signal].c_str();
+}
+
+const char *getStoreSignalDescription(ResultStore *rs, int signal) {
+    return rs->descriptions[signal].c_str();
+}
+
+int getStoreSignalType(ResultStore *rs, int signal) {
+    return columnType(rs->columns[signal], rs->nReals, rs->nIntegers);
+}
+
+int getStoreSignalKind(ResultStore *rs, int signal) {
+    return rs->kinds[rs->columns[signal]];
+}
+
+int findStoreSignal(ResultStore *rs, const char *name) {
+    for (size_t i = 0; i < rs->names.size(); i++) {
+        if (rs->names[i] == name) return (int)i;
+    }
+    return -1;
+}
+
+size_t getStoreRowCount(ResultStore *rs) {
+    return rs->rows;
+}
+
+// read the block of column, which is not constant, in group g into rs->block, incl. its header
+static int readBlock(ResultStore *rs, const StoreGroup &g, int column, int withValues) {
+    unsigned char u[8];
+    uint64_t ends = g.offset + GROUP_HEADER_SIZE;
+    uint64_t blocks = ends + 4 * (uint64_t)rs->nStored;
+    uint32_t start = 0, end;
+    int index = rs->stored[column];
+    if (index > 0) {
+        // the end of the block before is its start
+        if (!readAt(rs, ends + 4 * (uint64_t)(index - 1), u, 8)) return 0;
+        start = getU32(u);
+        end = getU32(u + 4);
+    } else {
+        if (!readAt(rs, ends, u, 4)) return 0;
+        end = getU32(u);
+    }
+    if (end < start || end - start < BLOCK_HEADER_SIZE) return 0;
+    rs->block.resize(withValues ? end - start : BLOCK_HEADER_SIZE);
+    return readAt(rs, blocks + start, &rs->block[0], rs->block.size());
+}
+
+struct BitReader {
+    const unsigned char *p;
+    const unsigned char *end;
+    int used;            // bits of *p read
+    bool failed;         // true if read past end
+};
+
+static uint64_t getBits(BitReader &r, int n) {
+    uint64_t value = 0;
+    while (n > 0) {
+        if (r.p == r.end) {
+            r.failed = true;
+            return 0;
+        }
+        int available = 8 - r.used;
+        int k = n < available ? n : available;
+        value = value << k | ((*r.p >> (available - k)) & ((1u << k) - 1));
+        r.used += k;
+        n -= k;
+        if (r.used == 8) {
+            r.p++;
+            r.used = 0;
+        }
+    }
+    return value;
+}
+
+static int decodeReals(const unsigned char *bytes, size_t size, uint32_t n, double *values) {
+    BitReader r = { bytes, bytes + size, 0, false };
+    uint64_t v = getBits(r, 64);
+    int leading = 0, trailing = 0;
+    memcpy(&values[0], &v, sizeof(v));
+    for (uint32_t i = 1; i < n && !r.failed; i++) {
+        if (getBits(r, 1)) {
+            if (getBits(r, 1)) {
+                int length;
+                leading = (int)getBits(r, 5);
+                length = (int)getBits(r, 6);
+                if (!length) length = 64;
+                if (leading + length > 64) return 0;
+                trailing = 64 - leading - length;
+            }
+            v ^= getBits(r, 64 - leading - trailing) << trailing;
+        }
+        memcpy(&values[i], &v, sizeof(v));
+    }
+    return !r.failed;
+}
+
+static int getVarint(const unsigned char **p, const unsigned char *end, uint32_t *u) {
+    *u = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*p == end) return 0;
+        unsigned char b = *(*p)++;
+        *u |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return 1;
+    }
+    return 0;
+}
+
+static int decodeRuns(const unsigned char *bytes, size_t size, uint32_t n, double *values) {
+    const unsigned char *p = bytes, *end = bytes + size;
+    uint32_t i = 0;
+    while (i < n) {
+        uint32_t zigzag, run;
+        if (!getVarint(&p, end, &zigzag) || !getVarint(&p, end, &run) || !run || run > n - i) return 0;
+        int value = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+        while (run--) values[i++] = value;
+    }
+    return 1;
+}
+
+// decode the values of rs->block of a column of the given type and kind
+// into the g.rows values of rs->values
+static int decodeBlock(ResultStore *rs, const StoreGroup &g, int type, int kind) {
+    const unsigned char *bytes = &rs->block[BLOCK_HEADER_SIZE];
+    const unsigned char *end = bytes + rs->block.size() - BLOCK_HEADER_SIZE;
+    uint32_t nChanges = g.rows;
+    double *values;
+    rs->values.resize(g.rows);
+    values = &rs->values[0];
+    if (kind == STORE_DISCRETE) {
+        // the rows of the changes are read after their values are decoded
+        const unsigned char *rows = bytes;
+        uint32_t delta;
+        if (!getVarint(&bytes, end, &nChanges) || nChanges < 1 || nChanges > g.rows) return 0;
+        for (uint32_t i = 0; i < nChanges; i++) {
+            if (!getVarint(&bytes, end, &delta)) return 0;
+        }
+        rs->changes.resize(nChanges);
+        values = &rs->changes[0];
+        if (!(type == STORE_REAL ? decodeReals(bytes, end - bytes, nChanges, values)
+                                 : decodeRuns(bytes, end - bytes, nChanges, values))) return 0;
+        getVarint(&rows, end, &nChanges);
+        uint32_t row = 0;  // of the change before
+        for (uint32_t i = 0; i < nChanges; i++) {
+            getVarint(&rows, end, &delta);
+            if ((i == 0) != (delta == 0) || delta >= g.rows - row) return 0;
+            // a value holds until the next change
+            for (uint32_t k = row; k < row + delta; k++) rs->values[k] = values[i - 1];
+            row += delta;
+        }
+        for (uint32_t k = row; k < g.rows; k++) rs->values[k] = values[nChanges - 1];
+        return 1;
+    }
+    return type == STORE_REAL ? decodeReals(bytes, end - bytes, g.rows, values)
+                              : decodeRuns(bytes, end - bytes, g.rows, values);
+}
+
+int getStoreSignalRange(ResultStore *rs, int signal, double *min, double *max) {
+    int column = signal == STORE_TIME ? 0 : rs->columns[signal];
+    if (rs->kinds[column] == STORE_CONSTANT) {
+        *min = *max = rs->constants[column];
+        return 1;
+    }
+    *min = HUGE_VAL;
+    *max = -HUGE_VAL;
+    for (size_t i = 0; i < rs->groups.size(); i++) {
+        if (!readBlock(rs, rs->groups[i], column, 0)) return 0;
+        double blockMin = getF64(&rs->block[0]);
+        double blockMax = getF64(&rs->block[8]);
+        if (blockMin < *min) *min = blockMin;
+        if (blockMax > *max) *max = blockMax;
+    }
+    return 1;
+}
+
+int readStoreSignal(ResultStore *rs, int signal, size_t firstRow, size_t nRows, double *values) {
+    int column = signal == STORE_TIME ? 0 : rs->columns[signal];
+    int type = columnType(column, rs->nReals, rs->nIntegers);
+    if (firstRow > rs->rows || nRows > rs->rows - firstRow) return 0;
+    if (rs->kinds[column] == STORE_CONSTANT) {
+        for (size_t i = 0; i < nRows; i++) values[i] = rs->constants[column];
+        return 1;
+    }
+    try {
+        for (size_t i = 0; i < rs->groups.size() && nRows > 0; i++) {
+            const StoreGroup &g = rs->groups[i];
+            if (g.firstRow + g.rows <= firstRow) continue;
+            if (!readBlock(rs, g, column, 1) || !decodeBlock(rs, g, type, rs->kinds[column])) return 0;
+            size_t skip = firstRow - g.firstRow;
+            size_t n = g.rows - skip < nRows ? g.rows - skip : nRows;
+            memcpy(values, &rs->values[skip], n * sizeof(double));
+            values += n;
+            firstRow += n;
+            nRows -= n;
+        }
+    } catch (const std::bad_alloc &) {
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,102 @@
+/* -------------------------------------------------------------------------
+ * result_store.h
+ * Compressed columnar result file (.fmr). Each column of values is stored
+ * in blocks of a group of rows, so that a reader extracts the columns it
+ * needs without decoding the others. Real values and time are compressed
+ * by XOR with the value before (as in Facebook's Gorilla), Integer and
+ * Boolean values by run-length encoding. Strings are not stored.
+ * Columns of constants and fixed parameters are stored once, in the header,
+ * with their value at the first row. Columns of discrete variables and
+ * tunable parameters store only the rows at which their value changes.
+ *
+ * All numbers are little endian. The file is
+ *   header:  "FMRS", u32 version 1, u32 nReals, u32 nIntegers, u32 nBooleans,
+ *            u32 nSignals, per signal: u32 column, u32 length and name,
+ *            u32 length and description, per column: u8 kind, per constant
+ *            column: f64 value
+ *   groups:  u32 rows, f64 start time, f64 end time, u32 end of the block of
+ *            each column that is not constant, relative to the first block,
+ *            then per such column a block: f64 min, f64 max, and for a
+ *            discrete column varint number of changes, per change varint
+ *            rows since the change before (the first at row 0), then the
+ *            encoded values, of all rows or of the changes
+ * Column 0 is time, followed by the Real, Integer and Boolean values in the
+ * order of their value references in the OutputPlan. Aliases are signals
+ * of the same column. There is no index at the end of the file: a reader
+ * finds the groups by their headers, so that the file of a simulation that
+ * was killed is readable up to its last complete group.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the time column, as signal of readStoreSignal and getStoreSignalRange
+#define STORE_TIME -1
+
+// types of the signals
+#define STORE_REAL    0
+#define STORE_INTEGER 1  // Integer and Enumeration
+#define STORE_BOOLEAN 2
+
+// kinds of the signals, a column is of the most variable kind of its signals
+#define STORE_CONSTANT   0  // constants and fixed parameters
+#define STORE_DISCRETE   1  // discrete variables and tunable parameters
+#define STORE_CONTINUOUS 2
+
+typedef struct StoreWriter StoreWriter;
+
+// Returns NULL if out of memory. file must be opened in binary mode.
+// The receiver must call closeStoreWriter() to write the last rows and free the writer.
+StoreWriter *openStoreWriter(FILE *file, int nReals, int nIntegers, int nBooleans);
+
+// Adds a signal of the given kind stored in the given column, before the first row
+// is appended. Returns 0 if out of memory.
+int addStoreSignal(StoreWriter *w, const char *name, const char *description, int column, int kind);
+
+// Appends a row. The columns are written group by group.
+// Returns 0 if out of memory or writing the file failed.
+int appendStoreRow(StoreWriter *w, double time, const double *reals, const int *integers, const int *booleans);
+
+// Writes the rows of the last group and frees w.
+// Returns 0 if writing the file failed, e.g. because the disk is full.
+int closeStoreWriter(StoreWriter *w);
+
+typedef struct ResultStore ResultStore;
+
+// Returns NULL if path cannot be read or is not a result store.
+ResultStore *openResultStore(const char *path);
+void closeResultStore(ResultStore *rs);
+
+int getStoreSignalCount(ResultStore *rs);
+const char *getStoreSignalName(ResultStore *rs, int signal);
+const char *getStoreSignalDescription(ResultStore *rs, int signal);
+// one of STORE_REAL, STORE_INTEGER, STORE_BOOLEAN
+int getStoreSignalType(ResultStore *rs, int signal);
+// one of STORE_CONSTANT, STORE_DISCRETE, STORE_CONTINUOUS, the kind of its column
+int getStoreSignalKind(ResultStore *rs, int signal);
+// -1 if not found
+int findStoreSignal(ResultStore *rs, const char *name);
+size_t getStoreRowCount(ResultStore *rs);
+
+// Sets min and max of the signal, or STORE_TIME, read from the block headers
+// without decoding the values. Returns 0 if the file cannot be read.
+int getStoreSignalRange(ResultStore *rs, int signal, double *min, double *max);
+
+// Reads nRows values of the signal, or STORE_TIME, starting at firstRow into values.
+// Decodes only the blocks of the signal that hold these rows.
+// Returns 0 if the rows are out of range or the file cannot be read.
+int readStoreSignal(ResultStore *rs, int signal, size_t firstRow, size_t nRows, double *values);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RESULT_STORE_H
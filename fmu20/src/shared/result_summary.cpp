@@ -0,0 +1,171 @@
+/* -------------------------------------------------------------------------
+ * result_summary.cpp
+ * Online statistics of the values of a result, see result_summary.h. Each
+ * row is gathered as doubles into one array, and each statistic is kept in
+ * an array of its own, so that a row is added by a few loops over all
+ * columns without branches, which the compiler turns into vector
+ * instructions. Mean and variance are updated as by Welford, which does
+ * not lose precision to cancellation in long runs. Only the crossings of
+ * thresholds, usually few, are counted column by column.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include "result_summary.h"
+#include <math.h>
+#include <new>
+#include <vector>
+
+struct Crossings {
+    int column;
+    double threshold;
+    long count;
+    double first;
+    double last;
+};
+
+struct SummaryWriter {
+    int nReals;
+    int nIntegers;
+    int nBooleans;
+    int nColumns;
+    size_t rows;
+    double lastTime;                 // time of the row appended last
+    std::vector<double> values;      // of the row being appended
+    std::vector<double> previous;    // of the row appended last
+    std::vector<double> slopes;      // per column, 0.5 if linear, 0 if held, see setSummaryHold()
+    std::vector<double> min;
+    std::vector<double> max;
+    std::vector<double> mean;
+    std::vector<double> squares;     // sum of the squared differences from the mean
+    std::vector<double> integral;
+    std::vector<Crossings> crossings;
+};
+
+SummaryWriter *openSummaryWriter(int nReals, int nIntegers, int nBooleans) {
+    SummaryWriter *w = NULL;
+    try {
+        w = new SummaryWriter();
+        w->nReals = nReals;
+        w->nIntegers = nIntegers;
+        w->nBooleans = nBooleans;
+        w->nColumns = 1 + nReals + nIntegers + nBooleans;
+        w->rows = 0;
+        w->lastTime = 0;
+        w->values.resize(w->nColumns);
+        w->previous.resize(w->nColumns);
+        w->slopes.resize(w->nColumns, 0.5);
+        w->min.resize(w->nColumns, HUGE_VAL);
+        w->max.resize(w->nColumns, -HUGE_VAL);
+        w->mean.resize(w->nColumns, 0);
+        w->squares.resize(w->nColumns, 0);
+        w->integral.resize(w->nColumns, 0);
+    } catch (const std::bad_alloc &) {
+        delete w;
+        return NULL;
+    }
+    return w;
+}
+
+void setSummaryHold(SummaryWriter *w, int column) {
+    w->slopes[column] = 0;
+}
+
+int addSummaryThreshold(SummaryWriter *w, int column, double threshold) {
+    Crossings c;
+    c.column = column;
+    c.threshold = threshold;
+    c.count = 0;
+    c.first = NAN;
+    c.last = NAN;
+    try {
+        w->crossings.push_back(c);
+    } catch (const std::bad_alloc &) {
+        return -1;
+    }
+    return (int)w->crossings.size() - 1;
+}
+
+// counts the crossings between the row appended last and values, at time
+static void countCrossings(SummaryWriter *w, double time) {
+    for (size_t i = 0; i < w->crossings.size(); i++) {
+        Crossings &c = w->crossings[i];
+        double a = w->previous[c.column];
+        double b = w->values[c.column];
+        double t;
+        if (a != a || b != b || (a >= c.threshold) == (b >= c.threshold)) continue;
+        // a held value crosses at the row at which it changes, a linear one in between
+        t = w->slopes[c.column] ? w->lastTime + (c.threshold - a) / (b - a) * (time - w->lastTime) : time;
+        if (!c.count) c.first = t;
+        c.last = t;
+        c.count++;
+    }
+}
+
+void appendSummaryRow(SummaryWriter *w, double time, const double *reals, const int *integers, const int *booleans) {
+    int n = w->nColumns;
+    double *x = &w->values[0];
+    double *previous = &w->previous[0];
+    double *slopes = &w->slopes[0];
+    double *min = &w->min[0];
+    double *max = &w->max[0];
+    double *mean = &w->mean[0];
+    double *squares = &w->squares[0];
+    double *integral = &w->integral[0];
+    double dt = w->rows ? time - w->lastTime : 0;
+    double weight = 1.0 / (double)(w->rows + 1);
+    int c = 0;
+
+    // gather the row as doubles
+    x[c++] = time;
+    for (int i = 0; i < w->nReals; i++) x[c++] = reals[i];
+    for (int i = 0; i < w->nIntegers; i++) x[c++] = integers[i];
+    for (int i = 0; i < w->nBooleans; i++) x[c++] = booleans[i] ? 1 : 0;
+
+    for (int i = 0; i < n; i++) {
+        double v = x[i];
+        double delta = v - mean[i];
+        min[i] = v < min[i] ? v : min[i]; // NaN is neither
+        max[i] = v > max[i] ? v : max[i];
+        mean[i] += delta * weight;
+        squares[i] += delta * (v - mean[i]);
+    }
+    if (w->rows) {
+        for (int i = 0; i < n; i++) {
+            integral[i] += dt * (previous[i] + slopes[i] * (x[i] - previous[i]));
+        }
+        countCrossings(w, time);
+    }
+    w->values.swap(w->previous);
+    w->lastTime = time;
+    w->rows++;
+}
+
+size_t getSummaryRowCount(SummaryWriter *w) {
+    return w->rows;
+}
+
+void getSummaryStats(SummaryWriter *w, int column, SummaryStats *stats) {
+    if (!w->rows) {
+        stats->min = stats->max = stats->mean = stats->variance = stats->integral = stats->final = NAN;
+        return;
+    }
+    // min > max if all values are NaN
+    stats->min = w->min[column] <= w->max[column] ? w->min[column] : NAN;
+    stats->max = w->min[column] <= w->max[column] ? w->max[column] : NAN;
+    stats->mean = w->mean[column];
+    stats->variance = w->squares[column] / (double)w->rows;
+    stats->integral = w->integral[column];
+    stats->final = w->previous[column];
+}
+
+void getSummaryCrossings(SummaryWriter *w, int index, SummaryCrossings *crossings) {
+    const Crossings &c = w->crossings[index];
+    crossings->threshold = c.threshold;
+    crossings->count = c.count;
+    crossings->first = c.first;
+    crossings->last = c.last;
+}
+
+void closeSummaryWriter(SummaryWriter *w) {
+    delete w;
+}
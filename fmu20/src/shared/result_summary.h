@@ -0,0 +1,73 @@
+/* -------------------------------------------------------------------------
+ * result_summary.h
+ * Statistics of the values of a result, computed row by row while the
+ * simulation runs, so that runs that need only a summary of each variable,
+ * e.g. of a Monte Carlo study, do not keep their trajectories. Per column
+ * the writer keeps min, max, mean and variance of the values of the rows,
+ * the integral over time and the value of the last row, and counts the
+ * crossings of thresholds. A NaN value makes mean, variance and integral
+ * NaN, min and max are of the other values.
+ *
+ * Columns are numbered as in result_store.h: 0 is time, followed by the
+ * Real, Integer and Boolean values.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#ifndef RESULT_SUMMARY_H
+#define RESULT_SUMMARY_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SummaryWriter SummaryWriter;
+
+typedef struct {
+    double min;
+    double max;
+    double mean;      // of the values of the rows
+    double variance;  // of the values of the rows, not of the samples of a larger population
+    double integral;  // over time, of the lines between the rows, or of the steps of a held value
+    double final;     // the value of the last row
+} SummaryStats;
+
+typedef struct {
+    double threshold;
+    long count;       // rows at which the value is at or above the threshold and was not before, or vice versa
+    double first;     // time of the first and the last crossing, NaN if there is none
+    double last;
+} SummaryCrossings;
+
+// Returns NULL if out of memory.
+// The receiver must call closeSummaryWriter() to free the writer.
+SummaryWriter *openSummaryWriter(int nReals, int nIntegers, int nBooleans);
+
+// Holds the value of the column from its row until the next, for the integral
+// and the time of crossings, e.g. of discrete variables. By default the values
+// of a column change linearly between rows. Must be called before the first row.
+void setSummaryHold(SummaryWriter *w, int column);
+
+// Counts the crossings of threshold by the values of the column, before the first
+// row is appended. Returns the index of the crossings, or -1 if out of memory.
+int addSummaryThreshold(SummaryWriter *w, int column, double threshold);
+
+// Adds a row to the statistics of all columns.
+void appendSummaryRow(SummaryWriter *w, double time, const double *reals, const int *integers, const int *booleans);
+
+size_t getSummaryRowCount(SummaryWriter *w);
+
+// Sets the statistics of the column, all NaN if no row was appended.
+void getSummaryStats(SummaryWriter *w, int column, SummaryStats *stats);
+
+// Sets the crossings with the given index, see addSummaryThreshold().
+void getSummaryCrossings(SummaryWriter *w, int index, SummaryCrossings *crossings);
+
+void closeSummaryWriter(SummaryWriter *w);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RESULT_SUMMARY_H
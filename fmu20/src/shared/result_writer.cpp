@@ -0,0 +1,661 @@
+/* -------------------------------------------------------------------------
+ * result_writer.cpp
+ * Writer of the result file. The rows are queued in a ring of row buffers,
+ * allocated when the writer is opened. The simulation fills the buffer at
+ * head, the writer thread formats the one at tail. Each side advances its
+ * own index only, so queueing a row takes no lock. A side waits on the
+ * condition variable only when it finds the ring full or empty.
+ * MAT v4 files are written in the layout of Dymola result files, with the
+ * matrices stored transposed ("binTrans"): Aclass, name, description and
+ * dataInfo describe the signals, data_1 holds the constants and fixed
+ * parameters at start and end time, data_2 one column of time and
+ * time-varying signals per row. The number of columns of data_2 and the
+ * end time in data_1 are patched when the writer is closed. Columnar result
+ * stores are written by a StoreWriter, see result_store.h, pyramids next to
+ * the result file of any format by a PyramidWriter, see result_pyramid.h.
+ * Summaries are kept by a SummaryWriter, see result_summary.h, and written
+ * as CSV when the writer is closed.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include "result_writer.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "number_format.h"
+#include "result_pyramid.h"
+#include "result_store.h"
+#include "result_summary.h"
+
+// formatted rows are written in chunks of about this size
+#define CHUNK_SIZE (1 << 20)
+// memory for the row buffers of the ring, which has MIN_ROWS to MAX_ROWS buffers
+#define QUEUE_SIZE (16 << 20)
+#define MIN_ROWS 4
+#define MAX_ROWS 1024
+
+// buffer for the values of one row
+struct QueuedRow {
+    bool header;                         // true for the row of column names
+    double time;
+    std::vector<fmi2Real> reals;
+    std::vector<fmi2Integer> integers;
+    std::vector<fmi2Boolean> booleans;
+    std::vector<size_t> stringOffsets;   // per String value, offset into stringData
+    std::string stringData;              // the 0 terminated String values
+};
+
+struct ResultWriter {
+    const OutputPlan *plan;
+    VariableTable *vt;
+    FILE *file;
+    char separator;
+    char decimalPoint;
+    std::vector<char> chunk;             // formatted rows not yet written
+    bool failed;                         // true once writing to file failed
+    std::vector<const char *> strings;   // String values of the row being formatted
+
+    // the rows from tail to head - 1, modulo the size of the ring, are queued
+    std::vector<QueuedRow> rows;
+    std::atomic<size_t> head;            // advanced by the simulation only
+    std::atomic<size_t> tail;            // advanced by the writer thread only
+    std::atomic<bool> closing;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::atomic<bool> simulationWaiting; // set while the ring is full
+    std::atomic<bool> writerWaiting;     // set while the ring is empty
+    std::thread thread;
+    bool threaded;                       // false if rows are formatted by the simulation
+
+    int format;                          // RESULT_CSV, RESULT_MAT4, RESULT_STORE or RESULT_SUMMARY
+    StoreWriter *store;                  // RESULT_STORE only
+    SummaryWriter *summary;              // RESULT_SUMMARY only
+    std::vector<int> summaryCrossings;   // per column of the plan, index of its crossings or -1
+    PyramidWriter *pyramid;              // NULL unless added
+    // RESULT_MAT4 only
+    size_t written;                      // bytes written to file
+    std::vector<int> data1Columns;       // per row of data_1 but time, the column of the value
+    std::vector<int> data2Columns;       // per row of data_2 but time, the column of the value
+    std::vector<signed char> matSets;    // per column, 1 for data_1, 2 for data_2, 0 if not written
+    std::vector<int> matIndexes;         // per column, 1 based row in its data matrix
+    bool matStarted;                     // true once the matrices up to data_2 are written
+    long data2ColumnsOffset;             // of the number of columns of data_2 in file
+    long endTimeOffset;                  // of the end time in data_1
+    int32_t data2Rows;                   // number of rows written to data_2
+    double lastTime;
+};
+
+static void writeChunk(ResultWriter *w) {
+    if (!w->chunk.empty() && fwrite(&w->chunk[0], 1, w->chunk.size(), w->file) != w->chunk.size()) {
+        w->failed = true;
+    }
+    w->written += w->chunk.size();
+    w->chunk.clear();
+}
+
+static void appendName(ResultWriter *w, const char *s) {
+    std::vector<char> &out = w->chunk;
+    if (w->separator == ',') {
+        // treat array element, e.g. print a[1, 2] as a[1.2]
+        for (; *s; s++) {
+            if (*s != ' ') out.push_back(*s == ',' ? '.' : *s);
+        }
+    } else {
+        out.insert(out.end(), s, s + strlen(s));
+    }
+}
+
+static void appendHeader(ResultWriter *w) {
+    std::vector<char> &out = w->chunk;
+    static const char time[] = "time";
+    out.insert(out.end(), time, time + strlen(time));
+    for (int k = 0; k < w->plan->nColumns; k++) {
+        out.push_back(w->separator);
+        appendName(w, getVariableName(w->vt, w->plan->columnRows[k]));
+    }
+    out.push_back('\n');
+}
+
+static void appendRow(ResultWriter *w, double time, const fmi2Real *reals, const fmi2Integer *integers,
+                      const fmi2Boolean *booleans, const fmi2String *strings) {
+    const OutputPlan *plan = w->plan;
+    std::vector<char> &out = w->chunk;
+    size_t start = out.size();
+    // room for the time and all values but Strings, which grow the row when appended
+    out.resize(start + (size_t)(plan->nColumns + 1) * (NUMBER_BUFSIZE + 1));
+    char *p = &out[start];
+    p += formatDouble(p, time, w->decimalPoint);
+    for (int k = 0; k < plan->nColumns; k++) {
+        int v = plan->columnValues[k];
+        *p++ = w->separator;
+        switch (plan->columnTypes[k]) {
+            case elm_Real:
+                p += formatDouble(p, reals[v], w->decimalPoint);
+                break;
+            case elm_Integer:
+            case elm_Enumeration:
+                p += formatInt(p, integers[v]);
+                break;
+            case elm_Boolean:
+                p += formatInt(p, booleans[v]);
+                break;
+            case elm_String: {
+                const char *s = strings[v] ? strings[v] : "";
+                size_t length = strlen(s);
+                size_t end = p - &out[0];
+                out.resize(out.size() + length);
+                p = &out[end];
+                memcpy(p, s, length);
+                p += length;
+                break;
+            }
+            default:
+                p += sprintf(p, "NoValueForType=%d", plan->columnTypes[k]);
+        }
+    }
+    *p++ = '\n';
+    out.resize(p - &out[0]);
+}
+
+// the value of a numeric column
+static double getColumnValue(const OutputPlan *plan, int k, const fmi2Real *reals, const fmi2Integer *integers,
+                             const fmi2Boolean *booleans) {
+    int v = plan->columnValues[k];
+    switch (plan->columnTypes[k]) {
+        case elm_Real:        return reals[v];
+        case elm_Integer:
+        case elm_Enumeration: return integers[v];
+        case elm_Boolean:     return booleans[v];
+        default:              return 0;
+    }
+}
+
+// Assign the numeric columns to rows of data_1 and data_2. Columns sharing a value share a row.
+static void planMatFile(ResultWriter *w) {
+    const OutputPlan *plan = w->plan;
+    // per value of each base type, 1 based row in data_1 (negative) or data_2 (positive), 0 if unassigned
+    std::vector<int> realRows(plan->nReals), integerRows(plan->nIntegers), booleanRows(plan->nBooleans);
+    w->matSets.resize(plan->nColumns);
+    w->matIndexes.resize(plan->nColumns);
+    for (int k = 0; k < plan->nColumns; k++) {
+        int *row;
+        switch (plan->columnTypes[k]) {
+            case elm_Real:        row = &realRows[plan->columnValues[k]]; break;
+            case elm_Integer:
+            case elm_Enumeration: row = &integerRows[plan->columnValues[k]]; break;
+            case elm_Boolean:     row = &booleanRows[plan->columnValues[k]]; break;
+            default:              continue; // Strings cannot be stored
+        }
+        if (!*row) {
+            Enu variability = getVariableVariability(w->vt, plan->columnRows[k]);
+            if (variability == enu_constant || variability == enu_fixed) {
+                w->data1Columns.push_back(k);
+                *row = -(1 + (int)w->data1Columns.size()); // row 1 is time
+            } else {
+                w->data2Columns.push_back(k);
+                *row = 1 + (int)w->data2Columns.size();
+            }
+        }
+        w->matSets[k] = *row < 0 ? 1 : 2;
+        w->matIndexes[k] = *row < 0 ? -*row : *row;
+    }
+}
+
+static void appendBytes(std::vector<char> &out, const void *bytes, size_t n) {
+    out.insert(out.end(), (const char *)bytes, (const char *)bytes + n);
+}
+
+// type is 0 for double, 20 for int32 and 51 for text matrices
+static void appendMatMatrixHeader(std::vector<char> &out, const char *name, int32_t type, int32_t rows,
+                                  int32_t columns) {
+    const int one = 1;
+    int32_t header[5];
+    header[0] = type + (*(const char *)&one ? 0 : 1000); // 1000 for big endian
+    header[1] = rows;
+    header[2] = columns;
+    header[3] = 0; // not complex
+    header[4] = (int32_t)strlen(name) + 1;
+    appendBytes(out, header, sizeof(header));
+    appendBytes(out, name, strlen(name) + 1);
+}
+
+// a text matrix with one string per column, padded with blanks
+static void appendMatStrings(std::vector<char> &out, const char *name, const std::vector<const char *> &strings) {
+    size_t length = 1;
+    for (size_t i = 0; i < strings.size(); i++) {
+        if (strlen(strings[i]) > length) length = strlen(strings[i]);
+    }
+    appendMatMatrixHeader(out, name, 51, (int32_t)length, (int32_t)strings.size());
+    for (size_t i = 0; i < strings.size(); i++) {
+        size_t n = strlen(strings[i]);
+        appendBytes(out, strings[i], n);
+        out.insert(out.end(), length - n, ' ');
+    }
+}
+
+// Appends the matrices up to the header of data_2, data_1 with the values of the first row
+static void appendMatStart(ResultWriter *w, double time, const fmi2Real *reals, const fmi2Integer *integers,
+                           const fmi2Boolean *booleans) {
+    const OutputPlan *plan = w->plan;
+    std::vector<char> &out = w->chunk;
+    std::vector<const char *> names(1, "time");
+    std::vector<const char *> descriptions(1, "Time in [s]");
+    std::vector<int32_t> dataInfo;
+    int32_t timeInfo[4] = { 0, 1, 0, -1 };
+    static const char aclass[] = "Atrajectory" "1.1        " "           " "binTrans   ";
+
+    // Aclass holds 4 strings of 11 chars as rows, store it column by column
+    appendMatMatrixHeader(out, "Aclass", 51, 4, 11);
+    for (int column = 0; column < 11; column++) {
+        for (int row = 0; row < 4; row++) out.push_back(aclass[row * 11 + column]);
+    }
+    dataInfo.insert(dataInfo.end(), timeInfo, timeInfo + 4);
+    for (int k = 0; k < plan->nColumns; k++) {
+        if (!w->matSets[k]) continue;
+        names.push_back(getVariableName(w->vt, plan->columnRows[k]));
+        descriptions.push_back(getVariableDescription(w->vt, plan->columnRows[k]));
+        dataInfo.push_back(w->matSets[k]);
+        dataInfo.push_back(w->matIndexes[k]);
+        dataInfo.push_back(0);                           // interpolate linearly
+        dataInfo.push_back(w->matSets[k] == 1 ? 0 : -1); // constant or undefined outside of the time range
+    }
+    appendMatStrings(out, "name", names);
+    appendMatStrings(out, "description", descriptions);
+    appendMatMatrixHeader(out, "dataInfo", 20, 4, (int32_t)names.size());
+    appendBytes(out, dataInfo.data(), dataInfo.size() * sizeof(int32_t));
+
+    int32_t rows = 1 + (int32_t)w->data1Columns.size();
+    appendMatMatrixHeader(out, "data_1", 0, rows, 2);
+    for (int column = 0; column < 2; column++) {
+        if (column == 1) w->endTimeOffset = (long)(w->written + out.size());
+        appendBytes(out, &time, sizeof(double));
+        for (size_t i = 0; i < w->data1Columns.size(); i++) {
+            double value = getColumnValue(plan, w->data1Columns[i], reals, integers, booleans);
+            appendBytes(out, &value, sizeof(double));
+        }
+    }
+    // the number of columns follows the type and the number of rows
+    w->data2ColumnsOffset = (long)(w->written + out.size() + 2 * sizeof(int32_t));
+    appendMatMatrixHeader(out, "data_2", 0, 1 + (int32_t)w->data2Columns.size(), 0);
+    w->matStarted = true;
+}
+
+static void appendMatRow(ResultWriter *w, double time, const fmi2Real *reals, const fmi2Integer *integers,
+                         const fmi2Boolean *booleans) {
+    std::vector<char> &out = w->chunk;
+    if (!w->matStarted) appendMatStart(w, time, reals, integers, booleans);
+    size_t start = out.size();
+    out.resize(start + (1 + w->data2Columns.size()) * sizeof(double));
+    double *values = (double *)&out[start];
+    memcpy(values, &time, sizeof(double));
+    for (size_t i = 0; i < w->data2Columns.size(); i++) {
+        double value = getColumnValue(w->plan, w->data2Columns[i], reals, integers, booleans);
+        memcpy(values + 1 + i, &value, sizeof(double));
+    }
+    w->data2Rows++;
+    w->lastTime = time;
+}
+
+static void appendValues(ResultWriter *w, double time, const fmi2Real *reals, const fmi2Integer *integers,
+                         const fmi2Boolean *booleans, const fmi2String *strings) {
+    if (w->pyramid && !appendPyramidRow(w->pyramid, time, reals, integers, booleans)) w->failed = true;
+    if (w->format == RESULT_MAT4) {
+        appendMatRow(w, time, reals, integers, booleans);
+    } else if (w->format == RESULT_STORE) {
+        if (!appendStoreRow(w->store, time, reals, integers, booleans)) w->failed = true;
+    } else if (w->format == RESULT_SUMMARY) {
+        appendSummaryRow(w->summary, time, reals, integers, booleans);
+    } else {
+        appendRow(w, time, reals, integers, booleans, strings);
+    }
+}
+
+static void appendQueuedRow(ResultWriter *w, const QueuedRow &row) {
+    if (row.header) {
+        appendHeader(w);
+        return;
+    }
+    for (size_t i = 0; i < row.stringOffsets.size(); i++) {
+        w->strings[i] = row.stringData.c_str() + row.stringOffsets[i];
+    }
+    appendValues(w, row.time, row.reals.data(), row.integers.data(), row.booleans.data(), w->strings.data());
+}
+
+static void runWriter(ResultWriter *w) {
+    size_t n = w->rows.size();
+    for (;;) {
+        size_t tail = w->tail.load(std::memory_order_relaxed);
+        if (tail == w->head.load()) {
+            if (w->closing.load()) {
+                // rows queued before closing was set may show up only now
+                if (tail == w->head.load()) break;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(w->mutex);
+            w->writerWaiting.store(true);
+            w->changed.wait(lock, [w, tail] { return w->head.load() != tail || w->closing.load(); });
+            w->writerWaiting.store(false);
+            continue;
+        }
+        appendQueuedRow(w, w->rows[tail % n]);
+        w->tail.store(tail + 1);
+        if (w->simulationWaiting.load()) {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->changed.notify_all();
+        }
+        if (w->chunk.size() >= CHUNK_SIZE) writeChunk(w);
+    }
+    writeChunk(w);
+}
+
+// Returns the buffer at head, waits for the writer thread while the ring is full
+static QueuedRow &claimRow(ResultWriter *w) {
+    size_t head = w->head.load(std::memory_order_relaxed);
+    size_t n = w->rows.size();
+    if (head - w->tail.load() == n) {
+        std::unique_lock<std::mutex> lock(w->mutex);
+        w->simulationWaiting.store(true);
+        w->changed.wait(lock, [w, head, n] { return head - w->tail.load() < n; });
+        w->simulationWaiting.store(false);
+    }
+    return w->rows[head % n];
+}
+
+// Hands the buffer claimed last to the writer thread
+static void queueRow(ResultWriter *w) {
+    w->head.store(w->head.load(std::memory_order_relaxed) + 1);
+    if (w->writerWaiting.load()) {
+        std::lock_guard<std::mutex> lock(w->mutex);
+        w->changed.notify_all();
+    }
+}
+
+// the column of column k of the plan in stores and pyramids, 0 for Strings, which are not stored
+static int getStoreColumn(const OutputPlan *plan, int k) {
+    int column = 1 + plan->columnValues[k]; // after time
+    switch (plan->columnTypes[k]) {
+        case elm_Real:        return column;
+        case elm_Integer:
+        case elm_Enumeration: return column + plan->nReals;
+        case elm_Boolean:     return column + plan->nReals + plan->nIntegers;
+        default:              return 0;
+    }
+}
+
+// Opens the StoreWriter with one signal per numeric column
+static void openStore(ResultWriter *w) {
+    const OutputPlan *plan = w->plan;
+    w->store = openStoreWriter(w->file, plan->nReals, plan->nIntegers, plan->nBooleans);
+    if (!w->store) throw std::bad_alloc();
+    for (int k = 0; k < plan->nColumns; k++) {
+        int column = getStoreColumn(plan, k);
+        if (!column) continue;
+        int row = plan->columnRows[k];
+        int kind;
+        switch (getVariableVariability(w->vt, row)) {
+            case enu_constant:
+            case enu_fixed:       kind = STORE_CONSTANT; break;
+            case enu_tunable:
+            case enu_discrete:    kind = STORE_DISCRETE; break;
+            default:              kind = STORE_CONTINUOUS; break;
+        }
+        if (!addStoreSignal(w->store, getVariableName(w->vt, row), getVariableDescription(w->vt, row), column, kind)) {
+            throw std::bad_alloc();
+        }
+    }
+}
+
+// Opens the SummaryWriter, the values of all but continuous variables hold between rows
+static void openSummary(ResultWriter *w) {
+    const OutputPlan *plan = w->plan;
+    w->summary = openSummaryWriter(plan->nReals, plan->nIntegers, plan->nBooleans);
+    if (!w->summary) throw std::bad_alloc();
+    w->summaryCrossings.resize(plan->nColumns, -1);
+    for (int k = 0; k < plan->nColumns; k++) {
+        int column = getStoreColumn(plan, k);
+        if (column && getVariableVariability(w->vt, plan->columnRows[k]) != enu_continuous) {
+            setSummaryHold(w->summary, column);
+        }
+    }
+}
+
+static void outOfMemory() {
+    printf("out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+ResultWriter *openResultWriter(const OutputPlan *plan, VariableTable *vt, FILE *file, int format,
+                               char separator, int threaded) {
+    ResultWriter *w = NULL;
+    try {
+        w = new ResultWriter();
+        w->plan = plan;
+        w->vt = vt;
+        w->file = file;
+        w->separator = separator;
+        w->decimalPoint = separator == ',' ? '.' : ',';
+        w->failed = false;
+        w->head.store(0);
+        w->tail.store(0);
+        w->closing.store(false);
+        w->simulationWaiting.store(false);
+        w->writerWaiting.store(false);
+        w->threaded = false;
+        w->format = format;
+        w->store = NULL;
+        w->summary = NULL;
+        w->pyramid = NULL;
+        w->written = 0;
+        w->matStarted = false;
+        w->data2ColumnsOffset = 0;
+        w->endTimeOffset = 0;
+        w->data2Rows = 0;
+        w->lastTime = 0;
+        if (format == RESULT_MAT4) planMatFile(w);
+        w->chunk.reserve(CHUNK_SIZE + (size_t)(plan->nColumns + 1) * (NUMBER_BUFSIZE + 1));
+        w->strings.resize(plan->nStrings);
+        if (format == RESULT_STORE) openStore(w);
+        if (format == RESULT_SUMMARY) openSummary(w);
+        if (!threaded) return w;
+
+        size_t rowSize = sizeof(QueuedRow) + plan->nReals * sizeof(fmi2Real)
+            + plan->nIntegers * sizeof(fmi2Integer) + plan->nBooleans * sizeof(fmi2Boolean)
+            + plan->nStrings * (sizeof(size_t) + 16);
+        size_t n = QUEUE_SIZE / rowSize;
+        w->rows.resize(n < MIN_ROWS ? MIN_ROWS : n > MAX_ROWS ? MAX_ROWS : n);
+        for (size_t i = 0; i < w->rows.size(); i++) {
+            QueuedRow &row = w->rows[i];
+            row.reals.resize(plan->nReals);
+            row.integers.resize(plan->nIntegers);
+            row.booleans.resize(plan->nBooleans);
+            row.stringOffsets.resize(plan->nStrings);
+        }
+        try {
+            w->thread = std::thread(runWriter, w);
+            w->threaded = true;
+        } catch (const std::system_error &) {
+            // no threads, format on the calling thread
+            std::vector<QueuedRow>().swap(w->rows);
+        }
+    } catch (const std::bad_alloc &) {
+        if (w && w->store) closeStoreWriter(w->store);
+        if (w && w->summary) closeSummaryWriter(w->summary);
+        delete w;
+        return NULL;
+    }
+    return w;
+}
+
+void addResultPyramid(ResultWriter *w, FILE *file) {
+    const OutputPlan *plan = w->plan;
+    w->pyramid = openPyramidWriter(file, plan->nReals, plan->nIntegers, plan->nBooleans);
+    if (!w->pyramid) outOfMemory();
+    for (int k = 0; k < plan->nColumns; k++) {
+        int column = getStoreColumn(plan, k);
+        if (column && !addPyramidSignal(w->pyramid, getVariableName(w->vt, plan->columnRows[k]), column)) {
+            outOfMemory();
+        }
+    }
+}
+
+void setResultThreshold(ResultWriter *w, int k, double threshold) {
+    int column = getStoreColumn(w->plan, k);
+    if (w->format != RESULT_SUMMARY || !column) return;
+    w->summaryCrossings[k] = addSummaryThreshold(w->summary, column, threshold);
+    if (w->summaryCrossings[k] < 0) outOfMemory();
+}
+
+void writeResultHeader(ResultWriter *w) {
+    // MAT files and stores get their names with the first row of values, summaries when closed
+    if (w->format != RESULT_CSV) return;
+    try {
+        if (!w->threaded) {
+            appendHeader(w);
+            return;
+        }
+        claimRow(w).header = true;
+        queueRow(w);
+    } catch (const std::bad_alloc &) {
+        outOfMemory();
+    }
+}
+
+void writeResultRow(ResultWriter *w, double time) {
+    const OutputPlan *plan = w->plan;
+    writeResultValues(w, time, plan->reals, plan->integers, plan->booleans, plan->strings);
+}
+
+void writeResultValues(ResultWriter *w, double time, const fmi2Real *reals, const fmi2Integer *integers,
+                       const fmi2Boolean *booleans, const fmi2String *strings) {
+    const OutputPlan *plan = w->plan;
+    try {
+        if (!w->threaded) {
+            appendValues(w, time, reals, integers, booleans, strings);
+            if (w->chunk.size() >= CHUNK_SIZE) writeChunk(w);
+            return;
+        }
+        QueuedRow &row = claimRow(w);
+        row.header = false;
+        row.time = time;
+        std::copy(reals, reals + plan->nReals, row.reals.begin());
+        std::copy(integers, integers + plan->nIntegers, row.integers.begin());
+        std::copy(booleans, booleans + plan->nBooleans, row.booleans.begin());
+        // the FMU owns the Strings only until its next call, copy them
+        row.stringData.clear();
+        for (int i = 0; w->format == RESULT_CSV && i < plan->nStrings; i++) {
+            const char *s = strings[i] ? strings[i] : "";
+            row.stringOffsets[i] = row.stringData.size();
+            row.stringData.append(s, strlen(s) + 1);
+        }
+        queueRow(w);
+    } catch (const std::bad_alloc &) {
+        outOfMemory();
+    }
+}
+
+// Writes the size of data_2 and the end time into the MAT file
+static void finishMatFile(ResultWriter *w) {
+    const OutputPlan *plan = w->plan;
+    if (!w->matStarted) {
+        // no row written, store the names and the values sampled last
+        try {
+            appendMatStart(w, 0, plan->reals, plan->integers, plan->booleans);
+        } catch (const std::bad_alloc &) {
+            outOfMemory();
+        }
+    }
+    writeChunk(w);
+    if (fseek(w->file, w->data2ColumnsOffset, SEEK_SET)
+            || fwrite(&w->data2Rows, sizeof(int32_t), 1, w->file) != 1
+            || (w->data2Rows && (fseek(w->file, w->endTimeOffset, SEEK_SET)
+                || fwrite(&w->lastTime, sizeof(double), 1, w->file) != 1))
+            || fseek(w->file, 0, SEEK_END)) {
+        w->failed = true;
+    }
+}
+
+static void appendNumber(ResultWriter *w, double d) {
+    char buffer[NUMBER_BUFSIZE];
+    w->chunk.push_back(w->separator);
+    w->chunk.insert(w->chunk.end(), buffer, buffer + formatDouble(buffer, d, w->decimalPoint));
+}
+
+static void appendSummaryLine(ResultWriter *w, const char *name, int column, int crossings) {
+    SummaryStats stats;
+    appendName(w, name);
+    getSummaryStats(w->summary, column, &stats);
+    appendNumber(w, stats.min);
+    appendNumber(w, stats.max);
+    appendNumber(w, stats.mean);
+    appendNumber(w, stats.variance);
+    appendNumber(w, stats.integral);
+    appendNumber(w, stats.final);
+    if (crossings >= 0) {
+        SummaryCrossings c;
+        getSummaryCrossings(w->summary, crossings, &c);
+        appendNumber(w, c.threshold);
+        appendNumber(w, (double)c.count);
+        appendNumber(w, c.first);
+        appendNumber(w, c.last);
+    } else {
+        // no threshold, leave the fields empty
+        w->chunk.insert(w->chunk.end(), 4, w->separator);
+    }
+    w->chunk.push_back('\n');
+}
+
+// Writes the summary, one line per numeric column of the plan, after one of time
+static void finishSummary(ResultWriter *w) {
+    static const char *names[] = { "name", "min", "max", "mean", "variance", "integral", "final",
+                                   "threshold", "crossings", "firstCrossing", "lastCrossing" };
+    const OutputPlan *plan = w->plan;
+    try {
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (i) w->chunk.push_back(w->separator);
+            w->chunk.insert(w->chunk.end(), names[i], names[i] + strlen(names[i]));
+        }
+        w->chunk.push_back('\n');
+        appendSummaryLine(w, "time", 0, -1);
+        for (int k = 0; k < plan->nColumns; k++) {
+            int column = getStoreColumn(plan, k);
+            if (column) {
+                appendSummaryLine(w, getVariableName(w->vt, plan->columnRows[k]), column, w->summaryCrossings[k]);
+            }
+        }
+    } catch (const std::bad_alloc &) {
+        outOfMemory();
+    }
+    writeChunk(w);
+    closeSummaryWriter(w->summary);
+}
+
+int closeResultWriter(ResultWriter *w) {
+    int ok;
+    if (w->threaded) {
+        w->closing.store(true);
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->changed.notify_all();
+        }
+        w->thread.join();
+    } else {
+        writeChunk(w);
+    }
+    if (w->format == RESULT_MAT4) finishMatFile(w);
+    if (w->format == RESULT_STORE && !closeStoreWriter(w->store)) w->failed = true;
+    if (w->format == RESULT_SUMMARY) finishSummary(w);
+    if (w->pyramid && !closePyramidWriter(w->pyramid)) w->failed = true;
+    if (fflush(w->file)) w->failed = true;
+    ok = !w->failed;
+    delete w;
+    return ok;
+}
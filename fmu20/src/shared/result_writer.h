@@ -0,0 +1,96 @@
+/* -------------------------------------------------------------------------
+ * result_writer.h
+ * Writer of the result file. The simulation samples the values of a row
+ * into an OutputPlan and queues them with writeResultRow. A thread of the
+ * ResultWriter formats the queued rows and writes them in large chunks,
+ * so that the simulation does not wait for the disk. The result file is
+ * written as CSV, as MAT v4 file, the format of Dymola result files, or as
+ * compressed columnar result store, see result_store.h. A summary file holds
+ * statistics of each variable instead of its values, see result_summary.h.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <stdio.h>
+#include "fmi2TypesPlatform.h"
+#include "XmlParserCApi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The columns of the result file, compiled once from the variable table.
+// The value references of each base type are collected into one array, so that
+// sampling a row costs one get call per base type. Columns with the same value
+// reference and base type, i.e. aliases, share one value.
+typedef struct OutputPlan {
+    int nColumns;                  // one per recorded variable, the time column not counted
+    Elm *columnTypes;              // per column, base type of the variable
+    int *columnRows;               // per column, row of the variable in the VariableTable
+    int *columnValues;             // per column, index into the values of its base type
+    int nReals;                    // number of distinct value references per base type
+    int nIntegers;                 // Integer and Enumeration
+    int nBooleans;
+    int nStrings;
+    fmi2ValueReference *realRefs;
+    fmi2ValueReference *integerRefs;
+    fmi2ValueReference *booleanRefs;
+    fmi2ValueReference *stringRefs;
+    fmi2Real *reals;               // the values of the row sampled last
+    fmi2Integer *integers;
+    fmi2Boolean *booleans;
+    fmi2String *strings;
+} OutputPlan;
+
+typedef struct ResultWriter ResultWriter;
+
+// formats of the result file
+#define RESULT_CSV   0  // text, one row per line, see outputRow
+#define RESULT_MAT4  1  // binary MAT v4 in Dymola layout, Strings are not stored
+#define RESULT_STORE 2  // binary columnar store, see result_store.h, Strings are not stored
+#define RESULT_SUMMARY 3 // text, one line of statistics per variable, written when closed,
+                         // Strings are not summarized
+
+// Returns NULL if out of memory.
+// Rows are written to file in the given format. The writer keeps references
+// to plan and vt. separator applies to CSV only. MAT files and stores must be
+// opened in binary mode, MAT files must be seekable. With threaded 0, or if no thread can be
+// started, the rows are formatted by the calling thread, still written in chunks.
+// The receiver must call closeResultWriter() to write the rows and free the writer.
+ResultWriter *openResultWriter(const OutputPlan *plan, VariableTable *vt, FILE *file, int format,
+                               char separator, int threaded);
+
+// Writes a pyramid of the rows to file, opened in binary mode, see result_pyramid.h.
+// Must be called before the first row is queued. The receiver closes file after
+// closeResultWriter().
+void addResultPyramid(ResultWriter *w, FILE *file);
+
+// Counts the crossings of threshold by the values of column k of the plan.
+// Ignored unless the format is RESULT_SUMMARY. Must be called before the first
+// row is queued.
+void setResultThreshold(ResultWriter *w, int k, double threshold);
+
+// Queues the row of column names. Ignored unless the format is RESULT_CSV.
+void writeResultHeader(ResultWriter *w);
+
+// Queues the values sampled last into the plan as the row at time.
+// If the writer is behind by all its row buffers, waits until one is written:
+// the memory used is bounded and no row is dropped.
+void writeResultRow(ResultWriter *w, double time);
+
+// As writeResultRow, but queues the given values, one per value of each base type
+// of the plan, e.g. of a row sampled before the last.
+void writeResultValues(ResultWriter *w, double time, const fmi2Real *reals, const fmi2Integer *integers,
+                       const fmi2Boolean *booleans, const fmi2String *strings);
+
+// Writes all queued rows, stops the thread and frees w.
+// Returns 0 if writing the file failed, e.g. because the disk is full.
+int closeResultWriter(ResultWriter *w);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RESULT_WRITER_H
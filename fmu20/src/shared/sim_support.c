@@ -17,22 +17,200 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <assert.h>
 #include <stdarg.h>
 #include "fmi2.h"
 #include "sim_support.h"
-#include "xmlVersionParser.h"
+#include "zip_reader.h"
+#include "unpack_cache.h"
 
 extern FMU fmu;
 
+// directory the FMU is unpacked to, with a trailing separator
+static char *unpackedPath = NULL;
+// true if unpackedPath is an entry of the unpack cache
+static int unpackedToCache = 0;
+// binary cache of the parsed model description, stored below unpackedPath
+// when that is an entry of the unpack cache
+#define XML_CACHE_FILE ".modelDescription.bin"
+// sections of the model description used by the simulators, the parser skips
+// the others, e.g. type and unit definitions and annotations. Relative
+// tolerances need the type definitions too, see getXmlSections()
+#define XML_SECTIONS (sec_DefaultExperiment | sec_ModelVariables | sec_ModelStructure)
+// Threads the parser uses for large ModelVariables sections, set by environment
+// variable FMUSIM_PARSER_THREADS: a number, or "auto" for one per core. Default 1.
+#define PARSER_THREADS_ENV "FMUSIM_PARSER_THREADS"
+// How outputRow() writes the result file, set by environment variable
+// FMUSIM_RESULT_WRITER: "thread" (default) formats and writes the rows on a
+// thread of their own, "sync" on the thread of the simulation.
+#define RESULT_WRITER_ENV "FMUSIM_RESULT_WRITER"
+
+// How loadFMU() unpacks the FMU, set by environment variable FMUSIM_UNPACK:
+// "full" (default) unzips the whole archive, "lazy" reads the model description
+// straight from the archive and extracts only the binary for this platform,
+// and the resources when the simulation asks for their location.
+#define UNPACK_MODE_ENV "FMUSIM_UNPACK"
+#define UNPACK_FULL 0
+#define UNPACK_LAZY 1
+// "memory", on Linux only, is like "lazy" but loads the binary from a memfd
+// through /proc/self/fd, so that nothing is written to disk except the resources
+#define UNPACK_MEMORY 2
+
+// format of the result file, set by command line option -o format=csv|mat4|fmr|summary
+static int resultFormat = RESULT_CSV;
+
+// true if a pyramid of the rows is written to RESULT_PYRAMID_FILE, set by
+// command line option -o pyramid=on|off, see result_pyramid.h
+static int writePyramid = 0;
+static FILE *pyramidFile = NULL;
+
+// The variables recorded in the result file, set by command line options
+// -o select=, -o causality= and -o variability=: a variable is recorded if its
+// name matches one of the selectPatterns and its causality and variability
+// are among the given ones. All variables are recorded by default.
+static char **selectPatterns = NULL;
+static int nSelectPatterns = 0;
+static unsigned int recordedCausalities = 0;  // bit 1 << Enu per causality, 0 for all
+static unsigned int recordedVariabilities = 0;
+
+// Interval of the rows of the result file, set by command line option
+// -o interval=. Rows are output at the first step at or after each multiple
+// of the interval, and at the end time. 0 outputs a row at every step.
+static double outputInterval = 0;
+static double outputStart;     // time of the first row
+static long outputCount = 0;   // rows output so far, on the grid of outputInterval
+static double outputLast;      // time of the row output last
+static double outputEnd = 1.0; // end time of the simulation
+
+// Tolerances of the Real variables in the result file, set by command line
+// options -o reltol=, relative to the nominal value, and -o abstol=, each for
+// all variables or, given as pattern=tolerance, for the variables with a name
+// matching the pattern. The last matching option of each kind applies, the
+// tolerance of a variable is abstol + reltol * |nominal|. With tolerances, a
+// sampled row is left out as long as the line between the rows output before
+// and after it passes all its Real values within their tolerance (swinging door
+// compression), and no Integer, Boolean or String value changes. Real variables
+// without a tolerance are recorded exactly.
+typedef struct {
+    char *pattern;   // NULL for all variables
+    double tolerance;
+    int relative;    // 1 for reltol, 0 for abstol
+} ToleranceOption;
+static ToleranceOption *toleranceOptions = NULL;
+static int nToleranceOptions = 0;
+
+// Thresholds of the variables in the summary file, set by command line option
+// -o threshold=, for all variables or, given as pattern=threshold, for the
+// variables with a name matching the pattern. The last matching option applies.
+// The summary counts the crossings of its threshold by each variable.
+typedef struct {
+    char *pattern;   // NULL for all variables
+    double threshold;
+} ThresholdOption;
+static ThresholdOption *thresholdOptions = NULL;
+static int nThresholdOptions = 0;
+
+// Triggers of the recording of rows, set by command line option -o trigger=,
+// one of the triggerEvents, e.g. stateEvent, a threshold crossed by any variable,
+// or, given as pattern=threshold, by the variables matching the pattern. With
+// triggers, the rows of the last preTrigger seconds are held in a ring in memory,
+// and written only when a trigger fires, followed by the rows of the next
+// postTrigger seconds. A trigger that fires within these extends the window.
+// At most triggerLimit windows are written, 0 for no limit, so that the memory
+// and the size of the result file do not grow with the length of the simulation.
+typedef struct {
+    char *pattern;   // NULL for all variables
+    double threshold;
+    int event;       // OUTPUT_..._EVENT, or -1 for a threshold
+} TriggerOption;
+static TriggerOption *triggerOptions = NULL;
+static int nTriggerOptions = 0;
+static const char *triggerEvents[] = { "timeEvent", "stateEvent", "stepEvent" }; // by OUTPUT_..._EVENT
+static double preTrigger = 1;     // set by -o pretrigger=
+static double postTrigger = 1;    // set by -o posttrigger=
+static long triggerLimit = 0;     // set by -o triggerlimit=
+
+// the values of a row, copied from the OutputPlan
+typedef struct {
+    double time;
+    fmi2Real *reals;
+    fmi2Integer *integers;
+    fmi2Boolean *booleans;
+    fmi2String *strings;   // into stringData
+    char *stringData;
+    size_t stringSize;     // allocated size of stringData
+} SavedRow;
+
+// state of the swinging door, see outputWithTolerance()
+static double *realTolerances = NULL; // per Real value of the OutputPlan, NULL until the first row
+static double *slopesMin = NULL;      // per Real value, the slopes of the lines from keptRow
+static double *slopesMax = NULL;      // that pass all rows held since within their tolerance
+static SavedRow keptRow;              // the row output last
+static SavedRow heldRow;              // the row sampled last, if not output yet
+static int rowHeld = 0;
+
+// a threshold trigger of a value of the OutputPlan
+typedef struct {
+    Elm type;
+    int index;        // into the values of type
+    double threshold;
+    double previous;  // value of the row sampled before
+} ValueTrigger;
+
+// state of the triggered recording, see outputTriggered()
+static ValueTrigger *valueTriggers = NULL; // NULL until the first row
+static int nValueTriggers = 0;
+static unsigned int firedEvents = 0;       // bit 1 << OUTPUT_..._EVENT per event since the row before
+static SavedRow *ring = NULL;              // the rows of the last preTrigger seconds, oldest first
+static int ringSize = 0;                   // rows allocated
+static int ringStart = 0;                  // index of the oldest row
+static int ringCount = 0;
+static int recording = 0;                  // true while in a window
+static double recordingEnd;                // end time of the window
+static long nWindows = 0;
+
+typedef struct {
+    const char *name;
+    Enu value;
+} EnuName;
+static const EnuName causalities[] = {
+    { "parameter", enu_parameter }, { "calculatedParameter", enu_calculatedParameter },
+    { "input", enu_input }, { "output", enu_output }, { "local", enu_local },
+    { "independent", enu_independent }
+};
+static const EnuName variabilities[] = {
+    { "constant", enu_constant }, { "fixed", enu_fixed }, { "tunable", enu_tunable },
+    { "discrete", enu_discrete }, { "continuous", enu_continuous }
+};
+
+// the FMU archive, kept open while unpacking lazily, NULL otherwise
+static ZipArchive *fmuArchive = NULL;
+static int resourcesExtracted = 0;
+// true if the FMU binary is loaded from memory
+static int unpackedToMemory = 0;
+// memfd holding the FMU binary, -1 unless unpacking to memory
+static int memoryFileFd = -1;
+
 #if !WINDOWS
 #define MAX_PATH 1024
 #include <unistd.h>  // mkdtemp()
 #include <dlfcn.h> //dlsym()
 #endif /* WINDOWS */
 
+#ifdef __linux__
+#include <errno.h>
+#include <sys/syscall.h>  // SYS_memfd_create
+#endif /* __linux__ */
+// true if the FMU binary can be loaded from an anonymous memory file
+#if defined(__linux__) && defined(SYS_memfd_create)
+#define MEMORY_FILES_SUPPORTED 1
+#else
+#define MEMORY_FILES_SUPPORTED 0
+#endif
+
 #if WINDOWS
-int unzip(const char *zipPath, const char *outPath) {
+int unzipWithTool(const char *zipPath, const char *outPath) {
     int code;
     char binPath[BUFSIZE];
     int n = BUFSIZE + strlen(UNZIP_CMD) + strlen(outPath) + 3 +  strlen(zipPath) + 9;
@@ -72,7 +250,7 @@ int unzip(const char *zipPath, const char *outPath) {
 
 #else /* WINDOWS */
 
-int unzip(const char *zipPath, const char *outPath) {
+int unzipWithTool(const char *zipPath, const char *outPath) {
     int code;
     int n;
     char* cmd;
@@ -103,6 +281,22 @@ int unzip(const char *zipPath, const char *outPath) {
 }
 #endif /* WINDOWS */
 
+// Extracts the FMU with the built-in zip reader, without starting a process.
+// Falls back to the external tool for archives the reader cannot handle.
+int unzip(const char *zipPath, const char *outPath) {
+    int ok = 0;
+    ZipArchive *za = zipOpen(zipPath);
+    if (za) {
+        ok = zipExtractAll(za, outPath);
+        zipClose(za);
+    }
+    if (!ok) {
+        printf("retrying with %s\n", UNZIP_CMD);
+        ok = unzipWithTool(zipPath, outPath);
+    }
+    return ok;
+}
+
 #if WINDOWS
 // fileName is an absolute path, e.g. C:\test\a.fmu
 // or relative to the current dir, e.g. ..\test\a.fmu
@@ -139,19 +333,28 @@ static char* getTmpPath() {
         fprintf(stderr, "Couldn't create temporary directory\n");
         exit(1);
     }
-    char * results = calloc(sizeof(char), strlen(tmp) + 2);
-    strncat(results, tmp, strlen(tmp));
-    return strcat(results, "/");
+    size_t n = strlen(tmp);
+    char *results = calloc(sizeof(char), n + 2);
+    if (!results) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(results, tmp, n);
+    results[n] = '/';
+    return results;
 }
 #endif /* WINDOWS */
 
 char *getTempResourcesLocation() {
-    char *tempPath = getTmpPath();
-    char *resourcesLocation = (char *)calloc(sizeof(char), 9 + strlen(RESOURCES_DIR) + strlen(tempPath));
+    char *resourcesLocation;
+    // when unpacking lazily, the resources are extracted only now
+    if (fmuArchive && !resourcesExtracted) {
+        resourcesExtracted = zipExtractDir(fmuArchive, "resources/", unpackedPath);
+    }
+    resourcesLocation = (char *)calloc(sizeof(char), 9 + strlen(RESOURCES_DIR) + strlen(unpackedPath));
     strcpy(resourcesLocation, "file:///");
-    strcat(resourcesLocation, tempPath);
+    strcat(resourcesLocation, unpackedPath);
     strcat(resourcesLocation, RESOURCES_DIR);
-    free(tempPath);
     return resourcesLocation;
 }
 
@@ -339,6 +542,141 @@ static void printModelDescription(ModelDescription* md){
     free((void *)attributes);
 }
 
+
+static int getUnpackMode() {
+    const char *mode = getenv(UNPACK_MODE_ENV);
+    if (!mode || !*mode || !strcmp(mode, "full")) return UNPACK_FULL;
+    if (!strcmp(mode, "lazy")) return UNPACK_LAZY;
+    if (!strcmp(mode, "memory")) {
+        if (MEMORY_FILES_SUPPORTED) return UNPACK_MEMORY;
+        printf("warning: %s=memory is only supported on Linux, unpacking lazily\n", UNPACK_MODE_ENV);
+        return UNPACK_LAZY;
+    }
+    printf("warning: Unknown %s=%s, unpacking the full FMU\n", UNPACK_MODE_ENV, mode);
+    return UNPACK_FULL;
+}
+
+static int getParserThreads() {
+    const char *threads = getenv(PARSER_THREADS_ENV);
+    char *end;
+    long n;
+    if (!threads || !*threads) return 1;
+    if (!strcmp(threads, "auto")) return 0;
+    n = strtol(threads, &end, 10);
+    if (*end || n < 1 || n > 1024) {
+        printf("warning: Invalid %s=%s, parsing on one thread\n", PARSER_THREADS_ENV, threads);
+        return 1;
+    }
+    return (int)n;
+}
+
+static int getResultWriterThreaded() {
+    const char *mode = getenv(RESULT_WRITER_ENV);
+    if (!mode || !*mode || !strcmp(mode, "thread")) return 1;
+    if (!strcmp(mode, "sync")) return 0;
+    printf("warning: Unknown %s=%s, writing the result file on a thread\n", RESULT_WRITER_ENV, mode);
+    return 1;
+}
+
+// Returns the sections to parse, with the type definitions if a relative tolerance
+// is given, so that variables inherit the nominal value of their declaredType
+static int getXmlSections() {
+    int i;
+    for (i = 0; i < nToleranceOptions; i++) {
+        if (toleranceOptions[i].relative) return XML_SECTIONS | sec_TypeDefinitions;
+    }
+    return XML_SECTIONS;
+}
+
+// Returns the entry of fmuArchive at path, which may use '\\' as separator
+// like DLL_DIR on Windows, NULL if not found
+static const ZipEntry *findArchiveEntry(const char *path) {
+    const ZipEntry *entry;
+    char *p;
+    char *name = strdup(path);
+    for (p = name; *p; p++) {
+        if (*p == '\\') *p = '/';
+    }
+    entry = zipFindEntry(fmuArchive, name);
+    if (!entry) printf("error: %s not found in the FMU\n", name);
+    free(name);
+    return entry;
+}
+
+// Extracts the file at path, relative to the FMU root, from fmuArchive to unpackedPath.
+// Returns 0 to indicate failure.
+static int extractFromArchive(const char *path) {
+    const ZipEntry *entry = findArchiveEntry(path);
+    return entry && zipExtractEntry(fmuArchive, entry, unpackedPath);
+}
+
+#if MEMORY_FILES_SUPPORTED
+// Returns a path for unpackedPath that is not created unless the FMU has
+// resources, so that loading from memory leaves no empty dirs behind
+static char *getMemoryTmpPath() {
+    char *tmpPath = (char *)calloc(sizeof(char), 32);
+    sprintf(tmpPath, "fmuMem%d/", (int)getpid());
+    return tmpPath;
+}
+
+// Inflates the file at path, relative to the FMU root, from fmuArchive into
+// a memfd. Returns the path of the memfd below /proc/self/fd, to be passed to
+// dlopen(). Returns NULL to indicate failure.
+static char *extractToMemoryFile(const char *path) {
+    size_t size;
+    size_t written = 0;
+    char *data;
+    char *fdPath;
+    const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    const ZipEntry *entry = findArchiveEntry(path);
+    if (!entry) return NULL;
+    data = (char *)zipExtractToMemory(fmuArchive, entry, &size);
+    if (!data) return NULL;
+    memoryFileFd = (int)syscall(SYS_memfd_create, name, 0);
+    if (memoryFileFd < 0) {
+        printf("error: Could not create memory file for %s: %s\n", path, strerror(errno));
+        free(data);
+        return NULL;
+    }
+    while (written < size) {
+        ssize_t n = write(memoryFileFd, data + written, size - written);
+        if (n <= 0) break;
+        written += n;
+    }
+    free(data);
+    if (written < size) {
+        printf("error: Could not write memory file for %s\n", path);
+        return NULL;
+    }
+    fdPath = (char *)calloc(sizeof(char), 32);
+    sprintf(fdPath, "/proc/self/fd/%d", memoryFileFd);
+    return fdPath;
+}
+#else /* MEMORY_FILES_SUPPORTED */
+static char *getMemoryTmpPath() {
+    return NULL;
+}
+
+static char *extractToMemoryFile(const char *path) {
+    return NULL;
+}
+#endif /* MEMORY_FILES_SUPPORTED */
+
+// Parses the model description in fmuArchive without extracting it.
+// Returns NULL to indicate failure.
+static ModelDescription *parseFromArchive() {
+    ModelDescription *md = NULL;
+    size_t size;
+    char *xml;
+    const ZipEntry *entry = findArchiveEntry(XML_FILE);
+    if (!entry) return NULL;
+    xml = (char *)zipExtractToMemory(fmuArchive, entry, &size);
+    if (!xml) return NULL;
+    md = parseSectionsFromMemory(XML_FILE, xml, (int)size, getXmlSections());
+    free(xml);
+    return md;
+}
+
 void loadFMU(const char* fmuFileName) {
     char* fmuPath;
     char* tmpPath;
@@ -350,25 +688,51 @@ void loadFMU(const char* fmuFileName) {
     fmuPath = getFmuPath(fmuFileName);
     if (!fmuPath) exit(EXIT_FAILURE);
 
-    // unzip the FMU to the tmpPath directory
-    tmpPath = getTmpPath();
-    if (!unzip(fmuPath, tmpPath)) exit(EXIT_FAILURE);
+    // reuse the FMU unpacked by an earlier run, if the unpack cache is enabled,
+    // else unzip the FMU to the tmpPath directory, or open it for lazy unpacking
+    tmpPath = unpackToCache(fmuPath);
+    if (tmpPath) {
+        unpackedToCache = 1;
+    } else {
+        int unpackMode = getUnpackMode();
+        if (unpackMode != UNPACK_FULL) fmuArchive = zipOpen(fmuPath);
+        unpackedToMemory = fmuArchive && unpackMode == UNPACK_MEMORY;
+        tmpPath = unpackedToMemory ? getMemoryTmpPath() : getTmpPath();
+        if (!fmuArchive && !unzip(fmuPath, tmpPath)) exit(EXIT_FAILURE);
+    }
+    unpackedPath = strdup(tmpPath);
 
-    // parse tmpPath\modelDescription.xml
-    xmlPath = calloc(sizeof(char), strlen(tmpPath) + strlen(XML_FILE) + 1);
-    sprintf(xmlPath, "%s%s", tmpPath, XML_FILE);
-    // check FMI version of the FMU to match current simulator version
-    if (!checkFmiVersion(xmlPath)) {
+    setParserThreads(getParserThreads());
+    if (fmuArchive) {
+        fmu.modelDescription = parseFromArchive();
+    } else {
+        // parse tmpPath\modelDescription.xml, the parser also checks that the
+        // FMI version of the FMU matches the current simulator version
+        xmlPath = calloc(sizeof(char), strlen(tmpPath) + strlen(XML_FILE) + 1);
+        sprintf(xmlPath, "%s%s", tmpPath, XML_FILE);
+        if (unpackedToCache) {
+            // reuse the AST of an earlier run instead of parsing the xml again
+            char *cachePath = calloc(sizeof(char), strlen(tmpPath) + strlen(XML_CACHE_FILE) + 1);
+            sprintf(cachePath, "%s%s", tmpPath, XML_CACHE_FILE);
+            fmu.modelDescription = parseWithCache(xmlPath, cachePath, getXmlSections());
+            free(cachePath);
+        } else {
+            fmu.modelDescription = parseSections(xmlPath, getXmlSections());
+        }
         free(xmlPath);
-        free(fmuPath);
-        free(tmpPath);
-        exit(EXIT_FAILURE);
     }
-
-    fmu.modelDescription = parse(xmlPath);
-    free(xmlPath);
     if (!fmu.modelDescription) exit(EXIT_FAILURE);
     printModelDescription(fmu.modelDescription);
+    fmu.variables = buildVariableTable(fmu.modelDescription);
+    if (!fmu.variables) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    fmu.outputPlan = compileOutputPlan(fmu.variables);
+    if (!fmu.outputPlan) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
 #ifdef FMI_COSIMULATION
     modelId = getAttributeValue((Element *)getCoSimulation(fmu.modelDescription), att_modelIdentifier);
 #else // FMI_MODEL_EXCHANGE
@@ -378,7 +742,17 @@ void loadFMU(const char* fmuFileName) {
     dllPath = calloc(sizeof(char), strlen(tmpPath) + strlen(DLL_DIR)
         + strlen(modelId) +  strlen(DLL_SUFFIX) + 1);
     sprintf(dllPath, "%s%s%s%s", tmpPath, DLL_DIR, modelId, DLL_SUFFIX);
-    if (!loadDll(dllPath, &fmu)) {
+    if (unpackedToMemory) {
+        // load the binary from memory instead of a file below tmpPath
+        char *memoryPath = extractToMemoryFile(dllPath + strlen(tmpPath));
+        free(dllPath);
+        dllPath = memoryPath;
+    } else if (fmuArchive && !extractFromArchive(dllPath + strlen(tmpPath))) {
+        // when unpacking lazily, extract only the binary for this platform
+        free(dllPath);
+        dllPath = NULL;
+    }
+    if (!dllPath || !loadDll(dllPath, &fmu)) {
         free(dllPath);
         free(fmuPath);
         free(tmpPath);
@@ -389,120 +763,559 @@ void loadFMU(const char* fmuFileName) {
     free(tmpPath);
 }
 
-int checkFmiVersion(const char *xmlPath) {
-    char *xmlFmiVersion = extractVersion(xmlPath);
-    if (xmlFmiVersion == NULL) {
-        printf("The FMI version of the FMU could not be read: %s", xmlPath);
-        return FALSE;
-    } else if (strcmp(xmlFmiVersion, fmi2Version) == 0) {
-        free(xmlFmiVersion);
-        return TRUE;
-    }
-    printf("The FMU to simulate is FMI %s standard, but expected a FMI %s standard FMU", fmi2Version, xmlFmiVersion);
-    free(xmlFmiVersion);
-    return FALSE;
-}
-
 void deleteUnzippedFiles() {
-    char *fmuTempPath = getTmpPath();
-    char *cmd = (char *)calloc(15 + strlen(fmuTempPath), sizeof(char));
+    char *cmd;
+    if (fmuArchive) {
+        zipClose(fmuArchive);
+        fmuArchive = NULL;
+    }
+#if MEMORY_FILES_SUPPORTED
+    if (memoryFileFd >= 0) {
+        close(memoryFileFd);
+        memoryFileFd = -1;
+    }
+#endif /* MEMORY_FILES_SUPPORTED */
+    if (!unpackedPath) return;
+    if (unpackedToCache) {
+        // keep the files for the next run, just allow their eviction
+        releaseCachedFmu();
+        free(unpackedPath);
+        unpackedPath = NULL;
+        return;
+    }
+    cmd = (char *)calloc(15 + strlen(unpackedPath), sizeof(char));
 #if WINDOWS
-    sprintf(cmd, "rmdir /S /Q %s", fmuTempPath);
+    sprintf(cmd, "rmdir /S /Q %s", unpackedPath);
 #else /* WINDOWS */
-    sprintf(cmd, "rm -rf %s", fmuTempPath);
+    sprintf(cmd, "rm -rf %s", unpackedPath);
 #endif /* WINDOWS */
     system(cmd);
     free(cmd);
-    free(fmuTempPath);
+    free(unpackedPath);
+    unpackedPath = NULL;
+}
+
+// '*' matches any sequence of chars, incl. '.', '?' any char
+static int matchGlob(const char *pattern, const char *name) {
+    const char *star = NULL; // the last '*' in pattern
+    const char *resume = NULL; // in name, where the last '*' matched
+    while (*name) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        } else if (star) {
+            // let the last '*' match one more char
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return 0;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return !*pattern;
+}
+
+static int isRecorded(VariableTable *vt, int row) {
+    int i;
+    if (recordedCausalities && !(recordedCausalities & 1u << getVariableCausality(vt, row))) return 0;
+    if (recordedVariabilities && !(recordedVariabilities & 1u << getVariableVariability(vt, row))) return 0;
+    if (!nSelectPatterns) return 1;
+    for (i = 0; i < nSelectPatterns; i++) {
+        if (matchGlob(selectPatterns[i], getVariableName(vt, row))) return 1;
+    }
+    return 0;
+}
+
+OutputPlan *compileOutputPlan(VariableTable *vt) {
+    int n = getVariableCount(vt);
+    int row, k;
+    // per row, the value of the row and its aliases, -1 if none yet
+    int *rowValues = (int *)malloc((n + 1) * sizeof(int));
+    OutputPlan *plan = (OutputPlan *)calloc(1, sizeof(OutputPlan));
+    if (!plan || !rowValues) {
+        free(rowValues);
+        free(plan);
+        return NULL;
+    }
+    // n + 1 elements, so that no allocation is of size 0
+    plan->columnTypes = (Elm *)calloc(n + 1, sizeof(Elm));
+    plan->columnValues = (int *)calloc(n + 1, sizeof(int));
+    plan->columnRows = (int *)calloc(n + 1, sizeof(int));
+    plan->realRefs = (fmi2ValueReference *)calloc(n + 1, sizeof(fmi2ValueReference));
+    plan->integerRefs = (fmi2ValueReference *)calloc(n + 1, sizeof(fmi2ValueReference));
+    plan->booleanRefs = (fmi2ValueReference *)calloc(n + 1, sizeof(fmi2ValueReference));
+    plan->stringRefs = (fmi2ValueReference *)calloc(n + 1, sizeof(fmi2ValueReference));
+    plan->reals = (fmi2Real *)calloc(n + 1, sizeof(fmi2Real));
+    plan->integers = (fmi2Integer *)calloc(n + 1, sizeof(fmi2Integer));
+    plan->booleans = (fmi2Boolean *)calloc(n + 1, sizeof(fmi2Boolean));
+    plan->strings = (fmi2String *)calloc(n + 1, sizeof(fmi2String));
+    if (!plan->columnTypes || !plan->columnValues || !plan->columnRows || !plan->realRefs
+            || !plan->integerRefs || !plan->booleanRefs || !plan->stringRefs || !plan->reals
+            || !plan->integers || !plan->booleans || !plan->strings) {
+        free(rowValues);
+        freeOutputPlan(plan);
+        return NULL;
+    }
+    for (row = 0; row < n; row++) rowValues[row] = -1;
+    for (row = 0; row < n; row++) {
+        fmi2ValueReference vr;
+        Elm type;
+        int first;
+        if (!isRecorded(vt, row)) continue;
+        vr = getVariableValueReference(vt, row);
+        type = getVariableBaseType(vt, row);
+        first = findVariableRow(vt, vr, type);
+        if (first < 0) first = row;
+        k = plan->nColumns++;
+        plan->columnTypes[k] = type;
+        plan->columnRows[k] = row;
+        if (rowValues[first] >= 0) {
+            // an alias of an earlier column
+            plan->columnValues[k] = rowValues[first];
+            continue;
+        }
+        switch (type) {
+            case elm_Real:
+                plan->realRefs[plan->nReals] = vr;
+                plan->columnValues[k] = plan->nReals++;
+                break;
+            case elm_Integer:
+            case elm_Enumeration:
+                plan->integerRefs[plan->nIntegers] = vr;
+                plan->columnValues[k] = plan->nIntegers++;
+                break;
+            case elm_Boolean:
+                plan->booleanRefs[plan->nBooleans] = vr;
+                plan->columnValues[k] = plan->nBooleans++;
+                break;
+            case elm_String:
+                plan->stringRefs[plan->nStrings] = vr;
+                plan->columnValues[k] = plan->nStrings++;
+                break;
+            default:
+                plan->columnValues[k] = -1; // no value
+        }
+        rowValues[first] = plan->columnValues[k];
+    }
+    free(rowValues);
+    if (!plan->nColumns && n > 0) printf("warning: No variable is selected for the result file\n");
+    return plan;
+}
+
+void freeOutputPlan(OutputPlan *plan) {
+    if (!plan) return;
+    free(plan->columnTypes);
+    free(plan->columnValues);
+    free(plan->columnRows);
+    free(plan->realRefs);
+    free(plan->integerRefs);
+    free(plan->booleanRefs);
+    free(plan->stringRefs);
+    free(plan->reals);
+    free(plan->integers);
+    free(plan->booleans);
+    free((void *)plan->strings);
+    free(plan);
+}
+
+// get the values of all columns from the FMU, one call per base type
+static void sampleOutputPlan(OutputPlan *plan, FMU *fmu, fmi2Component c) {
+    if (plan->nReals > 0) fmu->getReal(c, plan->realRefs, plan->nReals, plan->reals);
+    if (plan->nIntegers > 0) fmu->getInteger(c, plan->integerRefs, plan->nIntegers, plan->integers);
+    if (plan->nBooleans > 0) fmu->getBoolean(c, plan->booleanRefs, plan->nBooleans, plan->booleans);
+    if (plan->nStrings > 0) fmu->getString(c, plan->stringRefs, plan->nStrings, plan->strings);
+}
+
+// copy the values sampled last into row
+static void saveRow(SavedRow *row, const OutputPlan *plan, double time) {
+    size_t size = 0;
+    int i;
+    if (!row->reals) {
+        // n + 1 elements, so that no allocation is of size 0
+        row->reals = (fmi2Real *)calloc(plan->nReals + 1, sizeof(fmi2Real));
+        row->integers = (fmi2Integer *)calloc(plan->nIntegers + 1, sizeof(fmi2Integer));
+        row->booleans = (fmi2Boolean *)calloc(plan->nBooleans + 1, sizeof(fmi2Boolean));
+        row->strings = (fmi2String *)calloc(plan->nStrings + 1, sizeof(fmi2String));
+        if (!row->reals || !row->integers || !row->booleans || !row->strings) {
+            printf("out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    row->time = time;
+    memcpy(row->reals, plan->reals, plan->nReals * sizeof(fmi2Real));
+    memcpy(row->integers, plan->integers, plan->nIntegers * sizeof(fmi2Integer));
+    memcpy(row->booleans, plan->booleans, plan->nBooleans * sizeof(fmi2Boolean));
+    // the FMU owns the Strings only until its next call, copy them
+    for (i = 0; i < plan->nStrings; i++) size += strlen(plan->strings[i] ? plan->strings[i] : "") + 1;
+    if (size > row->stringSize) {
+        char *data = (char *)realloc(row->stringData, size);
+        if (!data) {
+            printf("out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        row->stringData = data;
+        row->stringSize = size;
+    }
+    size = 0;
+    for (i = 0; i < plan->nStrings; i++) {
+        const char *s = plan->strings[i] ? plan->strings[i] : "";
+        size_t n = strlen(s) + 1;
+        memcpy(row->stringData + size, s, n);
+        row->strings[i] = row->stringData + size;
+        size += n;
+    }
 }
 
-static void doubleToCommaString(char* buffer, double r){
-    char* comma;
-    sprintf(buffer, "%.16g", r);
-    comma = strchr(buffer, '.');
-    if (comma) *comma = ',';
+// true if an Integer, Boolean or String value sampled last differs from the one in row
+static int isDiscreteChange(const OutputPlan *plan, const SavedRow *row) {
+    int i;
+    if (memcmp(plan->integers, row->integers, plan->nIntegers * sizeof(fmi2Integer))
+            || memcmp(plan->booleans, row->booleans, plan->nBooleans * sizeof(fmi2Boolean))) return 1;
+    for (i = 0; i < plan->nStrings; i++) {
+        if (strcmp(plan->strings[i] ? plan->strings[i] : "", row->strings[i])) return 1;
+    }
+    return 0;
+}
+
+// the tolerance of the Real variable in row of vt, see toleranceOptions
+static double getTolerance(VariableTable *vt, int row) {
+    double reltol = 0, abstol = 0, nominal;
+    ValueStatus vs;
+    int i;
+    for (i = 0; i < nToleranceOptions; i++) {
+        const ToleranceOption *option = &toleranceOptions[i];
+        if (option->pattern && !matchGlob(option->pattern, getVariableName(vt, row))) continue;
+        if (option->relative) reltol = option->tolerance;
+        else abstol = option->tolerance;
+    }
+    nominal = getVariableNominal(vt, row, &vs);
+    if (vs != valueDefined) nominal = 1;
+    return abstol + reltol * fabs(nominal);
+}
+
+static void compileTolerances(VariableTable *vt, const OutputPlan *plan) {
+    int i, k;
+    realTolerances = (double *)malloc((plan->nReals + 1) * sizeof(double));
+    slopesMin = (double *)malloc((plan->nReals + 1) * sizeof(double));
+    slopesMax = (double *)malloc((plan->nReals + 1) * sizeof(double));
+    if (!realTolerances || !slopesMin || !slopesMax) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < plan->nReals; i++) realTolerances[i] = HUGE_VAL;
+    for (k = 0; k < plan->nColumns; k++) {
+        double tolerance;
+        if (plan->columnTypes[k] != elm_Real) continue;
+        tolerance = getTolerance(vt, plan->columnRows[k]);
+        // aliases share a value, the smallest tolerance applies
+        i = plan->columnValues[k];
+        if (tolerance < realTolerances[i]) realTolerances[i] = tolerance;
+    }
+}
+
+// allow any line from keptRow
+static void openDoor(const OutputPlan *plan) {
+    int i;
+    for (i = 0; i < plan->nReals; i++) {
+        slopesMin[i] = -HUGE_VAL;
+        slopesMax[i] = HUGE_VAL;
+    }
+}
+
+// true if the line from keptRow to the values sampled last at time passes all rows held since
+static int isInDoor(const OutputPlan *plan, double time) {
+    double dt = time - keptRow.time;
+    int i;
+    if (!(dt > 0)) return 0;
+    for (i = 0; i < plan->nReals; i++) {
+        double slope = (plan->reals[i] - keptRow.reals[i]) / dt;
+        if (!(slope >= slopesMin[i] && slope <= slopesMax[i])) return 0; // NaN is not
+    }
+    return 1;
 }
 
-// output time and all variables in CSV format
+// restrict the lines from keptRow to those that pass the values sampled last within their tolerance
+static void narrowDoor(const OutputPlan *plan, double time) {
+    double dt = time - keptRow.time;
+    int i;
+    for (i = 0; i < plan->nReals; i++) {
+        double lower = (plan->reals[i] - realTolerances[i] - keptRow.reals[i]) / dt;
+        double upper = (plan->reals[i] + realTolerances[i] - keptRow.reals[i]) / dt;
+        // a NaN closes the door, so that the next row outputs this one
+        if (!(lower <= slopesMin[i])) slopesMin[i] = lower;
+        if (!(upper >= slopesMax[i])) slopesMax[i] = upper;
+    }
+}
+
+static void writeSavedRow(FMU *fmu, const SavedRow *row) {
+    writeResultValues(fmu->resultWriter, row->time, row->reals, row->integers, row->booleans, row->strings);
+}
+
+// Holds back the row sampled last at time. The held row is output when the next row
+// is not on a line from the row output last that passes all rows held since, or
+// when an Integer, Boolean or String value changes. See toleranceOptions.
+static void outputWithTolerance(FMU *fmu, double time) {
+    const OutputPlan *plan = fmu->outputPlan;
+    int changed;
+    if (!realTolerances) compileTolerances(fmu->variables, plan);
+    if (!keptRow.reals) {
+        // the first row
+        writeResultRow(fmu->resultWriter, time);
+        saveRow(&keptRow, plan, time);
+        openDoor(plan);
+        return;
+    }
+    changed = isDiscreteChange(plan, &keptRow);
+    if (changed || !isInDoor(plan, time)) {
+        if (rowHeld) {
+            // the held row ends the line, its Integer, Boolean and String values are those of keptRow
+            SavedRow row = keptRow;
+            writeSavedRow(fmu, &heldRow);
+            keptRow = heldRow;
+            heldRow = row;
+            rowHeld = 0;
+            openDoor(plan);
+        }
+        if (changed || !(time > keptRow.time)) {
+            // a step, output both rows
+            writeResultRow(fmu->resultWriter, time);
+            saveRow(&keptRow, plan, time);
+            openDoor(plan);
+            return;
+        }
+    }
+    narrowDoor(plan, time);
+    saveRow(&heldRow, plan, time);
+    rowHeld = 1;
+}
+
+// the value of a numeric type of the OutputPlan sampled last as double
+static double getPlanValue(const OutputPlan *plan, Elm type, int index) {
+    switch (type) {
+        case elm_Real:    return plan->reals[index];
+        case elm_Boolean: return plan->booleans[index] ? 1 : 0;
+        default:          return plan->integers[index];
+    }
+}
+
+// the value triggers of the recorded variables, see triggerOptions
+static void compileTriggers(VariableTable *vt, const OutputPlan *plan) {
+    int i, k;
+    valueTriggers = (ValueTrigger *)malloc((plan->nColumns + 1) * sizeof(ValueTrigger));
+    if (!valueTriggers) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (k = 0; k < plan->nColumns; k++) {
+        const char *name = getVariableName(vt, plan->columnRows[k]);
+        if (plan->columnTypes[k] == elm_String) continue;
+        for (i = nTriggerOptions - 1; i >= 0; i--) {
+            const TriggerOption *option = &triggerOptions[i];
+            if (option->event < 0 && (!option->pattern || matchGlob(option->pattern, name))) {
+                ValueTrigger *trigger = &valueTriggers[nValueTriggers++];
+                trigger->type = plan->columnTypes[k];
+                trigger->index = plan->columnValues[k];
+                trigger->threshold = option->threshold;
+                trigger->previous = getPlanValue(plan, trigger->type, trigger->index);
+                break;
+            }
+        }
+    }
+}
+
+// true if an event given by -o trigger= happened or a value crossed its threshold
+// since the row sampled before
+static int isTriggered(const OutputPlan *plan) {
+    int fired = 0;
+    int i;
+    for (i = 0; i < nTriggerOptions; i++) {
+        if (triggerOptions[i].event >= 0 && (firedEvents & 1u << triggerOptions[i].event)) fired = 1;
+    }
+    firedEvents = 0;
+    for (i = 0; i < nValueTriggers; i++) {
+        ValueTrigger *trigger = &valueTriggers[i];
+        double value = getPlanValue(plan, trigger->type, trigger->index);
+        if (value == value && trigger->previous == trigger->previous
+                && (value >= trigger->threshold) != (trigger->previous >= trigger->threshold)) {
+            fired = 1;
+        }
+        trigger->previous = value;
+    }
+    return fired;
+}
+
+// drop the rows of the ring before the pre-trigger window of a trigger at time,
+// the windows are widened by 1e-9 of their length, so that rounding keeps the rows at their edge
+static void dropRingRows(double time) {
+    while (ringCount > 0 && ring[ringStart].time < time - preTrigger * (1 + 1e-9)) {
+        ringStart = (ringStart + 1) % ringSize;
+        ringCount--;
+    }
+}
+
+// the slot for the row sampled last at time at the end of the ring, grows the ring if it is full
+static SavedRow *claimRingRow(double time) {
+    dropRingRows(time);
+    if (ringCount == ringSize) {
+        int n = ringSize ? 2 * ringSize : 64;
+        SavedRow *rows = (SavedRow *)realloc(ring, n * sizeof(SavedRow));
+        if (!rows) {
+            printf("out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        memset(rows + ringSize, 0, (n - ringSize) * sizeof(SavedRow));
+        // move the rows that wrapped around behind the others
+        memcpy(rows + ringSize, rows, ringStart * sizeof(SavedRow));
+        memset(rows, 0, ringStart * sizeof(SavedRow));
+        ring = rows;
+        ringSize = n;
+    }
+    return &ring[(ringStart + ringCount++) % ringSize];
+}
+
+// Writes the row sampled last at time only within a window around a trigger,
+// holds it in the ring otherwise. See triggerOptions.
+static void outputTriggered(FMU *fmu, double time) {
+    const OutputPlan *plan = fmu->outputPlan;
+    if (!valueTriggers) compileTriggers(fmu->variables, plan);
+    if (isTriggered(plan)) {
+        if (!recording && (!triggerLimit || nWindows < triggerLimit)) {
+            // start a window with the rows before the trigger
+            dropRingRows(time);
+            for (; ringCount > 0; ringCount--) {
+                writeSavedRow(fmu, &ring[ringStart]);
+                ringStart = (ringStart + 1) % ringSize;
+            }
+            recording = 1;
+            nWindows++;
+        }
+        if (recording) recordingEnd = time + postTrigger * (1 + 1e-9);
+    }
+    if (recording && time > recordingEnd) recording = 0;
+    if (recording) {
+        writeResultRow(fmu->resultWriter, time);
+    } else if (!triggerLimit || nWindows < triggerLimit) {
+        saveRow(claimRingRow(time), plan, time);
+    }
+}
+
+// pass the thresholds of the recorded variables to the ResultWriter, see thresholdOptions
+static void setThresholds(FMU *fmu) {
+    const OutputPlan *plan = fmu->outputPlan;
+    int k, i;
+    if (nThresholdOptions > 0 && resultFormat != RESULT_SUMMARY) {
+        printf("warning: thresholds apply to -o format=summary only\n");
+        return;
+    }
+    for (k = 0; k < plan->nColumns; k++) {
+        const char *name = getVariableName(fmu->variables, plan->columnRows[k]);
+        for (i = nThresholdOptions - 1; i >= 0; i--) {
+            const ThresholdOption *option = &thresholdOptions[i];
+            if (!option->pattern || matchGlob(option->pattern, name)) {
+                setResultThreshold(fmu->resultWriter, k, option->threshold);
+                break;
+            }
+        }
+    }
+}
+
+FILE *openResultFile() {
+    return fopen(getResultFileName(), resultFormat == RESULT_CSV || resultFormat == RESULT_SUMMARY ? "w" : "wb");
+}
+
+const char *getResultFileName() {
+    switch (resultFormat) {
+        case RESULT_MAT4:    return RESULT_MAT_FILE;
+        case RESULT_STORE:   return RESULT_STORE_FILE;
+        case RESULT_SUMMARY: return RESULT_SUMMARY_FILE;
+        default:             return RESULT_FILE;
+    }
+}
+
+const char *getResultFormatName() {
+    switch (resultFormat) {
+        case RESULT_MAT4:    return "MAT";
+        case RESULT_STORE:   return "FMR";
+        case RESULT_SUMMARY: return "summary";
+        default:             return "CSV";
+    }
+}
+
+// output time and all variables in CSV format, or as MAT file, see openResultFile()
 // if separator is ',', columns are separated by ',' and '.' is used for floating-point numbers.
 // otherwise, the given separator (e.g. ';' or '\t') is to separate columns, and ',' is used 
 // as decimal dot in floating-point numbers.
+// The rows are written to file by a ResultWriter, call finishOutput() before closing file.
+// Only the selected variables are sampled, and with an output interval only the steps on
+// its grid, see outputInterval. With tolerances, rows are held back and output only if
+// needed to restore the values left out by linear interpolation, see toleranceOptions.
 void outputRow(FMU *fmu, fmi2Component c, double time, FILE* file, char separator, fmi2Boolean header) {
-    int k;
-    fmi2Real r;
-    fmi2Integer i;
-    fmi2Boolean b;
-    fmi2String s;
-    fmi2ValueReference vr;
-    int n = getScalarVariableSize(fmu->modelDescription);
-    char buffer[32];
-
-    // print first column
+    if (!fmu->resultWriter) {
+        fmu->resultWriter = openResultWriter(fmu->outputPlan, fmu->variables, file, resultFormat,
+                                             separator, getResultWriterThreaded());
+        if (!fmu->resultWriter) {
+            printf("out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        if (writePyramid) {
+            pyramidFile = fopen(RESULT_PYRAMID_FILE, "wb");
+            if (pyramidFile) addResultPyramid(fmu->resultWriter, pyramidFile);
+            else printf("warning: could not open %s, no pyramid is written\n", RESULT_PYRAMID_FILE);
+        }
+        setThresholds(fmu);
+        if (nTriggerOptions > 0 && nToleranceOptions > 0) {
+            printf("warning: tolerances do not apply to triggered recording\n");
+        }
+    }
     if (header) {
-        fprintf(file, "time");
-    } else {
-        if (separator==',')
-            fprintf(file, "%.16g", time);
-        else {
-            // separator is e.g. ';' or '\t'
-            doubleToCommaString(buffer, time);
-            fprintf(file, "%s", buffer);
-        }
-    }
-
-    // print all other columns
-    for (k = 0; k < n; k++) {
-        ScalarVariable *sv = getScalarVariable(fmu->modelDescription, k);
-        if (header) {
-            // output names only
-            if (separator == ',') {
-                // treat array element, e.g. print a[1, 2] as a[1.2]
-                const char *s = getAttributeValue((Element *)sv, att_name);
-                fprintf(file, "%c", separator);
-                while (*s) {
-                    if (*s != ' ') {
-                        fprintf(file, "%c", *s == ',' ? '.' : *s);
-                    }
-                    s++;
-                }
-            } else {
-                fprintf(file, "%c%s", separator, getAttributeValue((Element *)sv, att_name));
-            }
-        } else {
-            // output values
-            vr = getValueReference(sv);
-            switch (getElementType(getTypeSpec(sv))) {
-                case elm_Real:
-                    fmu->getReal(c, &vr, 1, &r);
-                    if (separator == ',') {
-                        fprintf(file, ",%.16g", r);
-                    } else {
-                        // separator is e.g. ';' or '\t'
-                        doubleToCommaString(buffer, r);
-                        fprintf(file, "%c%s", separator, buffer);
-                    }
-                    break;
-                case elm_Integer:
-                case elm_Enumeration:
-                    fmu->getInteger(c, &vr, 1, &i);
-                    fprintf(file, "%c%d", separator, i);
-                    break;
-                case elm_Boolean:
-                    fmu->getBoolean(c, &vr, 1, &b);
-                    fprintf(file, "%c%d", separator, b);
-                    break;
-                case elm_String:
-                    fmu->getString(c, &vr, 1, &s);
-                    fprintf(file, "%c%s", separator, s);
-                    break;
-                default:
-                    fprintf(file, "%cNoValueForType=%d", separator, getElementType(getTypeSpec(sv)));
-            }
+        writeResultHeader(fmu->resultWriter);
+        return;
+    }
+    if (outputInterval > 0) {
+        double tolerance = outputInterval * 1e-9;
+        if (!outputCount) {
+            outputStart = time;
+        } else if (time < outputStart + outputCount * outputInterval - tolerance
+                   && (time < outputEnd - tolerance || outputLast >= outputEnd - tolerance)) {
+            return; // between two rows, or after the row at the end time
         }
-    } // for
+        outputCount = (long)((time - outputStart) / outputInterval + 1e-9) + 1;
+        outputLast = time;
+    }
+    sampleOutputPlan(fmu->outputPlan, fmu, c);
+    if (nTriggerOptions > 0) {
+        outputTriggered(fmu, time);
+        return;
+    }
+    if (nToleranceOptions > 0) {
+        outputWithTolerance(fmu, time);
+        return;
+    }
+    writeResultRow(fmu->resultWriter, time);
+}
 
-    // terminate this row
-    fprintf(file, "\n");
+void outputEvent(int event) {
+    firedEvents |= 1u << event;
+}
+
+// write all rows output so far and stop the ResultWriter
+void finishOutput(FMU *fmu) {
+    if (!fmu->resultWriter) return;
+    if (nTriggerOptions > 0) printf("%ld windows recorded around triggers\n", nWindows);
+    if (rowHeld) {
+        writeSavedRow(fmu, &heldRow);
+        rowHeld = 0;
+    }
+    if (!closeResultWriter(fmu->resultWriter)) {
+        printf("error: could not write all rows to %s%s\n", getResultFileName(),
+               pyramidFile ? " or " RESULT_PYRAMID_FILE : "");
+    }
+    fmu->resultWriter = NULL;
+    if (pyramidFile && fclose(pyramidFile)) printf("error: could not write %s\n", RESULT_PYRAMID_FILE);
+    pyramidFile = NULL;
 }
 
 static const char* fmi2StatusToString(fmi2Status status){
@@ -520,10 +1333,8 @@ static const char* fmi2StatusToString(fmi2Status status){
 }
 
 // search a fmu for the given variable, matching the type specified.
-// return NULL if not found
-static ScalarVariable* getSV(FMU* fmu, char type, fmi2ValueReference vr) {
-    int i;
-    int n = getScalarVariableSize(fmu->modelDescription);
+// return its row in the variable table, -1 if not found
+static int getSV(FMU* fmu, char type, fmi2ValueReference vr) {
     Elm tp;
 
     switch (type) {
@@ -531,15 +1342,9 @@ static ScalarVariable* getSV(FMU* fmu, char type, fmi2ValueReference vr) {
         case 'i': tp = elm_Integer; break;
         case 'b': tp = elm_Boolean; break;
         case 's': tp = elm_String;  break;
-        default : tp = elm_BAD_DEFINED;
+        default : return -1;
     }
-    for (i = 0; i < n; i++) {
-        ScalarVariable* sv = getScalarVariable(fmu->modelDescription ,i);
-        if (vr == getValueReference(sv) && tp == getElementType(getTypeSpec(sv))) {
-            return sv;
-        }
-    }
-    return NULL;
+    return findVariableRow(fmu->variables, vr, tp);
 }
 
 // replace e.g. #r1365# by variable name and ## by # in message
@@ -580,8 +1385,8 @@ static void replaceRefsInMessage(const char* msg, char* buffer, int nBuffer, FMU
                 int nvr = sscanf(msg + i + 2, "%u", &vr);
                 if (nvr == 1) {
                     // vr of type detected, e.g. #r12#
-                    ScalarVariable* sv = getSV(fmu, type, vr);
-                    const char* name = sv ? getAttributeValue((Element *)sv, att_name) : "?";
+                    int row = getSV(fmu, type, vr);
+                    const char* name = row >= 0 ? getVariableName(fmu->variables, row) : "?";
                     sprintf(buffer + k, "%s", name);
                     k += strlen(name);
                     i += (n+1);
@@ -627,8 +1432,266 @@ int error(const char* message){
     return 0;
 }
 
+static void parseOption(const char *option);
+
+// true if the key of option is key
+static int isOption(const char *option, const char *key) {
+    size_t n = strlen(key);
+    return !strncmp(option, key, n) && option[n] == '=';
+}
+
+// add the patterns of the comma separated list to selectPatterns
+static void addSelectPatterns(const char *list) {
+    const char *p = list;
+    for (;;) {
+        const char *end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        char **patterns = (char **)realloc(selectPatterns, (nSelectPatterns + 1) * sizeof(char *));
+        char *pattern = (char *)malloc(n + 1);
+        if (!patterns || !pattern) {
+            printf("out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(pattern, p, n);
+        pattern[n] = 0;
+        selectPatterns = patterns;
+        selectPatterns[nSelectPatterns++] = pattern;
+        if (!end) break;
+        p = end + 1;
+    }
+}
+
+// the number of value, a number or pattern=number, and its pattern, NULL if none.
+// The number must be >= 0 if nonNegative.
+static double parsePatternNumber(const char *value, char **pattern, const char *what, int nonNegative) {
+    const char *number = strrchr(value, '=');
+    char *end;
+    double d;
+    number = number ? number + 1 : value;
+    d = strtod(number, &end);
+    if (end == number || *end || (nonNegative && !(d >= 0))) {
+        printf("error: The given %s (%s) is not a number%s\n", what, number, nonNegative ? " >= 0" : "");
+        exit(EXIT_FAILURE);
+    }
+    *pattern = NULL;
+    if (number != value) {
+        size_t n = (size_t)(number - 1 - value);
+        *pattern = (char *)malloc(n + 1);
+        if (!*pattern) {
+            printf("out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(*pattern, value, n);
+        (*pattern)[n] = 0;
+    }
+    return d;
+}
+
+// add value, a tolerance or pattern=tolerance, to toleranceOptions
+static void addToleranceOption(const char *value, int relative) {
+    ToleranceOption *options = (ToleranceOption *)realloc(toleranceOptions,
+                                                          (nToleranceOptions + 1) * sizeof(ToleranceOption));
+    ToleranceOption *option;
+    if (!options) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    toleranceOptions = options;
+    option = &toleranceOptions[nToleranceOptions];
+    option->tolerance = parsePatternNumber(value, &option->pattern, "tolerance", 1);
+    option->relative = relative;
+    nToleranceOptions++;
+}
+
+// add value, a threshold or pattern=threshold, to thresholdOptions
+static void addThresholdOption(const char *value) {
+    ThresholdOption *options = (ThresholdOption *)realloc(thresholdOptions,
+                                                          (nThresholdOptions + 1) * sizeof(ThresholdOption));
+    ThresholdOption *option;
+    if (!options) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    thresholdOptions = options;
+    option = &thresholdOptions[nThresholdOptions];
+    option->threshold = parsePatternNumber(value, &option->pattern, "threshold", 0);
+    nThresholdOptions++;
+}
+
+// the bits 1 << Enu of the comma separated list of n names, e.g. of causalities
+static unsigned int parseEnuList(const char *list, const EnuName *names, size_t n, const char *what) {
+    unsigned int bits = 0;
+    const char *p = list;
+    for (;;) {
+        const char *end = strchr(p, ',');
+        size_t length = end ? (size_t)(end - p) : strlen(p);
+        size_t i;
+        for (i = 0; i < n; i++) {
+            if (strlen(names[i].name) == length && !strncmp(names[i].name, p, length)) break;
+        }
+        if (i == n) {
+            printf("error: The given %s (%.*s) is not valid\n", what, (int)length, p);
+            exit(EXIT_FAILURE);
+        }
+        bits |= 1u << names[i].value;
+        if (!end) return bits;
+        p = end + 1;
+    }
+}
+
+// add value, an event name, a threshold or pattern=threshold, to triggerOptions
+static void addTriggerOption(const char *value) {
+    TriggerOption *options = (TriggerOption *)realloc(triggerOptions, (nTriggerOptions + 1) * sizeof(TriggerOption));
+    TriggerOption *option;
+    int i;
+    if (!options) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    triggerOptions = options;
+    option = &triggerOptions[nTriggerOptions];
+    option->pattern = NULL;
+    option->threshold = 0;
+    option->event = -1;
+    for (i = 0; i < (int)(sizeof(triggerEvents) / sizeof(triggerEvents[0])); i++) {
+        if (!strcmp(value, triggerEvents[i])) option->event = i;
+    }
+    if (option->event < 0) option->threshold = parsePatternNumber(value, &option->pattern, "trigger threshold", 0);
+    nTriggerOptions++;
+}
+
+// parse the options of file, one key=value per line, '#' starts a comment line
+static void parseConfigFile(const char *path) {
+    char line[BUFSIZE];
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("error: Could not read the config file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    while (fgets(line, sizeof(line), file)) {
+        char *p = line;
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r' || line[n - 1] == ' ')) line[--n] = 0;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p && *p != '#') parseOption(p);
+    }
+    fclose(file);
+}
+
+// set the option given as key=value with -o
+static void parseOption(const char *option) {
+    const char *value = strchr(option, '=');
+    if (!value) {
+        printf("error: The given option (%s) is not of the form key=value\n", option);
+        exit(EXIT_FAILURE);
+    }
+    value++;
+    if (isOption(option, "select")) {
+        addSelectPatterns(value);
+        return;
+    }
+    if (isOption(option, "causality")) {
+        recordedCausalities |= parseEnuList(value, causalities, sizeof(causalities) / sizeof(causalities[0]),
+                                            "causality");
+        return;
+    }
+    if (isOption(option, "variability")) {
+        recordedVariabilities |= parseEnuList(value, variabilities,
+                                              sizeof(variabilities) / sizeof(variabilities[0]), "variability");
+        return;
+    }
+    if (isOption(option, "interval")) {
+        char *end;
+        outputInterval = strtod(value, &end);
+        if (end == value || *end || !(outputInterval >= 0)) {
+            printf("error: The given output interval (%s) is not a number >= 0\n", value);
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+    if (isOption(option, "reltol") || isOption(option, "abstol")) {
+        addToleranceOption(value, isOption(option, "reltol"));
+        return;
+    }
+    if (isOption(option, "threshold")) {
+        addThresholdOption(value);
+        return;
+    }
+    if (isOption(option, "trigger")) {
+        addTriggerOption(value);
+        return;
+    }
+    if (isOption(option, "pretrigger") || isOption(option, "posttrigger")) {
+        char *end;
+        double seconds = strtod(value, &end);
+        if (end == value || *end || !(seconds >= 0)) {
+            printf("error: The given trigger window (%s) is not a number >= 0\n", value);
+            exit(EXIT_FAILURE);
+        }
+        if (isOption(option, "pretrigger")) preTrigger = seconds;
+        else postTrigger = seconds;
+        return;
+    }
+    if (isOption(option, "triggerlimit")) {
+        char *end;
+        triggerLimit = strtol(value, &end, 10);
+        if (end == value || *end || triggerLimit < 0) {
+            printf("error: The given trigger limit (%s) is not a number >= 0\n", value);
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+    if (isOption(option, "config")) {
+        parseConfigFile(value);
+        return;
+    }
+    if (isOption(option, "format")) {
+        if (!strcmp(value, "csv")) resultFormat = RESULT_CSV;
+        else if (!strcmp(value, "mat4")) resultFormat = RESULT_MAT4;
+        else if (!strcmp(value, "fmr")) resultFormat = RESULT_STORE;
+        else if (!strcmp(value, "summary")) resultFormat = RESULT_SUMMARY;
+        else {
+            printf("error: The given result format (%s) is not csv, mat4, fmr or summary\n", value);
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+    if (isOption(option, "pyramid")) {
+        if (!strcmp(value, "on")) writePyramid = 1;
+        else if (!strcmp(value, "off")) writePyramid = 0;
+        else {
+            printf("error: The given pyramid option (%s) is not on or off\n", value);
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+    printf("error: Unknown option (%s)\n", option);
+    exit(EXIT_FAILURE);
+}
+
 void parseArguments(int argc, char *argv[], const char **fmuFileName, double *tEnd, double *h,
                     int *loggingOn, char *csv_separator, int *nCategories, char **logCategories[]) {
+    // take the options -o key=value out, the other arguments are positional
+    char **args = (char **)calloc(argc + 1, sizeof(char *));
+    int i, n = 0;
+    if (!args) {
+        printf("out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < argc; i++) {
+        if (i > 0 && !strcmp(argv[i], "-o")) {
+            if (i + 1 == argc) {
+                printf("error: Option -o misses key=value\n");
+                exit(EXIT_FAILURE);
+            }
+            parseOption(argv[++i]);
+        } else {
+            args[n++] = argv[i];
+        }
+    }
+    argc = n;
+    argv = args;
+
     // parse command line arguments
     if (argc > 1) {
         *fmuFileName = argv[1];
@@ -667,13 +1730,14 @@ void parseArguments(int argc, char *argv[], const char **fmuFileName, double *tE
         }
     }
     if (argc > 6) {
-        int i;
         *nCategories = argc - 6;
         *logCategories = (char **)calloc(sizeof(char *), *nCategories);
         for (i = 0; i < *nCategories; i++) {
             (*logCategories)[i] = argv[i + 6];
         }
     }
+    outputEnd = *tEnd;
+    free(args);
 }
 
 void printHelp(const char *fmusim) {
@@ -684,4 +1748,28 @@ void printHelp(const char *fmusim) {
     printf("   <loggingOn> .... 1 to activate logging,     optional, defaults to 0\n");
     printf("   <csv separator>. separator in csv file,     optional, c for ',', s for';', defaults to c\n");
     printf("   <logCategories>. list of active categories, optional, see modelDescription.xml for possible values\n");
+    printf("   -o format=mat4 . write result.mat in MAT v4 format instead of result.csv, optional,\n");
+    printf("                    may be given anywhere after <model.fmu>\n");
+    printf("   -o format=fmr .. write result.fmr, a compressed columnar store, see fmuresult\n");
+    printf("   -o format=summary write summary.csv, min, max, mean, variance, integral and final\n");
+    printf("                    value of each variable, instead of its values at each step\n");
+    printf("   -o threshold=<value> count the crossings of value in the summary, or, given as\n");
+    printf("                    threshold=<pattern>=<value>, by the variables matching the pattern\n");
+    printf("   -o select=<patterns> record only variables with names matching one of the comma\n");
+    printf("                    separated patterns, '*' matches any chars, '?' one, e.g. plant.motor.*\n");
+    printf("   -o causality=<list> record only variables of the given causalities, e.g. input,output\n");
+    printf("   -o variability=<list> record only variables of the given variabilities, e.g. continuous\n");
+    printf("   -o interval=<dt> output a row every dt instead of at every step h\n");
+    printf("   -o reltol=<tol>  leave out rows that linear interpolation restores within tol\n");
+    printf("                    times the nominal value of each Real variable, or, given as\n");
+    printf("                    reltol=<pattern>=<tol>, of the variables matching the pattern\n");
+    printf("   -o abstol=<tol>  as reltol, with an absolute tolerance\n");
+    printf("   -o trigger=<trigger> write only the rows around triggers: timeEvent, stateEvent,\n");
+    printf("                    stepEvent, or a threshold crossed by any variable, or, given as\n");
+    printf("                    trigger=<pattern>=<value>, by the variables matching the pattern\n");
+    printf("   -o pretrigger=<s> seconds recorded before a trigger, defaults to 1\n");
+    printf("   -o posttrigger=<s> seconds recorded after a trigger, defaults to 1\n");
+    printf("   -o triggerlimit=<n> record at most n windows around triggers, defaults to no limit\n");
+    printf("   -o pyramid=on .. write result.fmp, min, max and mean at coarser resolutions, see fmuresult\n");
+    printf("   -o config=<file> read options from file, one key=value per line\n");
 }
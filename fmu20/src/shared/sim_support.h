@@ -16,10 +16,21 @@
 #define UNZIP_CMD "unzip -o -d "
 #endif /* WINDOWS */
 
+#include "result_writer.h"
+
 #define XML_FILE  "modelDescription.xml"
 #define RESULT_FILE "result.csv"
+#define RESULT_MAT_FILE "result.mat"
+#define RESULT_STORE_FILE "result.fmr"
+#define RESULT_PYRAMID_FILE "result.fmp"
+#define RESULT_SUMMARY_FILE "summary.csv"
 #define BUFSIZE 4096
 
+// events of the simulation that can trigger the recording of rows, see outputEvent()
+#define OUTPUT_TIME_EVENT  0
+#define OUTPUT_STATE_EVENT 1
+#define OUTPUT_STEP_EVENT  2
+
 #if WINDOWS
 #ifdef _WIN64
 #define DLL_DIR   "binaries\\win64\\"
@@ -60,12 +71,19 @@
 
 void fmuLogger(fmi2Component c, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...);
 int unzip(const char *zipPath, const char *outPath);
+int unzipWithTool(const char *zipPath, const char *outPath);
 void parseArguments(int argc, char *argv[], const char **fmuFileName, double *tEnd, double *h,
                     int *loggingOn, char *csv_separator, int *nCategories, char **logCategories[]);
 void loadFMU(const char *fmuFileName);
-int checkFmiVersion(const char *xmlPath);
 void deleteUnzippedFiles();
+OutputPlan *compileOutputPlan(VariableTable *vt); // returns NULL if out of memory
+void freeOutputPlan(OutputPlan *plan);
+FILE *openResultFile(); // in the format given by -o format=, NULL on error
+const char *getResultFileName();
+const char *getResultFormatName(); // "CSV", "MAT", "FMR" or "summary"
 void outputRow(FMU *fmu, fmi2Component c, double time, FILE* file, char separator, fmi2Boolean header);
+void outputEvent(int event); // an OUTPUT_..._EVENT happened since the row output last
+void finishOutput(FMU *fmu);
 int error(const char *message);
 void printHelp(const char *fmusim);
 char *getTempResourcesLocation(); // caller has to free the result
@@ -0,0 +1,66 @@
+/* -------------------------------------------------------------------------
+ * zip_reader.h
+ * In-process reader for the ZIP archives used as FMU container.
+ * The archive is memory mapped, the central directory is read once and
+ * entries are inflated on demand, either to disk or straight to memory.
+ * Supports the stored and deflate methods and ZIP64 archives.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#ifndef ZIP_READER_H
+#define ZIP_READER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// compression methods supported by the reader
+#define ZIP_METHOD_STORED  0
+#define ZIP_METHOD_DEFLATE 8
+
+typedef struct {
+    char *name;                          // entry name as stored in the archive, e.g. "binaries/linux64/a.so"
+    int method;                          // ZIP_METHOD_STORED or ZIP_METHOD_DEFLATE
+    int flags;                           // general purpose bit flags
+    unsigned long crc32;                 // crc of the uncompressed data
+    unsigned long long compressedSize;
+    unsigned long long size;             // uncompressed size
+    unsigned long long localHeaderOffset;
+} ZipEntry;
+
+typedef struct ZipArchive ZipArchive;
+
+// Returns NULL to indicate failure.
+// The receiver must call zipClose() to unmap the archive.
+ZipArchive *zipOpen(const char *zipPath);
+void zipClose(ZipArchive *za);
+
+// number of entries in the central directory, including directories
+int zipGetEntryCount(ZipArchive *za);
+// entry at index, NULL if index is out of range
+const ZipEntry *zipGetEntry(ZipArchive *za, int index);
+// entry by name, NULL if not found
+const ZipEntry *zipFindEntry(ZipArchive *za, const char *name);
+
+// Inflates the entry into a buffer allocated with malloc, which the receiver must free.
+// The buffer holds entry->size bytes and a terminating '\0' that is not counted in size.
+// Returns NULL to indicate failure.
+void *zipExtractToMemory(ZipArchive *za, const ZipEntry *entry, size_t *size);
+// Inflates the entry into the file at path. Parent directories must exist.
+// Returns 0 to indicate failure.
+int zipExtractToFile(ZipArchive *za, const ZipEntry *entry, const char *path);
+// Extracts all entries below outDir, which must end with a path separator.
+// Missing directories are created. Returns 0 to indicate failure.
+int zipExtractAll(ZipArchive *za, const char *outDir);
+// Extracts the entries whose name starts with prefix, e.g. "resources/", below outDir.
+// outDir is not created if no entry matches.
+int zipExtractDir(ZipArchive *za, const char *prefix, const char *outDir);
+// Extracts a single entry below outDir, e.g. to outDir/binaries/linux64/a.so
+int zipExtractEntry(ZipArchive *za, const ZipEntry *entry, const char *outDir);
+
+#ifdef __cplusplus
+} // closing brace for extern "C"
+#endif
+#endif // ZIP_READER_H
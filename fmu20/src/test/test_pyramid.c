@@ -0,0 +1,142 @@
+/* -------------------------------------------------------------------------
+ * test_pyramid.c
+ * Checks the envelope read from a result pyramid against the rows it was
+ * written from: over the whole run, where each interval holds several bins,
+ * and zoomed in below one bin of level 0 per interval, where each interval
+ * must get the bins whose time overlaps it.
+ * Command syntax: test_pyramid
+ * Writes test_pyramid.fmp to the current directory and removes it at the
+ * end. Prints each failed check and returns EXIT_FAILURE if any failed.
+ * Copyright QTronic GmbH. All rights reserved.
+ * -------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "result_pyramid.h"
+
+#define PYRAMID_PATH "test_pyramid.fmp"
+// rows of the run, row i at time i * STEP with value i. STEP is exact in
+// binary, so that rows fall on the start of intervals
+#define ROWS 1000
+#define STEP 0.125
+#define BIN_ROWS 64  // rows per bin of level 0
+#define MAX_PIXELS 64
+
+static int failures = 0;
+
+static void check(int ok, const char *what, double start, double end, int pixel) {
+    if (ok) return;
+    printf("failed: %s in interval %d of %g to %g\n", what, pixel, start, end);
+    failures++;
+}
+
+// Returns 0 if the pyramid could not be written
+static int writePyramid() {
+    FILE *file = fopen(PYRAMID_PATH, "wb");
+    PyramidWriter *w;
+    int ok;
+    int i;
+    if (!file) return 0;
+    w = openPyramidWriter(file, 1, 0, 0);
+    ok = w && addPyramidSignal(w, "x", 1);
+    for (i = 0; ok && i < ROWS; i++) {
+        double x = i;
+        ok = appendPyramidRow(w, i * STEP, &x, NULL, NULL);
+    }
+    if (w && !closePyramidWriter(w)) ok = 0;
+    if (fclose(file)) ok = 0;
+    return ok;
+}
+
+// Reads the envelope of x. Returns 0 if it could not be read
+static int readEnvelope(ResultPyramid *rp, double start, double end, int nPixels,
+                        double *min, double *max, double *mean) {
+    if (readPyramidEnvelope(rp, findPyramidSignal(rp, "x"), start, end, nPixels, min, max, mean)) return 1;
+    printf("failed: could not read the envelope of %g to %g\n", start, end);
+    failures++;
+    return 0;
+}
+
+// Checks that each interval of start to end holds the values of its rows,
+// with the mean in between
+static void checkRows(ResultPyramid *rp, double start, double end, int nPixels) {
+    double min[MAX_PIXELS], max[MAX_PIXELS], mean[MAX_PIXELS];
+    double width = (end - start) / nPixels;
+    int i;
+    if (!readEnvelope(rp, start, end, nPixels, min, max, mean)) return;
+    for (i = 0; i < ROWS; i++) {
+        double time = i * STEP;
+        int pixel = (int)((time - start) / width);
+        if (time < start || time > end) continue;
+        if (pixel == nPixels) pixel--;
+        check(min[pixel] <= i && max[pixel] >= i, "row outside of min and max", start, end, pixel);
+    }
+    for (i = 0; i < nPixels; i++) {
+        check(min[i] <= mean[i] && mean[i] <= max[i], "mean outside of min and max", start, end, i);
+    }
+}
+
+// Checks that each interval of start to end has min and max of the bins of
+// level 0 whose time from first to last row overlaps it, or NaN if there
+// are none, and the mean of the bin if there is one
+static void checkBins(ResultPyramid *rp, double start, double end, int nPixels) {
+    double min[MAX_PIXELS], max[MAX_PIXELS], mean[MAX_PIXELS];
+    double width = (end - start) / nPixels;
+    int i;
+    if (!readEnvelope(rp, start, end, nPixels, min, max, mean)) return;
+    for (i = 0; i < nPixels; i++) {
+        double from = start + i * width;
+        double to = i + 1 < nPixels ? from + width : end;
+        double expectedMin = HUGE_VAL, expectedMax = -HUGE_VAL, expectedMean = NAN;
+        int bins = 0;
+        int first;
+        for (first = 0; first < ROWS; first += BIN_ROWS) {
+            int last = first + BIN_ROWS < ROWS ? first + BIN_ROWS - 1 : ROWS - 1;
+            if (last * STEP < from || first * STEP > to || (first * STEP == to && i + 1 < nPixels)) continue;
+            if (first < expectedMin) expectedMin = first;
+            if (last > expectedMax) expectedMax = last;
+            expectedMean = (first + last) / 2.0;
+            bins++;
+        }
+        if (!bins) {
+            check(isnan(min[i]) && isnan(max[i]) && isnan(mean[i]), "values without bins", start, end, i);
+            continue;
+        }
+        check(min[i] == expectedMin, "min not that of the bins", start, end, i);
+        check(max[i] == expectedMax, "max not that of the bins", start, end, i);
+        if (bins == 1) check(fabs(mean[i] - expectedMean) < 1e-9, "mean not that of the bin", start, end, i);
+    }
+}
+
+int main() {
+    ResultPyramid *rp;
+    if (!writePyramid()) {
+        printf("error: could not write %s\n", PYRAMID_PATH);
+        remove(PYRAMID_PATH);
+        return EXIT_FAILURE;
+    }
+    rp = openResultPyramid(PYRAMID_PATH);
+    if (!rp) {
+        printf("error: could not read %s\n", PYRAMID_PATH);
+        remove(PYRAMID_PATH);
+        return EXIT_FAILURE;
+    }
+    checkRows(rp, 0, (ROWS - 1) * STEP, 3);
+    checkRows(rp, 0, (ROWS - 1) * STEP, 10);
+    checkRows(rp, 20, 100, 7);
+    // within the second bin, 2 intervals per row
+    checkBins(rp, 9, 13, 64);
+    // from the second to the third bin, across the step between them
+    checkBins(rp, 14, 18, 64);
+    // around the end of the run, into the last bin, which is not full
+    checkBins(rp, 118, 126, 64);
+    closeResultPyramid(rp);
+    remove(PYRAMID_PATH);
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}